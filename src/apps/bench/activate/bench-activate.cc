@@ -16,11 +16,13 @@
  */
 
 #include <base/Common.h>
+#include <base/stream/IStringStream.h>
 #include <base/util/Profile.h>
 
 #include <m3/com/MemGate.h>
 #include <m3/stream/Standard.h>
 #include <m3/Syscalls.h>
+#include <m3/VPE.h>
 
 using namespace m3;
 
@@ -28,8 +30,19 @@ using namespace m3;
 
 static word_t buffer[4];
 
-int main() {
+int main(int argc, char **argv) {
+    // optionally fill the cap table first to see how the kernel's lookups scale
+    uint caps = 0;
+    if(argc > 1)
+        caps = IStringStream::read_from<uint>(argv[1]);
+
     MemGate mem = MemGate::create_global(0x1000, MemGate::RW);
+    capsel_t sels = caps ? VPE::self().alloc_caps(caps) : 0;
+    for(uint i = 0; i < caps; ++i) {
+        if(Syscalls::get().derivemem(mem.sel(), sels + i, 0, 0x1000, MemGate::RW) != Errors::NO_ERROR)
+            exitmsg("Deriving capability " << i << " failed");
+    }
+
     mem.read_sync(buffer, sizeof(buffer), 0);
     cycles_t total = 0;
     for(int i = 0; i < COUNT; ++i) {
@@ -39,5 +52,20 @@ int main() {
         total += end - start;
     }
     cout << "Per activate: " << (total / COUNT) << "\n";
+
+    if(caps) {
+        // activate the cap with the highest selector
+        total = 0;
+        for(int i = 0; i < COUNT; ++i) {
+            cycles_t start = Profile::start(1);
+            Syscalls::get().activate(mem.epid(), mem.sel(), sels + caps - 1);
+            cycles_t end = Profile::stop(1);
+            total += end - start;
+        }
+        cout << "Per activate (" << caps << " caps): " << (total / COUNT) << "\n";
+
+        Syscalls::get().revoke(CapRngDesc(CapRngDesc::OBJ, sels, caps));
+        VPE::self().free_caps(sels, caps);
+    }
     return 0;
 }
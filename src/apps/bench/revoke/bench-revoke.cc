@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/Common.h>
+#include <base/stream/IStringStream.h>
+#include <base/util/Profile.h>
+
+#include <string.h>
+
+#include <m3/com/MemGate.h>
+#include <m3/stream/Standard.h>
+#include <m3/Revoker.h>
+#include <m3/Syscalls.h>
+#include <m3/VPE.h>
+
+using namespace m3;
+
+#define COUNT       4
+#define CHAIN_LEN   10000
+#define MEM_SIZE    64
+
+static void derive_chain(MemGate &mem, capsel_t sels, uint len) {
+    // every capability is derived from the previous one, so that the kernel has to walk
+    // down a tree of depth <len>
+    capsel_t parent = mem.sel();
+    for(uint j = 0; j < len; ++j) {
+        Errors::Code res = Syscalls::get().derivemem(parent, sels + j, 0, MEM_SIZE, MemGate::RW);
+        if(res != Errors::NO_ERROR)
+            exitmsg("Deriving capability " << j << " failed");
+        parent = sels + j;
+    }
+}
+
+static void revoke_async(MemGate &mem, uint len) {
+    capsel_t sels = VPE::self().alloc_caps(len * COUNT);
+    for(int i = 0; i < COUNT; ++i)
+        derive_chain(mem, sels + i * len, len);
+
+    // issue all revokes at once and wait for them afterwards
+    Revoker rev;
+    cycles_t start = Profile::start(0);
+    for(int i = 0; i < COUNT; ++i)
+        rev.revoke(CapRngDesc(CapRngDesc::OBJ, sels + i * len, 1));
+    cycles_t issued = Profile::stop(0);
+    rev.wait();
+    cycles_t end = Profile::stop(0);
+
+    cout << "Issued " << COUNT << " revokes in " << (issued - start) << " cycles\n";
+    cout << "Per revoke: " << ((end - start) / COUNT) << " cycles\n";
+    cout << "Per cap: " << ((end - start) / (COUNT * len)) << " cycles\n";
+    VPE::self().free_caps(sels, len * COUNT);
+}
+
+int main(int argc, char **argv) {
+    uint len = CHAIN_LEN;
+    if(argc > 1)
+        len = IStringStream::read_from<uint>(argv[1]);
+
+    MemGate mem = MemGate::create_global(MEM_SIZE, MemGate::RW);
+    if(argc > 2 && strcmp(argv[2], "async") == 0) {
+        cout << "Revoking chains of " << len << " capabilities asynchronously...\n";
+        revoke_async(mem, len);
+        return 0;
+    }
+
+    capsel_t sels = VPE::self().alloc_caps(len);
+
+    cout << "Revoking chains of " << len << " capabilities...\n";
+    cycles_t total = 0;
+    for(int i = 0; i < COUNT; ++i) {
+        derive_chain(mem, sels, len);
+
+        cycles_t start = Profile::start(0);
+        Syscalls::get().revoke(CapRngDesc(CapRngDesc::OBJ, sels, 1));
+        cycles_t end = Profile::stop(0);
+        total += end - start;
+        cout << "Run " << i << ": " << (end - start) << " cycles, "
+             << ((end - start) / len) << " cycles per cap\n";
+    }
+
+    cout << "Per revoke: " << (total / COUNT) << " cycles\n";
+    cout << "Per cap: " << (total / (COUNT * len)) << " cycles\n";
+    VPE::self().free_caps(sels, len);
+    return 0;
+}
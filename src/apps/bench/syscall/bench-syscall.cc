@@ -21,10 +21,32 @@
 #include <m3/com/MemGate.h>
 #include <m3/stream/Standard.h>
 #include <m3/Syscalls.h>
+#include <m3/SyscallRing.h>
 
 using namespace m3;
 
 #define COUNT   100
+#define RUNS    8
+
+static cycles_t ring_noops(SyscallRing &ring) {
+    cycles_t start = Profile::start(1);
+    for(size_t i = 0; i < ring.slots(); ++i)
+        ring.noop(i);
+    ring.enter();
+    cycles_t end = Profile::stop(1);
+
+    word_t tag;
+    Errors::Code res;
+    size_t completed = 0;
+    while(ring.fetch(&tag, &res)) {
+        if(res != Errors::NO_ERROR || tag != completed)
+            exitmsg("Syscall " << tag << " failed: " << res);
+        completed++;
+    }
+    if(completed != ring.slots())
+        exitmsg("Only " << completed << " of " << ring.slots() << " syscalls completed");
+    return end - start;
+}
 
 int main() {
     cycles_t total = 0;
@@ -36,5 +58,15 @@ int main() {
         total += end - start;
     }
     cout << "Per syscall: " << (total / COUNT) << "\n";
+
+    // the same via a syscall ring, which needs one message per ring
+    SyscallRing ring;
+    if(Errors::last != Errors::NO_ERROR)
+        exitmsg("Unable to set up syscall ring");
+    total = 0;
+    for(int i = 0; i < RUNS; ++i)
+        total += ring_noops(ring);
+    cout << "Per syscall with ring (" << ring.slots() << " slots): "
+         << (total / (RUNS * ring.slots())) << "\n";
     return 0;
 }
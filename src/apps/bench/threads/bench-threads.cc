@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/Common.h>
+#include <base/util/Profile.h>
+
+#include <m3/stream/Standard.h>
+
+#include <thread/ThreadManager.h>
+
+using namespace m3;
+
+#define THREADS     1000
+#define RUNS        100
+
+static int events[THREADS];
+static int all_event;
+static int main_event;
+static size_t started;
+static size_t wakeups;
+
+static void worker(void *arg) {
+    ThreadManager &tm = ThreadManager::get();
+    size_t idx = reinterpret_cast<uintptr_t>(arg);
+    void *evs[] = {events + idx, &all_event};
+
+    if(++started == THREADS)
+        tm.notify(&main_event);
+    // every thread waits for its own event and the one for all
+    while(1) {
+        tm.wait_for_any(evs, ARRAY_SIZE(evs));
+        wakeups++;
+    }
+}
+
+int main() {
+    ThreadManager &tm = ThreadManager::get();
+    cout << "Starting " << THREADS << " threads...\n";
+    for(uintptr_t i = 0; i < THREADS; ++i)
+        new Thread(worker, reinterpret_cast<void*>(i));
+    // let all threads block
+    tm.wait_for(&main_event);
+    if(tm.blocked_count() != THREADS)
+        exitmsg("Only " << tm.blocked_count() << " threads blocked");
+
+    // wake up a single thread among all blocked ones
+    cycles_t total = 0;
+    for(int i = 0; i < RUNS; ++i) {
+        cycles_t start = Profile::start(0);
+        tm.notify(events + (i * 7919) % THREADS);
+        cycles_t end = Profile::stop(0);
+        total += end - start;
+        // the woken thread blocks again and switches back to us
+        tm.yield();
+    }
+    if(wakeups != RUNS)
+        exitmsg("Expected " << RUNS << " wakeups, got " << wakeups);
+    cout << "Per notify with " << THREADS << " blocked threads: " << (total / RUNS) << "\n";
+
+    // wake up all threads at once
+    wakeups = 0;
+    total = 0;
+    for(int i = 0; i < RUNS / 10; ++i) {
+        cycles_t start = Profile::start(1);
+        tm.notify(&all_event);
+        cycles_t end = Profile::stop(1);
+        total += end - start;
+        tm.yield();
+    }
+    if(wakeups != (RUNS / 10) * THREADS)
+        exitmsg("Expected " << (RUNS / 10) * THREADS << " wakeups, got " << wakeups);
+    cout << "Per woken thread with notify of all: " << (total / ((RUNS / 10) * THREADS)) << "\n";
+    return 0;
+}
@@ -24,6 +24,7 @@
 #include <m3/vfs/Executable.h>
 #include <m3/vfs/File.h>
 #include <m3/vfs/VFS.h>
+#include <m3/Syscalls.h>
 #include <m3/VPE.h>
 
 using namespace m3;
@@ -48,6 +49,27 @@ int main() {
 
     exec_time = 0;
 
+    {
+        // keep the VPEs alive, so that the kernel has to skip the used PEs each time
+        capsel_t sels = VPE::self().alloc_caps(COUNT * 2);
+        for(int i = 0; i < COUNT; ++i) {
+            PEDesc pe = VPE::self().pe();
+            cycles_t start = Profile::start(4);
+            Errors::Code res = Syscalls::get().createvpe(sels + i * 2, sels + i * 2 + 1, "hello", pe,
+                ObjCap::INVALID, 0);
+            cycles_t end = Profile::stop(4);
+            if(res != Errors::NO_ERROR)
+                exitmsg("createvpe failed");
+            exec_time += end - start;
+        }
+        Syscalls::get().revoke(CapRngDesc(CapRngDesc::OBJ, sels, COUNT * 2));
+        VPE::self().free_caps(sels, COUNT * 2);
+    }
+
+    cout << "Time for createvpe: " << (exec_time / COUNT) << " cycles\n";
+
+    exec_time = 0;
+
     {
         for(int i = 0; i < COUNT; ++i) {
             VPE vpe("hello");
@@ -20,8 +20,11 @@
 #include <base/util/Profile.h>
 #include <base/benchmark/capbench.h>
 
+#include <string.h>
+
 #include <m3/session/Session.h>
 #include <m3/stream/Standard.h>
+#include <m3/Syscalls.h>
 #include <m3/VPE.h>
 
 #include "../operations.h"
@@ -35,11 +38,13 @@ using namespace m3;
 
 int main(int argc, char *argv[]) {
     if(argc < 2) {
-        cout << "Usage: " << argv[0] << " <numCaps>\n";
+        cout << "Usage: " << argv[0] << " <numCaps> [shared]\n";
         return 1;
     }
     int numcaps = IStringStream::read_from<int>(argv[1]);
-    CAPLOG("capbench-client [numcaps=" << numcaps << "]");
+    // with a shared server cap, we revoke our copies ourself, which removes them from its children
+    bool shared = argc > 2 && strcmp(argv[2], "shared") == 0;
+    CAPLOG("capbench-client [numcaps=" << numcaps << ", shared=" << shared << "]");
 
     cycles_t *obtainTime = new cycles_t[numcaps];
     cycles_t *revokeTime = new cycles_t[numcaps];
@@ -78,7 +83,10 @@ int main(int argc, char *argv[]) {
     // revoke caps
     for(int i = 0; i < numcaps; ++i) {
         start = m3::Profile::start(5);
-        sess->revcap(caps[i]);
+        if(shared)
+            Syscalls::get().revoke(caps[i]);
+        else
+            sess->revcap(caps[i]);
         time = m3::Profile::stop(6) - start;
         CAPLOGV(" successfully revoked in " << time << " cycles");
         revokeTime[i] = time;
@@ -20,6 +20,8 @@
 #include <base/util/Profile.h>
 #include <base/benchmark/capbench.h>
 
+#include <string.h>
+
 #include <m3/server/Server.h>
 #include <m3/server/RequestHandler.h>
 #include <m3/stream/Standard.h>
@@ -50,9 +52,9 @@ using reqhandler_t = RequestHandler<
 
 class CapHandler : public reqhandler_t {
 public:
-    CapHandler(int numcaps) : reqhandler_t(), _count(), _handedOut(0),
+    CapHandler(int numcaps, bool shared) : reqhandler_t(), _count(), _handedOut(0),
         _caps(m3::CapRngDesc::OBJ, VPE::self().alloc_caps(numcaps), numcaps),
-        _numcaps(numcaps), _revokeTime(new cycles_t[numcaps]), _revokes(0) {
+        _numcaps(numcaps), _shared(shared), _revokeTime(new cycles_t[numcaps]), _revokes(0) {
         for(int i = 0; i < _numcaps; i++)
             new MemGate(MemGate::create_global(8, MemGate::RW, _caps.start() + i));
         add_operation(CapServerSession::CapOperation::REVCAP, &CapHandler::revcap);
@@ -91,8 +93,9 @@ public:
         }
 
         assert(static_cast<int>(sess->obtainPtr) < _numcaps);
+        // in shared mode, all clients get the first cap, which gets thousands of children
         sess->caps[sess->obtainPtr] = CapRngDesc(m3::CapRngDesc::OBJ,
-            _caps.start() + _handedOut, capcount);
+            _caps.start() + (_shared ? 0 : _handedOut), capcount);
         _handedOut += capcount;
         CAPLOGV("Handing out caps: " << sess->caps[sess->obtainPtr]);
         reply_vmsg(args, Errors::NO_ERROR, sess->caps[sess->obtainPtr++]);
@@ -105,6 +108,12 @@ public:
     }
     virtual void handle_shutdown() override {
         CAPLOGV("Kernel wants to shut down.");
+        run = false;
+        // in shared mode, the clients revoke their caps themselves
+        if(_shared) {
+            CAPLOG("Handed out the shared cap " << _handedOut << " times");
+            return;
+        }
         cycles_t avgRevokeTime = 0;
         cycles_t varianceRevoke = 0;
         CAPLOG("Warming up revoke: " << _revokeTime[0]);
@@ -124,7 +133,6 @@ public:
         CAPLOGV("Revokes handled: " << _revokes);
         CAPLOG("Avg. server revoke time: " << avgRevokeTime);
         CAPLOG("Variance revoke: " << varianceRevoke);
-        run = false;
     }
 
 private:
@@ -136,6 +144,7 @@ private:
     int _handedOut;
     CapRngDesc _caps;
     int _numcaps;
+    bool _shared;
     cycles_t *_revokeTime;
     uint _revokes;
 };
@@ -143,12 +152,13 @@ private:
 int main(int argc, char *argv[]) {
     for(int i = 0; run && i < 10; ++i) {
         if(argc < 2) {
-            cout << "Usage: " << argv[0] << " <numCaps>\n";
+            cout << "Usage: " << argv[0] << " <numCaps> [shared]\n";
             return 1;
         }
         int numcaps = IStringStream::read_from<int>(argv[1]);
-        CAPLOG("capbench-server [numcaps=" << numcaps << "]");
-        CapHandler hdl(numcaps);
+        bool shared = argc > 2 && strcmp(argv[2], "shared") == 0;
+        CAPLOG("capbench-server [numcaps=" << numcaps << ", shared=" << shared << "]");
+        CapHandler hdl(numcaps, shared);
         srv = new Server<CapHandler>("capbench-server", &hdl, nextlog2<4096>::val, nextlog2<128>::val);
         if(Errors::occurred())
             break;
@@ -15,7 +15,13 @@
  */
 
 #include <base/log/Kernel.h>
+#include <base/stream/IStringStream.h>
+#include <base/stream/OStringStream.h>
+#include <base/util/Profile.h>
 #include <base/util/Util.h>
+#include <thread/ThreadManager.h>
+
+#include <string.h>
 
 #include "Coordinator.h"
 #include "pes/KPE.h"
@@ -30,9 +36,12 @@ Coordinator* Coordinator::_inst;
 Coordinator::Coordinator(size_t kid, m3::String&& creatorBin, size_t creatorId, size_t creatorCore)
     : closingRequests(-1), shutdownIssued(false), shutdownRequests(0), startSignsAwaited(1),
     startSignSent(false), _kid(kid), _creator(new KPE(m3::Util::move(creatorBin), creatorId,
-    creatorCore, DTU::KRNLC_EP, Platform::creatorEp())) {
+    creatorCore, DTU::KRNLC_EP, Platform::creatorEp())), _kpes(), _startingKrnls(), _bootKrnls(),
+    _krnls(), _bootChildren(), _bootAlive(), _bootReady(), _bootConnects(1), _bootConnected(),
+    _bootReported() {
     _kpes.put(creatorId, _creator);
 #ifdef KERNEL_TESTS
+    _startingKernels = 0;
     _startup_done = true;
 #endif
 #ifndef SYNC_APP_START
@@ -43,8 +52,11 @@ Coordinator::Coordinator(size_t kid, m3::String&& creatorBin, size_t creatorId,
 
 Coordinator::Coordinator(size_t kid)
     : closingRequests(-1), shutdownIssued(false), shutdownRequests(0), startSignsAwaited(0),
-    startSignSent(false), _kid(kid), _creator(nullptr) {
+    startSignSent(false), _kid(kid), _creator(nullptr), _kpes(), _startingKrnls(), _bootKrnls(),
+    _krnls(), _bootChildren(), _bootAlive(), _bootReady(), _bootConnects(), _bootConnected(),
+    _bootReported() {
 #ifdef KERNEL_TESTS
+    _startingKernels = 0;
     _startup_done = false;
 #endif
 #ifndef SYNC_APP_START
@@ -60,87 +72,328 @@ bool Coordinator::isKPE(size_t pe_id) const {
     return false;
 }
 
-void Coordinator::startKrnl(int argc, char* argv[], m3::String&& binary, size_t id,
-    size_t core, unsigned int numPEs) {
-    KLOG(KPES, "Starting kernel (binary=" << binary << ", argc=" << argc << ", id=" <<
-        id << ", core=" << core << ", numPEs=" << numPEs << ")");
+void Coordinator::addBootKrnl(size_t id, unsigned int numPEs, int argc, char **argv) {
+    _bootKrnls.append(new BootKrnl(id, numPEs, argc, argv));
+}
+
+static int boot_arg(const char *arg, const char *name) {
+    size_t len = strlen(name);
+    if(strncmp(arg, name, len) != 0)
+        PANIC("Expected '" << name << "' in kernel specification, got '" << arg << "'");
+    m3::String str(arg + len);
+    m3::IStringStream is(str);
+    int val = -1;
+    is >> val;
+    return val;
+}
+
+int Coordinator::parseBootKrnls(int argc, char **argv) {
+    // the kernels are appended as "kernel id=<id> pes=<pes> args=<count>", followed by <count>
+    // arguments, starting with the kernel's binary
+    int i = 1;
+    while(i < argc && (strcmp(argv[i], "kernel") != 0 || i + 1 == argc ||
+            strncmp(argv[i + 1], "id=", sizeof("id=") - 1) != 0))
+        i++;
+
+    int own = i;
+    while(i < argc) {
+        if(i + 4 > argc || strcmp(argv[i], "kernel") != 0)
+            PANIC("Invalid kernel specification at argument " << i);
+        int id = boot_arg(argv[i + 1], "id=");
+        int pes = boot_arg(argv[i + 2], "pes=");
+        int count = boot_arg(argv[i + 3], "args=");
+        if(id <= static_cast<int>(_kid) || pes <= 0 || count <= 0 || i + 4 + count > argc)
+            PANIC("Invalid specification of kernel #" << id);
+        addBootKrnl(id, pes, count, argv + i + 4);
+        i += 4 + count;
+    }
+    return own;
+}
+
+char **Coordinator::bootArgs(const BootKrnl &krnl, int *argc) const {
+    // the kernel gets its own arguments and the specification of all kernels below it. the
+    // arguments have to be stored contiguously (see KPE::init_memory)
+    static const size_t NUM_SIZE = 24;
+    int count = krnl.argc;
+    size_t size = 0;
+    for(int i = 0; i < krnl.argc; ++i)
+        size += strlen(krnl.argv[i]) + 1;
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(k->id != krnl.id && inSubtree(k->id, krnl.id)) {
+            count += 4 + k->argc;
+            size += sizeof("kernel") + 3 * NUM_SIZE;
+            for(int i = 0; i < k->argc; ++i)
+                size += strlen(k->argv[i]) + 1;
+        }
+    }
+
+    char **argv = new char*[count];
+    char *buf = new char[size];
+    int arg = 0;
+    auto add = [&argv, &buf, &arg](const char *str) {
+        argv[arg++] = buf;
+        size_t len = strlen(str) + 1;
+        memcpy(buf, str, len);
+        buf += len;
+    };
+
+    for(int i = 0; i < krnl.argc; ++i)
+        add(krnl.argv[i]);
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(k->id != krnl.id && inSubtree(k->id, krnl.id)) {
+            char num[NUM_SIZE];
+            add("kernel");
+            m3::OStringStream id(num, sizeof(num));
+            id << "id=" << k->id;
+            add(id.str());
+            m3::OStringStream pes(num, sizeof(num));
+            pes << "pes=" << k->numPEs;
+            add(pes.str());
+            m3::OStringStream args(num, sizeof(num));
+            args << "args=" << k->argc;
+            add(args.str());
+            for(int i = 0; i < k->argc; ++i)
+                add(k->argv[i]);
+        }
+    }
+    assert(arg == count);
+    *argc = count;
+    return argv;
+}
+
+void Coordinator::startKrnl(BootKrnl &krnl) {
+    // the kernel gets the PEs of all kernels below it, which it hands on to them
+    unsigned int numPEs = 0;
+    size_t krnls = 0;
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(inSubtree(k->id, krnl.id)) {
+            numPEs += k->numPEs;
+            krnls++;
+        }
+    }
+
+    // position the kernel at the back of the free cores
+    PEManager &pemng = PEManager::get();
+    size_t core = pemng.free_compute_core_from_back(numPEs - 1);
+    if(core == Platform::MAX_PES)
+        PANIC("Not enough free compute cores to start kernel #" << krnl.id << " with " << numPEs << " PEs");
+
+    KLOG(KPES, "Starting kernel (binary=" << krnl.argv[0] << ", argc=" << krnl.argc << ", id=" <<
+        krnl.id << ", core=" << core << ", numPEs=" << numPEs << ", kernels=" << krnls << ")");
     DTU::get().set_vpeid(VPEDesc(core, VPE::INVALID_ID));
     DTU::get().suspend(VPEDesc(core, VPE::INVALID_ID));
     DTU::get().privilege(core);
 
-    int localEp = KernelcallHandler::get().reserve_ep(id);
+    int localEp = KernelcallHandler::get().reserve_ep(krnl.id);
     if(localEp == -1)
-        PANIC("No msg slots for kernel #" << id << " left");
+        PANIC("No msg slots for kernel #" << krnl.id << " left");
     KLOG(KPES, "Reserved EP " << localEp);
 
-    KPE* newkrnl = new KPE(m3::Util::move(binary), id, core, localEp, DTU::KRNLC_EP);
-    m3::PEDesc releasedPEs[numPEs];
-    releasedPEs[0] = Platform::pe_by_core(core);
-    PEManager::get()._vpes[core] = reinterpret_cast<VPE*>(1);
+    KPE* newkrnl = new KPE(m3::String(krnl.argv[0]), krnl.id, core, localEp, DTU::KRNLC_EP);
+    krnl.pes = new m3::PEDesc[numPEs];
+    krnl.pesCount = numPEs;
+    krnl.pes[0] = Platform::pe_by_core(core);
+    pemng.reserve(core, true);
     for(unsigned int i = 1; i < numPEs; i++) {
         // take the cores from the back of the free list
-        size_t freeCore = PEManager::get().free_compute_core_from_back(numPEs - i - 1);
+        size_t freeCore = pemng.free_compute_core_from_back(numPEs - i - 1);
         if(freeCore == Platform::MAX_PES)
-            PANIC("Not enough free compute cores to start kernel #" << id << " with " << numPEs << " PEs");
+            PANIC("Not enough free compute cores to start kernel #" << krnl.id << " with " << numPEs << " PEs");
         // mark the PE as "used"
-        PEManager::get()._vpes[freeCore] = reinterpret_cast<VPE*>(1);
-        releasedPEs[i] = Platform::pe_by_core(freeCore);
+        pemng.reserve(freeCore, true);
+        krnl.pes[i] = Platform::pe_by_core(freeCore);
     }
 
     // update the DDL's membership table to indicate that these PEs are migrating
-    MHTInstance::getInstance().updateMembership(releasedPEs, numPEs, id, core, MembershipFlags::MIGRATING, false);
-    newkrnl->start(argc, argv, numPEs, releasedPEs);
+    MHTInstance::getInstance().updateMembership(krnl.pes, numPEs, krnl.id, core, MembershipFlags::MIGRATING, false);
+
+    int argc;
+    char **argv = bootArgs(krnl, &argc);
+    newkrnl->start(argc, argv, numPEs, krnl.pes, krnls);
+    delete[] argv[0];
+    delete[] argv;
+
+    _krnls.put(krnl.id, core);
+    _startingKrnls.put(krnl.id, newkrnl);
+}
+
+KPE* Coordinator::publishKrnl(size_t id) {
+    KPE *krnl = _startingKrnls.get(id);
+    _startingKrnls.remove(id);
+    _kpes.put(id, krnl);
+    return krnl;
+}
+
+void Coordinator::bootKrnls() {
+    m3::ThreadManager &tmng = m3::ThreadManager::get();
+    size_t total = _bootKrnls.length();
+    if(total == 0)
+        return;
+
+    cycles_t start = m3::Profile::start(0xB007);
+    if(!_creator) {
 #ifdef SYNC_APP_START
-    startSignsAwaited++;
+        startSignsAwaited += total;
 #endif
 #ifdef KERNEL_TESTS
-    _startingKernels++;
+        _startingKernels += total;
 #endif
-    // yield and update status of PEs when resumed
-    // we are resumed by the SIGVITAL of the remote kernel
-    m3::ThreadManager &tmng = m3::ThreadManager::get();
-    int tid = tmng.current()->id();
-    tmng.wait_for(reinterpret_cast<void*>(tid));
-
-    if(*reinterpret_cast<const m3::Errors::Code*>(tmng.get_current_msg()) != m3::Errors::NO_ERROR)
-        PANIC("Error starting remote kernel #" << id << "! Error: " <<
-            m3::Errors::to_string(*reinterpret_cast<const m3::Errors::Code*>(tmng.get_current_msg())));
+    }
 
-    // send information about existing kernels
-    Kernelcalls::get().announceKrnls(newkrnl, _kid);
+    // start all our children at once; they start the kernels below them in the same way
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(bootParent(k->id) == _kid) {
+            startKrnl(*k);
+            _bootChildren++;
+        }
+    }
+    while(_bootAlive < _bootChildren)
+        tmng.wait_for(&_bootAlive);
 
-    tmng.wait_for(reinterpret_cast<void*>(tid));
+    // finish the migration of the PEs. the kernels below our children update the membership of
+    // their PEs when they connect to us
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(bootParent(k->id) != _kid)
+            continue;
 
-    if(*reinterpret_cast<const m3::Errors::Code*>(tmng.get_current_msg()) != m3::Errors::NO_ERROR)
-        PANIC("Error starting remote kernel #" << id << "! Error: " <<
-            m3::Errors::to_string(*reinterpret_cast<const m3::Errors::Code*>(tmng.get_current_msg())));
+        size_t core = k->pes[0].core_id();
+        MHTInstance::getInstance().updateMembership(k->pes, k->pesCount, k->id, core,
+            MembershipFlags::NONE, false);
+        // unmark PEs
+        for(unsigned int i = 1; i < k->pesCount; i++)
+            PEManager::get().reserve(k->pes[i].core_id(), false);
+        delete[] k->pes;
+        k->pes = nullptr;
 
-    // finish migration by updating the member table
-    MHTInstance::getInstance().updateMembership(releasedPEs, numPEs, id, core, MembershipFlags::NONE, false);
-    // unmark PEs
-    for(unsigned int i = 1; i < numPEs; i++)
-        PEManager::get()._vpes[releasedPEs[i].core_id()] = nullptr;
+        KPE *newkrnl = publishKrnl(k->id);
+        // send information about already existent services
+        ServiceList &srv = ServiceList::get();
+        for(auto s = srv.begin(); s != srv.end(); s++)
+            Kernelcalls::get().announceSrv(newkrnl, s->id(), s->name());
+    }
 
-    _kpes.put(id, newkrnl);
+    // the other kernels report to their creator now
+    if(_creator)
+        return;
 
-    // send information about already existent services
-    ServiceList &srv = ServiceList::get();
-    for(auto s = srv.begin(); s != srv.end(); s++)
-        Kernelcalls::get().announceSrv(newkrnl, s->id(), s->name());
+    cycles_t alive = m3::Profile::stop(0xB007) - start;
+    _krnls.put(_kid, Platform::kernel_pe());
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(bootParent(k->id) == _kid)
+            Kernelcalls::get().announceKrnls(getKPE(k->id));
+    }
+    while(_bootReady < _bootChildren)
+        tmng.wait_for(&_bootReady);
+    cycles_t ready = m3::Profile::stop(0xB007) - start;
 
+    KLOG(INFO, "Kernel # " << _kid << " boot: kernels= " << total << " fanout= " << KERNEL_BOOT_FANOUT
+        << " alive= " << alive << " ready= " << ready);
 
+    while(_bootKrnls.length() > 0)
+        delete _bootKrnls.remove_first();
 #ifdef KERNEL_TESTS
-    _startingKernels--;
-    if(_startup_done && !_startingKernels) {
+    _startingKernels -= total;
+    if(_startup_done && !_startingKernels)
         startTests();
-    }
 #endif
 }
 
-void Coordinator::broadcastMemberUpdate(m3::PEDesc PEs[], uint numPEs, membership_entry::krnl_id_t krnl,
-    membership_entry::pe_id_t krnlCore, MembershipFlags flags) {
+void Coordinator::krnlVital(size_t id, m3::Errors::Code err, GateIStream &is) {
+    if(err != m3::Errors::NO_ERROR)
+        PANIC("Error starting remote kernel #" << id << "! Error: " << m3::Errors::to_string(err));
+
+    BootKrnl *krnl = nullptr;
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(k->id == id && bootParent(id) == _kid)
+            krnl = &*k;
+    }
+    if(!krnl)
+        PANIC("Unexpected SIGVITAL from kernel #" << id);
+
+    if(krnl->state == STARTING) {
+        // the kernel tells us the cores of the kernels below it
+        uint amount;
+        membership_entry::krnl_id_t kid;
+        membership_entry::pe_id_t core;
+        is >> amount;
+        for(uint i = 0; i < amount; i++) {
+            is >> kid >> core;
+            _krnls.put(kid, core);
+        }
+        krnl->state = ALIVE;
+        _bootAlive++;
+        m3::ThreadManager::get().notify(&_bootAlive);
+    }
+    else {
+        krnl->state = READY;
+        _bootReady++;
+        if(_creator)
+            bootProgress();
+        else
+            m3::ThreadManager::get().notify(&_bootReady);
+    }
+}
+
+void Coordinator::krnlsAnnounced(uint amount, GateIStream &is) {
+    membership_entry::krnl_id_t kid;
+    membership_entry::pe_id_t core;
+    for(uint i = 0; i < amount; i++) {
+        is >> kid >> core;
+        _krnls.put(kid, core);
+    }
+
+    // pass the announcement on to our children
+    for(auto k = _bootKrnls.begin(); k != _bootKrnls.end(); ++k) {
+        if(bootParent(k->id) == _kid)
+            Kernelcalls::get().announceKrnls(getKPE(k->id));
+    }
+
+    // connect to the kernels before us, except for our creator. the kernels after us connect to
+    // us, unless we started them
+    m3::PEDesc localPEs[Platform::pe_count()];
+    uint numPEs = MHTInstance::getInstance().localPEs(localPEs);
+    for(auto it = _krnls.begin(); it != _krnls.end(); it++) {
+        if(it->id >= _kid || it->id == _creator->id())
+            continue;
+
+        int localEp = KernelcallHandler::get().reserve_ep(it->id);
+        if(localEp == -1)
+            PANIC("No msg slots for kernel #" << it->id << " left");
+        _bootConnects++;
+        Kernelcalls::get().connect(it->id, it->val, Kernelcalls::OpStage::KREQUEST, _kid,
+            Platform::kernel_pe(), localEp, numPEs, MembershipFlags::NONE, localPEs);
+    }
+    krnlConnected();
+}
+
+void Coordinator::krnlConnected() {
+    assert(_bootConnects > 0);
+    _bootConnects--;
+    bootProgress();
+}
+
+void Coordinator::bootProgress() {
+    if(_bootConnects > 0)
+        return;
+
+    if(!_bootConnected) {
+        _bootConnected = true;
+        // wake up the init thread to continue loading apps
+        m3::ThreadManager::get().notify(reinterpret_cast<void*>(0));
+    }
+    // tell the creator that we and the kernels below us are ready to participate in the system
+    if(!_bootReported && _bootReady == _bootChildren) {
+        _bootReported = true;
+        Kernelcalls::get().sigvital(_creator, Platform::creatorThread(), m3::Errors::NO_ERROR);
+        while(_bootKrnls.length() > 0)
+            delete _bootKrnls.remove_first();
+    }
+}
+
+void Coordinator::broadcastMemberUpdate(const membership_entry ranges[], size_t numRanges,
+    membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags) {
     for(auto it = _kpes.begin(); it != _kpes.end(); it++)
-        Kernelcalls::get().membershipUpdate(it->val, PEs, numPEs, krnl, krnlCore, flags);
+        Kernelcalls::get().membershipUpdate(it->val, ranges, numRanges, krnl, krnlCore, flags);
 }
 
 void Coordinator::removeKPE(size_t id) {
@@ -17,17 +17,52 @@
 
 #pragma once
 
+#include <base/col/SList.h>
 #include <base/util/String.h>
 #include <base/PEDesc.h>
 
 #include "pes/KPE.h"
 #include "tests/KTestSuiteContainer.h"
+#include "tests/DDLTest.h"
+#include "tests/KVStoreTest.h"
+#include "tests/MemTest.h"
+#include "tests/ServicesTest.h"
 #include "KernelcallHandler.h"
 
+// the number of kernels that every kernel starts during the boot (see Coordinator::bootKrnls)
+#ifndef KERNEL_BOOT_FANOUT
+#   define KERNEL_BOOT_FANOUT   4
+#endif
+
 namespace kernel {
 class Coordinator {
     friend class Kernelcalls;
 
+    enum BootState {
+        STARTING,
+        ALIVE,
+        READY,
+    };
+
+    /**
+     * A kernel that is started during the boot, either by us or by one of the kernels below us
+     */
+    struct BootKrnl : public m3::SListItem {
+        explicit BootKrnl(size_t _id, unsigned int _numPEs, int _argc, char **_argv)
+            : id(_id), numPEs(_numPEs), argc(_argc), argv(_argv), pes(), pesCount(),
+              state(STARTING) {
+        }
+
+        size_t id;
+        unsigned int numPEs;
+        int argc;
+        char **argv;
+        // the PEs we released to the kernel and the kernels below; the first one runs the kernel
+        m3::PEDesc *pes;
+        unsigned int pesCount;
+        BootState state;
+    };
+
 public:
     Coordinator(const Coordinator &) = delete;
     Coordinator &operator=(const Coordinator &) = delete;
@@ -66,13 +101,43 @@ public:
     }
 
     /**
-     * Sets up a new kernel and starts it
-     * @param binary    Name of the kernel's binary
+     * Adds a kernel that is started by bootKrnls.
      * @param id        ID of the new kernel
-     * @param core      The core id the new kernel should be run on
      * @param numPEs    Number of PEs to be managed by the new kernel
+     * @param argc      Number of arguments
+     * @param argv      The arguments, starting with the kernel's binary
+     */
+    void addBootKrnl(size_t id, unsigned int numPEs, int argc, char **argv);
+    /**
+     * Adds the kernels that our creator appended to our arguments (see startKrnl).
+     * @return The number of arguments that are left for us
+     */
+    int parseBootKrnls(int argc, char **argv);
+    /**
+     * Starts the added kernels as a tree: the parent of a kernel is given by bootParent and every
+     * kernel starts its children at once. A kernel reports to be alive as soon as its children are
+     * alive. Afterwards, the initial kernel announces all kernels down the tree and each kernel
+     * connects to the kernels with smaller IDs, except for its parent, before it reports to be
+     * ready. The initial kernel returns when all kernels are ready, the others as soon as their
+     * children are alive.
+     */
+    void bootKrnls();
+    /**
+     * Handles a SIGVITAL of the kernel <id>, which we started
      */
-    void startKrnl(int argc, char* argv[], m3::String&& binary, size_t id, size_t core, unsigned int numPEs);
+    void krnlVital(size_t id, m3::Errors::Code err, GateIStream &is);
+    /**
+     * Handles the announcement of <amount> kernels by our creator
+     */
+    void krnlsAnnounced(uint amount, GateIStream &is);
+    /**
+     * Is called when a connection, that has been requested due to the announcement, is set up
+     */
+    void krnlConnected();
+
+    static size_t bootParent(size_t id) {
+        return (id - 1) / KERNEL_BOOT_FANOUT;
+    }
 
     /**
      * Moves a kernel from the startingKrnls store to the kpes store, which makes
@@ -85,14 +150,14 @@ public:
     /**
      * Inform all other kernel about the change in the ddl membership
      *
-     * @param PEs       Array of PEs to that are affected of the change
-     * @param numPEs    Number of affected PEs
+     * @param ranges    The affected PEs as ranges (pe_id and capacity)
+     * @param numRanges Number of ranges
      * @param krnl      The new owner's ID
      * @param krnlCore  The new owner's core
      * @param flags     Flags of type ::MembershipFlags
      */
-    void broadcastMemberUpdate(m3::PEDesc PEs[], uint numPEs, membership_entry::krnl_id_t krnl,
-        membership_entry::pe_id_t krnlCore, MembershipFlags flags);
+    void broadcastMemberUpdate(const membership_entry ranges[], size_t numRanges,
+        membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags);
 
     void addKPE(m3::String &&prog, size_t id, size_t core, int localEp, int remoteEp) {
         _kpes.put(id, new KPE(m3::Util::move(prog), id, core, localEp, remoteEp));
@@ -115,6 +180,19 @@ public:
     void startTests() {
         KTestSuiteContainer* testSuites = new KTestSuiteContainer();
         // add test suites here
+#if defined KTEST_reserve || defined KTEST_hash || defined KTEST_mhtbench || \
+    defined KTEST_mhtcache || defined KTEST_membership
+        testSuites->add(new DDLTestSuite());
+#endif
+#ifdef KTEST_kvstore
+        testSuites->add(new KVStoreTestSuite());
+#endif
+#ifdef KTEST_services
+        testSuites->add(new ServicesTestSuite());
+#endif
+#ifdef KTEST_mem
+        testSuites->add(new MemTestSuite());
+#endif
         testSuites->run();
         delete testSuites;
     }
@@ -128,9 +206,30 @@ public:
 private:
     explicit Coordinator(size_t kid, m3::String&& creatorBin, size_t creatorId, size_t creatorCore);
     explicit Coordinator(size_t kid);
+
+    void startKrnl(BootKrnl &krnl);
+    void bootProgress();
+    bool inSubtree(size_t id, size_t root) const {
+        while(id > root)
+            id = bootParent(id);
+        return id == root;
+    }
+    char **bootArgs(const BootKrnl &krnl, int *argc) const;
+
     size_t _kid;
     KPE* _creator;
     KVStore<size_t, KPE*> _kpes;
+    KVStore<size_t, KPE*> _startingKrnls;
+    m3::SList<BootKrnl> _bootKrnls;
+    // the cores of the kernels we know of; all kernels after the announcement
+    KVStore<size_t, size_t> _krnls;
+    uint _bootChildren;
+    uint _bootAlive;
+    uint _bootReady;
+    // the outstanding connections; the announcement of the other kernels counts as one of them
+    uint _bootConnects;
+    bool _bootConnected;
+    bool _bootReported;
 #ifdef KERNEL_TESTS
     uint _startingKernels;
     bool _startup_done;
@@ -39,7 +39,8 @@ using GateIStream = m3::BaseGateIStream<RecvGate, SendGate>;
 
 class RecvGate : public SlabObject<RecvGate>, public m3::Subscriptions<GateIStream&> {
 public:
-    explicit RecvGate(int ep, void *sess) : m3::Subscriptions<GateIStream&>(), _ep(ep), _sess(sess) {
+    explicit RecvGate(int ep, void *sess)
+        : m3::Subscriptions<GateIStream&>(), _ep(ep), _sess(sess) {
     }
 
     size_t epid() const {
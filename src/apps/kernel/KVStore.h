@@ -19,21 +19,27 @@
 
 #include <base/Errors.h>
 #include <base/Panic.h>
-#include <base/col/SList.h>
+#include <base/col/DList.h>
+#include <base/col/HashTable.h>
 
 namespace kernel {
 
 /**
  * The key-value store is currently misused in some cases, just to make things
  * work, thus some functions are really untypical for a kv-store.
+ *
+ * Lookups are done in constant time: keys below DENSE_MAX (e.g., kernel ids and callback ids) are
+ * used as an index into an array that grows on demand, all other keys are put into a hash table.
+ * Additionally, all entries are kept in a list in the order they have been inserted, so that
+ * iterating over the store (e.g., for broadcasts) visits them in a stable order.
  */
-template<typename KEY, class VALUE>
+template<typename KEY, class VALUE, size_t DENSE_MAX = 1024>
 class KVStore {
 private:
     struct Entry;
 public:
-    using iterator = typename m3::SList<Entry>::iterator;
-    using const_iterator = typename m3::SList<Entry>::const_iterator;
+    using iterator = typename m3::DList<Entry>::iterator;
+    using const_iterator = typename m3::DList<Entry>::const_iterator;
 
     class Updater {
     public:
@@ -63,80 +69,85 @@ public:
         VALUE _val;
     };
 
-    KVStore() : _store() {
+    KVStore() : _list(), _dense(nullptr), _denseSize(0), _sparse() {
     };
     KVStore(const KVStore &) = delete;
     KVStore &operator=(const KVStore &) = delete;
+    ~KVStore() {
+        for(auto it = _list.begin(); it != _list.end(); ) {
+            auto old = it++;
+            delete &*old;
+        }
+        delete[] _dense;
+    }
 
     m3::Errors::Code put(KEY key, VALUE val){
         // check whether the key is already existing. If so, overwrite the existing entry
-        for(auto it = _store.begin(); it != _store.end(); it++){
-            if(it->id == key){
-                it->val = val;
-                return m3::Errors::NO_ERROR;
-            }
+        Entry *e = find(key);
+        if(e) {
+            e->val = val;
+            return m3::Errors::NO_ERROR;
         }
         // Create a new entry if key did not exist before
         Entry *newEntry = new Entry(key, val);
-        _store.append(newEntry);
+        if(is_dense(key)) {
+            if(static_cast<size_t>(key) >= _denseSize)
+                grow_dense(static_cast<size_t>(key));
+            _dense[key] = newEntry;
+        }
+        else
+            _sparse.insert(key, newEntry);
+        _list.append(newEntry);
         return m3::Errors::NO_ERROR;
     }
 
     VALUE get(KEY key) const {
-        auto find = _store.end();
-        for(auto it = _store.begin(); it != _store.end(); it++){
-            if(it->id == key){
-                find = it;
-                break;
-            }
-        }
+        Entry *e = find(key);
         // TODO: is it right to panic here?
-        if(find == _store.end())
+        if(e == nullptr)
             PANIC("Did not find key " << key << " in KV Store!");
-        return find->val;
+        return e->val;
     }
 
     iterator begin() {
-        return _store.begin();
+        return _list.begin();
     }
 
     iterator end() {
-        return _store.end();
+        return _list.end();
     }
 
     const_iterator begin() const {
-        return _store.begin();
+        return _list.cbegin();
     }
 
     const_iterator end() const {
-        return _store.end();
+        return _list.cend();
     }
 
     bool remove(KEY key) {
-        Entry *find = nullptr;
-        for(auto it = _store.begin(); it != _store.end(); it++){
-            if(it->id == key){
-                find = it.operator ->();
-                break;
-            }
+        Entry *e;
+        if(is_dense(key)) {
+            e = static_cast<size_t>(key) < _denseSize ? _dense[key] : nullptr;
+            if(e)
+                _dense[key] = nullptr;
         }
-        if(find == nullptr)
+        else
+            e = _sparse.remove(key);
+        if(e == nullptr)
             return false;
 
-        return _store.remove(find);
+        _list.remove(e);
+        delete e;
+        return true;
     }
 
     bool exists(KEY key) const {
-        for(auto it = _store.begin(); it != _store.end(); it++){
-            if(it->id == key){
-                return true;
-            }
-        }
-        return false;
+        return find(key) != nullptr;
     }
 
     unsigned int size() {
-        return _store.length();
+        return _list.length();
     }
 
     constexpr VALUE operator[](KEY pos) const {
@@ -148,13 +159,42 @@ public:
     }
 
 private:
-    struct Entry : public m3::SListItem {
+    struct Entry : public m3::DListItem {
         explicit Entry(KEY key, VALUE value) : id(key), val(value){
         }
         KEY id;
         VALUE val;
     };
 
-    m3::SList<Entry> _store;
+    static bool is_dense(KEY key) {
+        return key >= 0 && static_cast<size_t>(key) < DENSE_MAX;
+    }
+
+    Entry *find(KEY key) const {
+        if(is_dense(key))
+            return static_cast<size_t>(key) < _denseSize ? _dense[key] : nullptr;
+        return _sparse.find(key);
+    }
+
+    void grow_dense(size_t key) {
+        size_t nsize = _denseSize ? _denseSize : 16;
+        while(nsize <= key)
+            nsize *= 2;
+        if(nsize > DENSE_MAX)
+            nsize = DENSE_MAX;
+        Entry **ndense = new Entry*[nsize];
+        for(size_t i = 0; i < _denseSize; ++i)
+            ndense[i] = _dense[i];
+        for(size_t i = _denseSize; i < nsize; ++i)
+            ndense[i] = nullptr;
+        delete[] _dense;
+        _dense = ndense;
+        _denseSize = nsize;
+    }
+
+    m3::DList<Entry> _list;
+    Entry **_dense;
+    size_t _denseSize;
+    m3::HashTable<KEY, Entry> _sparse;
 };
 }
\ No newline at end of file
@@ -92,6 +92,11 @@ KernelcallHandler::KernelcallHandler()
     add_operation(Kernelcalls::CONNECT, &KernelcallHandler::connect);
     add_operation(Kernelcalls::REPLYKRNLC, &KernelcallHandler::reply);
     add_operation(Kernelcalls::STARTAPPS, &KernelcallHandler::startApps);
+    add_operation(Kernelcalls::MHTGETV, &KernelcallHandler::mhtgetv);
+    add_operation(Kernelcalls::MHTPUTV, &KernelcallHandler::mhtputv);
+    add_operation(Kernelcalls::MHTLOCKV, &KernelcallHandler::mhtlockv);
+    add_operation(Kernelcalls::MHTUNLOCKV, &KernelcallHandler::mhtunlockv);
+    add_operation(Kernelcalls::DDLLOAD, &KernelcallHandler::ddlLoad);
 }
 
 void KernelcallHandler::sigvital(GateIStream& is) {
@@ -100,8 +105,7 @@ void KernelcallHandler::sigvital(GateIStream& is) {
     m3::Errors::Code err;
     is >> tid >> err;
     LOG_ANONYM(is.label(), "kernelcall::sigvital(creatorThread=" << tid << ", err=" << err << ")");
-    m3::ThreadManager::get().notify(reinterpret_cast<void*>(tid), reinterpret_cast<void*>(&err),
-        sizeof(m3::Errors::Code));
+    Coordinator::get().krnlVital(is.label(), err, is);
 }
 
 void KernelcallHandler::kexit(GateIStream &is) {
@@ -179,6 +183,7 @@ void KernelcallHandler::mhtget(GateIStream& is) {
         is >> tid >> mht_key ;
         LOG_KRNL(Coordinator::get().getKPE(is.label()),
                 "kernelcall::mhtget(KREQUEST, tid=" << tid << ", mht_key=" << PRINT_HASH(mht_key) << ")");
+        MHTInstance::getInstance().accountRemote(mht_key);
         const MHTItem& result = MHTInstance::getInstance().localGet(mht_key, false);
         Kernelcalls::get().mhtgetReply(Coordinator::get().getKPE(is.label()), tid, result);
     }
@@ -203,6 +208,7 @@ void KernelcallHandler::mhtput(GateIStream& is) {
     MHTItem input(is);
     LOG_KRNL(Coordinator::get().getKPE(is.label()),
             "kernelcall::mhtput(KREQUEST, input.mht_key=" << PRINT_HASH(input.getKey()) << ", input.len=" << input.getLength() << ")");
+    MHTInstance::getInstance().accountRemote(input.getKey());
     MHTInstance::getInstance().put(m3::Util::move(input));
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
@@ -215,6 +221,7 @@ void KernelcallHandler::mhtputUnlocking(GateIStream& is) {
     LOG_KRNL(Coordinator::get().getKPE(is.label()),
         "kernelcall::mhtputUnlocking(KREQUEST, input.mht_key=" << PRINT_HASH(input.getKey()) <<
         ", input.len=" << input.getLength() << ", lockHandle=" << lockHandle << ")");
+    MHTInstance::getInstance().accountRemote(input.getKey());
     MHTInstance::getInstance().putUnlocking(m3::Util::move(input), lockHandle);
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
@@ -231,8 +238,10 @@ void KernelcallHandler::mhtlock(GateIStream& is) {
         LOG_KRNL(Coordinator::get().getKPE(is.label()),
                 "kernelcall::mhtlock(KREQUEST, tid=" << tid << ", mht_key=" << PRINT_HASH(mht_key) << ")");
 
-        // check if this kernel really maintains the partition containing the key
-        if(MHTInstance::getInstance().responsibleMember(mht_key) == Coordinator::get().kid()) {
+        // check if this kernel really maintains the partition containing the key (or has
+        // migrated it, in which case lockLocal forwards the request to the new owner)
+        if(MHTInstance::getInstance().servesKey(mht_key)) {
+            MHTInstance::getInstance().accountRemote(mht_key);
             uint lockHandle = MHTInstance::getInstance().lockLocal(mht_key);
             Kernelcalls::get().mhtlockReply(Coordinator::get().getKPE(is.label()), tid, lockHandle);
             // TODO
@@ -290,6 +299,7 @@ void KernelcallHandler::mhtunlock(GateIStream& is) {
     is >> mht_key >> lockHandle;
     LOG_KRNL(Coordinator::get().getKPE(is.label()),
             "kernelcall::mhtunlock(mht_key=" << PRINT_HASH(mht_key) << ", lockHandle=" << lockHandle << ")");
+    MHTInstance::getInstance().accountRemote(mht_key);
     MHTInstance::getInstance().unlock(mht_key, lockHandle);
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
@@ -305,8 +315,9 @@ void KernelcallHandler::mhtreserve(GateIStream& is) {
         is >> mht_key;
         LOG_KRNL(Coordinator::get().getKPE(is.label()),
                 "kernelcall::mhtreserve(KREQUEST, tid = " << tid << ", mht_key=" << PRINT_HASH(mht_key) << ")");
-        // Forwarding is not yet allowed
-        assert(MHTInstance::getInstance().keyLocality(mht_key));
+        // Forwarding is only done for partitions we have migrated
+        assert(MHTInstance::getInstance().servesKey(mht_key));
+        MHTInstance::getInstance().accountRemote(mht_key);
         Kernelcalls::get().mhtReserveReply(Coordinator::get().getKPE(is.label()), tid,
                 MHTInstance::getInstance().reserve(mht_key));
         break;
@@ -333,27 +344,168 @@ void KernelcallHandler::mhtrelease(GateIStream& is) {
     is >> mht_key >> reservation;
     LOG_KRNL(Coordinator::get().getKPE(is.label()),
             "kernelcall::mhtrelease(mht_key=" << PRINT_HASH(mht_key) << ", reservation=" << reservation << ")");
+    MHTInstance::getInstance().accountRemote(mht_key);
     MHTInstance::getInstance().release(mht_key, reservation);
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
 
+void KernelcallHandler::mhtgetv(GateIStream& is) {
+    mhtBatch(is, Kernelcalls::MHTGETV);
+}
+
+void KernelcallHandler::mhtputv(GateIStream& is) {
+    mhtBatch(is, Kernelcalls::MHTPUTV);
+}
+
+void KernelcallHandler::mhtlockv(GateIStream& is) {
+    mhtBatch(is, Kernelcalls::MHTLOCKV);
+}
+
+void KernelcallHandler::mhtunlockv(GateIStream& is) {
+    mhtBatch(is, Kernelcalls::MHTUNLOCKV);
+}
+
+void KernelcallHandler::mhtBatch(GateIStream& is, Kernelcalls::Operation op) {
+    Kernelcalls::OpStage stage;
+    int tid;
+    uintptr_t batchAddr;
+    size_t count;
+    is >> stage >> tid >> batchAddr >> count;
+    LOG_KRNL(Coordinator::get().getKPE(is.label()), "kernelcall::mhtbatch(" <<
+        (stage == Kernelcalls::KREQUEST ? "KREQUEST" : "KREPLY") << ", op=" << op <<
+        ", tid=" << tid << ", count=" << count << ")");
+
+    if(stage == Kernelcalls::KREQUEST) {
+        mhtBatchRequest(is, op, tid, batchAddr, count);
+        return;
+    }
+
+    // KREPLY: store the results in the batch of the waiting thread
+    DDLBatch *batch = reinterpret_cast<DDLBatch*>(batchAddr);
+    for(size_t i = batch->answered; i < batch->answered + count; ++i) {
+        is >> batch->results[i];
+        if(batch->results[i] == m3::Errors::INV_ARGS)
+            is >> batch->owners[i];
+        else if(op == Kernelcalls::MHTGETV) {
+            batch->data[i] = nullptr;
+            if(batch->results[i] == m3::Errors::NO_ERROR) {
+                MHTItem item(is);
+                batch->data[i] = item.data;
+                MHTInstance::getInstance().cache().insert(item);
+            }
+        }
+        else if(op == Kernelcalls::MHTLOCKV)
+            is >> batch->values[i];
+    }
+    batch->answered += count;
+    Coordinator::get().getKPE(is.label())->msg_received();
+    m3::ThreadManager::get().notify(reinterpret_cast<void*>(tid));
+}
+
+void KernelcallHandler::mhtBatchRequest(GateIStream& is, Kernelcalls::Operation op, int tid,
+        uintptr_t batch, size_t count) {
+    MHTInstance &mht = MHTInstance::getInstance();
+    BatchGateOStream reply(op, Kernelcalls::KREPLY, tid, batch);
+    // the size of a result, except for MHTGETV, where the item follows. Keys we do not own are
+    // answered with INV_ARGS and the responsible kernel, so that the requestor can update its
+    // membership table and ask the new owner of a migrated partition directly.
+    size_t resSize = op == Kernelcalls::MHTLOCKV
+        ? m3::ostreamsize<m3::Errors::Code, uint>()
+        : m3::ostreamsize<m3::Errors::Code, membership_entry::krnl_id_t>();
+
+    // we answer as many entries as fit into the reply. the requestor sends the rest again.
+    size_t n = 0;
+    for(; n < count && reply.has_space(resSize); ++n) {
+        switch(op) {
+            case Kernelcalls::MHTGETV: {
+                mht_key_t key;
+                is >> key;
+                if(!mht.ownsKey(key)) {
+                    reply << m3::Errors::INV_ARGS << mht.responsibleMember(key);
+                    break;
+                }
+                mht.accountRemote(key);
+                const MHTItem &item = mht.localGet(key, false);
+                if(item.isEmpty()) {
+                    reply << m3::Errors::NO_SUCH_FILE;
+                    break;
+                }
+                if(!reply.has_space(resSize + item.serializedSize())) {
+                    // make sure that we make progress
+                    if(n == 0) {
+                        reply << m3::Errors::OUT_OF_MEM;
+                        n++;
+                    }
+                    goto done;
+                }
+                reply << m3::Errors::NO_ERROR;
+                item.serialize(reply);
+                break;
+            }
+
+            case Kernelcalls::MHTPUTV: {
+                uint lockHandle;
+                is >> lockHandle;
+                MHTItem item(is);
+                if(!mht.ownsKey(item.getKey())) {
+                    reply << m3::Errors::INV_ARGS << mht.responsibleMember(item.getKey());
+                    m3::Heap::free(item.data);
+                    break;
+                }
+                mht.accountRemote(item.getKey());
+                if(lockHandle)
+                    reply << mht.putUnlocking(m3::Util::move(item), lockHandle);
+                else
+                    reply << mht.put(m3::Util::move(item));
+                break;
+            }
+
+            case Kernelcalls::MHTLOCKV: {
+                mht_key_t key;
+                is >> key;
+                if(!mht.ownsKey(key))
+                    reply << m3::Errors::INV_ARGS << mht.responsibleMember(key);
+                else {
+                    mht.accountRemote(key);
+                    uint lockHandle = mht.lockLocal(key);
+                    reply << (lockHandle ? m3::Errors::NO_ERROR : m3::Errors::NO_SUCH_FILE) << lockHandle;
+                }
+                break;
+            }
+
+            case Kernelcalls::MHTUNLOCKV: {
+                mht_key_t key;
+                uint lockHandle;
+                is >> key >> lockHandle;
+                if(!mht.ownsKey(key))
+                    reply << m3::Errors::INV_ARGS << mht.responsibleMember(key);
+                else {
+                    mht.accountRemote(key);
+                    reply << (mht.unlockLocal(key, lockHandle) ? m3::Errors::NO_ERROR : m3::Errors::NO_PERM);
+                }
+                break;
+            }
+
+            default:
+                PANIC("Unsupported batch operation " << op);
+        }
+    }
+
+done:
+    reply.finish(n);
+    Coordinator::get().getKPE(is.label())->reply(reply.bytes(), reply.total());
+}
+
 void KernelcallHandler::membershipUpdate(GateIStream &is) {
     membership_entry::krnl_id_t krnlId;
     membership_entry::pe_id_t krnlCore;
     MembershipFlags flags;
-    uint numPEs;
-    is >> krnlId >> krnlCore >> flags >> numPEs;
+    uint numRanges;
+    is >> krnlId >> krnlCore >> flags >> numRanges;
     LOG_KRNL(Coordinator::get().getKPE(is.label()),
-        "kernelcall::membershipUpdate(pes=[...], numPEs=" << numPEs << ", kernel=" << krnlId <<
+        "kernelcall::membershipUpdate(ranges=[...], numRanges=" << numRanges << ", kernel=" << krnlId <<
         ", krnlCore=" << krnlCore << ", flags=" << (int)flags << ")");
 
-    m3::PEDesc* newPEs = new m3::PEDesc[numPEs];
-    for(size_t i = 0; i < numPEs; i++) {
-        m3::PEDesc::value_t desc;
-        is >> desc;
-        newPEs[i] = m3::PEDesc(desc);
-    }
-
     // New kernels can only be added when we know which EP we should connect it to, so we wait
     // for the new kernel to connect to us and provide this information.
     if(!Coordinator::get().tryGetKPE(krnlId)) {
@@ -361,14 +513,52 @@ void KernelcallHandler::membershipUpdate(GateIStream &is) {
         return;
     }
 
-    MHTInstance::getInstance().updateMembership(newPEs, numPEs, krnlId, krnlCore, flags, false);
+    for(uint i = 0; i < numRanges; i++) {
+        membership_entry::pe_id_t start;
+        membership_entry::capacity_t count;
+        is >> start >> count;
+        MHTInstance::getInstance().updateMembership(start, krnlId, krnlCore, count, flags, false);
+    }
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
 
 void KernelcallHandler::migratePartition(GateIStream &is) {
-    LOG_KRNL(Coordinator::get().getKPE(is.label()), "kernelcall::migratePartition()");
-    MHTInstance::getInstance().receivePartitions(is);
-    Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
+    Kernelcalls::OpStage stage;
+    int tid;
+    uintptr_t migration;
+    is >> stage >> tid >> migration;
+    KPE *kpe = Coordinator::get().getKPE(is.label());
+
+    if(stage == Kernelcalls::KREQUEST) {
+        size_t count;
+        uint seq;
+        membership_entry::pe_id_t id;
+        bool last;
+        is >> count >> seq >> id >> last;
+        LOG_KRNL(kpe, "kernelcall::migratePartition(KREQUEST, tid=" << tid << ", partition=" << id <<
+            ", seq=" << seq << ", count=" << count << ", last=" << last << ")");
+        m3::Errors::Code res = MHTInstance::getInstance().receivePartitionChunk(is, kpe->id(), seq,
+            id, last, count);
+        Kernelcalls::get().migratePartitionAck(kpe, tid, migration, seq, res);
+    }
+    else {
+        uint seq;
+        m3::Errors::Code res;
+        is >> seq >> res;
+        LOG_KRNL(kpe, "kernelcall::migratePartition(KREPLY, tid=" << tid << ", seq=" << seq <<
+            ", res=" << res << ")");
+        kpe->msg_received();
+        MHTInstance::getInstance().partitionChunkAcked(migration, seq, res);
+    }
+}
+
+void KernelcallHandler::ddlLoad(GateIStream &is) {
+    size_t load;
+    is >> load;
+    KPE *kpe = Coordinator::get().getKPE(is.label());
+    LOG_KRNL(kpe, "kernelcall::ddlLoad(load=" << load << ")");
+    MHTRebalancer::get().peerLoad(kpe->id(), load);
+    Kernelcalls::get().reply(kpe);
 }
 
 void KernelcallHandler::createSessFwd(GateIStream &is) {
@@ -682,14 +872,24 @@ void KernelcallHandler::removeChildCapPtr(GateIStream &is) {
         return;
     }
 
+    mht_key_t *parents = new mht_key_t[parentCount];
+    void **caps = new void*[parentCount];
+    m3::Errors::Code *res = new m3::Errors::Code[parentCount];
+    for(uint i = 0; i < parentCount; i ++)
+        parents[i] = parentStart + i;
+    MHTInstance::getInstance().getv(parents, parentCount, caps, res);
+
     for(uint i = 0; i < parentCount; i ++) {
-        const MHTItem &parentItem = MHTInstance::getInstance().get(parentStart + i);
-        if(parentItem.data == nullptr) {
-            KLOG(ERR, "Can't remove children, parent cap" << PRINT_HASH(parentStart) << " not existent.");
+        if(res[i] != m3::Errors::NO_ERROR) {
+            KLOG(ERR, "Can't remove children, parent cap" << PRINT_HASH(parents[i]) << " not existent ("
+                << res[i] << ")");
             continue;
         }
-        parentItem.getData<Capability>()->removeChildAllTypes(childStart + i);
+        static_cast<Capability*>(caps[i])->removeChildAllTypes(childStart + i);
     }
+    delete[] res;
+    delete[] caps;
+    delete[] parents;
     Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
 }
 
@@ -745,37 +945,52 @@ void KernelcallHandler::announceSrv(GateIStream &is) {
 }
 
 void KernelcallHandler::revoke(GateIStream &is) {
-    mht_key_t capID, parent, originCap;
-    is >> capID >> parent >> originCap;
-    LOG_KRNL(Coordinator::get().getKPE(is.label()), "kernelcall::revoke(capID=" <<
-        PRINT_HASH(capID) << ", parent=" << PRINT_HASH(parent) << ", originCap="
-        << PRINT_HASH(originCap) << ")");
-
-    int awaited = 0;
-    const MHTItem &capIt = MHTInstance::getInstance().get(capID);
-    if(!capIt.isEmpty()) {
-        Capability *cap = capIt.getData<Capability>();
-        awaited = cap->table()->revoke(cap, capID, originCap);
-
-        KLOG(KRNLC, "Generated " << awaited << " revoke requests");
+    mht_key_t parent, originCap;
+    size_t count;
+    is >> parent >> originCap >> count;
+    KPE *kpe = Coordinator::get().getKPE(is.label());
+    LOG_KRNL(kpe, "kernelcall::revoke(parent=" << PRINT_HASH(parent) << ", originCap="
+        << PRINT_HASH(originCap) << ", caps=" << count << ")");
+
+    // revoking a child might block this thread, so take the IDs out of the message first
+    mht_key_t *capIDs = new mht_key_t[count];
+    for(size_t i = 0; i < count; ++i)
+        is >> capIDs[i];
+
+    int finished = 0;
+    for(size_t i = 0; i < count; ++i) {
+        mht_key_t capID = capIDs[i];
+        int awaited = 0;
+        const MHTItem &capIt = MHTInstance::getInstance().get(capID);
+        if(!capIt.isEmpty()) {
+            Capability *cap = capIt.getData<Capability>();
+            awaited = cap->table()->revoke(cap, capID, originCap);
+
+            KLOG(KRNLC, "Generated " << awaited << " revoke requests for cap " << PRINT_HASH(capID));
+        }
+        else {
+            // figure out the capTable to call revoke which checks whether the
+            // revocation of this cap is still in flight
+            if(HashUtil::hashToType(capID) == ItemType::MAPCAP)
+                awaited = PEManager::get().vpe(HashUtil::hashToVpeId(capID)).mapcaps().revoke(
+                    nullptr, capID, originCap);
+            else
+                awaited = PEManager::get().vpe(HashUtil::hashToVpeId(capID)).objcaps().revoke(
+                    nullptr, capID, originCap);
+        }
+        // we can confirm the end of the revocation if it was either revoking only leaf caps or
+        // it has been revoked already or it never existed. The others confirm it on their own
+        // as soon as their remote children are revoked.
+        if(!awaited)
+            finished++;
     }
-    else {
-        // figure out the capTable to call revoke which checks whether the
-        // revocation of this cap is still in flight
-        if(HashUtil::hashToType(capID) == ItemType::MAPCAP)
-            awaited = PEManager::get().vpe(HashUtil::hashToVpeId(capID)).mapcaps().revoke(
-                nullptr, capID, originCap);
-        else
-            awaited = PEManager::get().vpe(HashUtil::hashToVpeId(capID)).objcaps().revoke(
-                nullptr, capID, originCap);
-    }
-    // check if we can confirm the end of the revocation.
-    // Meaning it was either revoking only leaf caps or it has been revoked
-    // already or it never existed
-    if(!awaited)
-        Kernelcalls::get().revokeFinish(Coordinator::get().getKPE(is.label()), parent, -1, true);
+    delete[] capIDs;
+
+    // confirm all finished children at once
+    if(finished)
+        Kernelcalls::get().revokeFinish(kpe, parent, -finished, true);
     else
-        Kernelcalls::get().reply(Coordinator::get().getKPE(is.label()));
+        Kernelcalls::get().reply(kpe);
 }
 
 void KernelcallHandler::revokeFinish(GateIStream &is) {
@@ -797,7 +1012,11 @@ void KernelcallHandler::revokeFinish(GateIStream &is) {
     // sum up number of awaited responses to revocation entry
     revoc->awaitedResp += awaits;
     if(revoc->awaitedResp == 0) {
-        if(revoc->capID == revoc->origin) {
+        if(revoc->async) {
+            // nobody waits for an asynchronous revoke, so finish it here
+            RevocationList::get().finish_root(revoc);
+        }
+        else if(revoc->capID == revoc->origin) {
             // Note: We don't notify our subscribers here since the notified
             // thread will do so.
 
@@ -888,37 +1107,9 @@ void KernelcallHandler::shutdown(GateIStream& is) {
 
 void KernelcallHandler::announceKrnls(GateIStream &is) {
     uint amount;
-    membership_entry::krnl_id_t kid;
-    membership_entry::pe_id_t core;
     is >> amount;
     LOG_KRNL(Coordinator::get().getKPE(is.label()), "kernelcall::announceKrnls(amount=" << amount << ")");
-
-    uint numPEs = MHTInstance::getInstance().localPEs();
-    m3::PEDesc localPEs[numPEs];
-    uint addedPEs = 0;
-    for(uint i = 0; i < Platform::MAX_PES; i++) {
-        m3::PEDesc pe = Platform::pe_by_index(i);
-        // check if this PE is actually ours
-        if(MHTInstance::getInstance().responsibleKrnl(pe.core_id()) == Coordinator::get().kid())
-            localPEs[addedPEs++] = pe;
-    }
-    assert(addedPEs == numPEs);
-    for(uint i = 0; i < amount; i++) {
-        is >> kid >> core;
-        // connect to other kernels
-        int localEp = reserve_ep(kid);
-        if(localEp == -1)
-            PANIC("No msg slots for kernel #" << kid << " left");
-        Kernelcalls::get().connect(kid, core, Kernelcalls::OpStage::KREQUEST, Coordinator::get().kid(),
-            Platform::kernel_pe(), localEp, numPEs, MembershipFlags::NONE, localPEs);
-    }
-
-    // tell the creator that we are ready to participate in the system
-    Kernelcalls::get().sigvital(Coordinator::get().getKPE(is.label()), Platform::creatorThread(),
-        m3::Errors::NO_ERROR);
-
-    // wake up the init thread to continue loading apps
-    m3::ThreadManager::get().notify(reinterpret_cast<void*>(0));
+    Coordinator::get().krnlsAnnounced(amount, is);
 }
 
 void KernelcallHandler::connect(GateIStream &is) {
@@ -952,10 +1143,15 @@ void KernelcallHandler::connect(GateIStream &is) {
                 newPEs[i] = m3::PEDesc(desc);
             }
 
+            // tell the new kernel about our PEs as well
+            m3::PEDesc localPEs[Platform::pe_count()];
+            uint numLocal = MHTInstance::getInstance().localPEs(localPEs);
             Kernelcalls::get().connect(Coordinator::get().getKPE(kid), Kernelcalls::OpStage::KREPLY,
-                Coordinator::get().kid(), Platform::kernel_pe(), localEp);
+                Coordinator::get().kid(), Platform::kernel_pe(), localEp, numLocal,
+                MembershipFlags::NONE, localPEs);
 
             MHTInstance::getInstance().updateMembership(newPEs, numPEs, kid, core, flags, false);
+            delete[] newPEs;
 
             ServiceList &srv = ServiceList::get();
             for(auto s = srv.begin(); s != srv.end(); s++)
@@ -979,7 +1175,19 @@ void KernelcallHandler::connect(GateIStream &is) {
 
             KLOG(KRNLC, "Connecting to kernel #" << kid << " with EP " << localEp);
             Coordinator::get().addKPE("kernel", kid, core, localEp, epid);
+
+            MembershipFlags flags;
+            uint numPEs;
+            is >> flags >> numPEs;
+            m3::PEDesc newPEs[numPEs];
+            for(size_t i = 0; i < numPEs; i++) {
+                m3::PEDesc::value_t desc;
+                is >> desc;
+                newPEs[i] = m3::PEDesc(desc);
+            }
+            MHTInstance::getInstance().updateMembership(newPEs, numPEs, kid, core, flags, false);
         }
+        Coordinator::get().krnlConnected();
     }
 }
 
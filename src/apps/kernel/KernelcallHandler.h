@@ -99,6 +99,7 @@ public:
     void mhtrelease(GateIStream &is);
     void membershipUpdate(GateIStream &is);
     void migratePartition(GateIStream &is);
+    void ddlLoad(GateIStream &is);
     void createSessFwd(GateIStream &is);
     void createSessResp(GateIStream &is);
     void createSessFail(GateIStream &is);
@@ -117,8 +118,16 @@ public:
     void connect(GateIStream &is);
     void reply(GateIStream &is);
     void startApps(GateIStream &is);
+    void mhtgetv(GateIStream &is);
+    void mhtputv(GateIStream &is);
+    void mhtlockv(GateIStream &is);
+    void mhtunlockv(GateIStream &is);
 
 private:
+    void mhtBatch(GateIStream &is, Kernelcalls::Operation op);
+    void mhtBatchRequest(GateIStream &is, Kernelcalls::Operation op, int tid, uintptr_t batch,
+        size_t count);
+
     RecvGate _rcvgate[DTU::KRNLC_GATES];
     int _epOccup[KRNLC_SLOTS];
     m3::SList<ConnectionRequest> _connectionReqs;
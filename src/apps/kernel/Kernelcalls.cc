@@ -25,6 +25,7 @@
 #include "Kernelcalls.h"
 #include "KernelcallHandler.h"
 #include "Coordinator.h"
+#include "ddl/MHTInstance.h"
 
 namespace kernel {
 
@@ -35,11 +36,20 @@ m3::Errors::Code Kernelcalls::finish(GateIStream &&reply) {
     return m3::Errors::last;
 }
 
-void Kernelcalls::sigvital(KPE* kernel, int creatorThread, m3::Errors::Code err) {
+void Kernelcalls::sigvital(KPE* kernel, int creatorThread, m3::Errors::Code err, bool krnls) {
     KLOG(KRNLC, "sigvital(kernel=" << kernel->core() << ", creatorThread=" << creatorThread <<
-        ", err=" << (int)err << ")");
-    StaticGateOStream<m3::ostreamsize<Kernelcalls::Operation, int, m3::Errors::Code>()> msg;
-    msg << SIGVITAL << creatorThread << err;
+        ", err=" << (int)err << ", krnls=" << krnls << ")");
+    Coordinator &coord = Coordinator::get();
+    uint amount = krnls ? coord._krnls.size() : 0;
+    AutoGateOStream msg(m3::vostreamsize(
+        m3::ostreamsize<Kernelcalls::Operation, int, m3::Errors::Code, uint>(),
+        m3::ostreamsize<membership_entry::krnl_id_t, membership_entry::pe_id_t>() * amount));
+    msg << SIGVITAL << creatorThread << err << amount;
+    if(krnls) {
+        for(auto it = coord._krnls.begin(); it != coord._krnls.end(); it++)
+            msg << static_cast<membership_entry::krnl_id_t>(it->id) <<
+                static_cast<membership_entry::pe_id_t>(it->val);
+    }
     kernel->reply(msg.bytes(), msg.total());
     }
 
@@ -164,27 +174,72 @@ void Kernelcalls::mhtRelease(KPE* kernel, mht_key_t mht_key, uint reservation) {
     kernel->sendTo(msg.bytes(), msg.total());
 }
 
-void Kernelcalls::membershipUpdate(KPE *kernel, m3::PEDesc releasedPEs[], uint numPEs,
-    membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags) {
-    KLOG(KRNLC, "membershipUpdate(kernelcore=" << kernel->core() << ", pes=[...], numPEs="
-        << numPEs << ", kernel=" << krnl << ", kernelCore=" << krnlCore << ", flags=" << (int)flags << ")");
-    AutoGateOStream msg(m3::vostreamsize(
-        m3::ostreamsize<Kernelcalls::Operation, uint, size_t, membership_entry::krnl_id_t, MembershipFlags>(),
-        numPEs * m3::ostreamsize<m3::PEDesc::value_t>()));
-    msg << MEMBERUPDATE << krnl << krnlCore << flags << numPEs;
-    for(size_t i = 0; i < numPEs; i++) {
-        msg << releasedPEs[i].value();
+void Kernelcalls::mhtBatchRequest(KPE* kernel, Operation op, DDLBatch &batch) {
+    int tid = m3::ThreadManager::get().current()->id();
+    BatchGateOStream msg(op, KREQUEST, tid, reinterpret_cast<uintptr_t>(&batch));
+    size_t n = 0;
+    for(size_t i = batch.answered; i < batch.count; ++i, ++n) {
+        if(op == MHTPUTV) {
+            if(!msg.has_space(m3::ostreamsize<uint>() + batch.items[i]->serializedSize()))
+                break;
+            msg << (batch.values ? batch.values[i] : 0);
+            batch.items[i]->serialize(msg);
+        }
+        else if(op == MHTUNLOCKV) {
+            if(!msg.has_space(m3::ostreamsize<mht_key_t, uint>()))
+                break;
+            msg << batch.keys[i] << batch.values[i];
+        }
+        else {
+            if(!msg.has_space(m3::ostreamsize<mht_key_t>()))
+                break;
+            msg << batch.keys[i];
+        }
     }
+    assert(n > 0);
+    msg.finish(n);
+
+    KLOG(KRNLC, "mhtbatch(kernelcore=" << kernel->core() << ", tid=" << tid << ", op=" << op <<
+        ", entries=" << n << ", answered=" << batch.answered << "/" << batch.count << ")");
     kernel->sendTo(msg.bytes(), msg.total());
 }
 
-void Kernelcalls::migratePartition(KPE *kernel, AutoGateOStream &payload) {
-    KLOG(KRNLC, "migratePartition(kernelcore=" << kernel->core() << ", size=" << payload.total() << ")");
-    AutoGateOStream msg(m3::vostreamsize(
-        m3::ostreamsize<Kernelcalls::Operation>(),
-        payload.total()));
-    msg << PARTITIONMIG;
-    msg.put(payload);
+void Kernelcalls::membershipUpdate(KPE *kernel, const membership_entry ranges[], size_t numRanges,
+    membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags) {
+    KLOG(KRNLC, "membershipUpdate(kernelcore=" << kernel->core() << ", ranges=[...], numRanges="
+        << numRanges << ", kernel=" << krnl << ", kernelCore=" << krnlCore << ", flags=" << (int)flags << ")");
+    for(size_t off = 0; off < numRanges; off += MAX_MEMBER_RANGES) {
+        uint count = static_cast<uint>(m3::Math::min(numRanges - off, MAX_MEMBER_RANGES));
+        AutoGateOStream msg(m3::vostreamsize(
+            m3::ostreamsize<Kernelcalls::Operation, membership_entry::krnl_id_t, membership_entry::pe_id_t,
+                MembershipFlags, uint>(),
+            count * m3::ostreamsize<membership_entry::pe_id_t, membership_entry::capacity_t>()));
+        msg << MEMBERUPDATE << krnl << krnlCore << flags << count;
+        for(size_t i = off; i < off + count; i++)
+            msg << ranges[i].pe_id << ranges[i].capacity;
+        kernel->sendTo(msg.bytes(), msg.total());
+    }
+}
+
+void Kernelcalls::migratePartition(KPE *kernel, BatchGateOStream &chunk) {
+    KLOG(KRNLC, "migratePartition(kernelcore=" << kernel->core() << ", size=" << chunk.total() << ")");
+    kernel->sendTo(chunk.bytes(), chunk.total());
+}
+
+void Kernelcalls::migratePartitionAck(KPE *kernel, int tid, uintptr_t migration, uint seq,
+        m3::Errors::Code res) {
+    KLOG(KRNLC, "migratePartitionAck(kernelcore=" << kernel->core() << ", tid=" << tid <<
+        ", seq=" << seq << ", res=" << res << ")");
+    StaticGateOStream<m3::ostreamsize<Kernelcalls::Operation, Kernelcalls::OpStage, int, uintptr_t,
+        uint, m3::Errors::Code>()> msg;
+    msg << PARTITIONMIG << KREPLY << tid << migration << seq << res;
+    kernel->reply(msg.bytes(), msg.total());
+}
+
+void Kernelcalls::ddlLoad(KPE *kernel, size_t load) {
+    KLOG(KRNLC, "ddlLoad(kernelcore=" << kernel->core() << ", load=" << load << ")");
+    StaticGateOStream<m3::ostreamsize<Kernelcalls::Operation, size_t>()> msg;
+    msg << DDLLOAD << load;
     kernel->sendTo(msg.bytes(), msg.total());
 }
 
@@ -309,13 +364,25 @@ void Kernelcalls::announceSrv(KPE *kernel, mht_key_t id, const m3::String &name)
     kernel->sendTo(msg.bytes(), msg.total());
 }
 
-void Kernelcalls::revoke(KPE *kernel, mht_key_t capID, mht_key_t parent, mht_key_t originCap) {
-    KLOG(KRNLC, "revoke(kernelcore=" << kernel->core() << ", capID=" << PRINT_HASH(capID) <<
-        ", parent=" << PRINT_HASH(parent) << ", originCap=" << PRINT_HASH(capID) << ")");
-    CAP_BENCH_TRACE_X_S(KERNEL_REV_TO_RKERNEL);
-    StaticGateOStream<m3::ostreamsize<Kernelcalls::Operation, mht_key_t, mht_key_t, mht_key_t>()> msg;
-    msg << REVOKE << capID << parent << originCap;
-    kernel->sendRevocationTo(msg.bytes(), msg.total());
+void Kernelcalls::revoke(KPE *kernel, const mht_key_t *capIDs, size_t count, mht_key_t parent,
+        mht_key_t originCap) {
+    for(size_t off = 0; off < count; off += MAX_REVOKE_CAPS) {
+        size_t n = m3::Math::min(count - off, MAX_REVOKE_CAPS);
+        KLOG(KRNLC, "revoke(kernelcore=" << kernel->core() << ", caps=" << n << ", first="
+            << PRINT_HASH(capIDs[off]) << ", parent=" << PRINT_HASH(parent) << ", originCap="
+            << PRINT_HASH(originCap) << ")");
+        CAP_BENCH_TRACE_X_S(KERNEL_REV_TO_RKERNEL);
+        // revocations might be deeply nested, so don't put the message on the stack
+        size_t size = m3::vostreamsize(m3::ostreamsize<Kernelcalls::Operation, mht_key_t, mht_key_t,
+            size_t>(), n * m3::ostreamsize<mht_key_t>());
+        unsigned char *buf = static_cast<unsigned char*>(m3::Heap::alloc(size));
+        GateOStream msg(buf, size);
+        msg << REVOKE << parent << originCap << n;
+        for(size_t i = off; i < off + n; ++i)
+            msg << capIDs[i];
+        kernel->sendRevocationTo(msg.bytes(), msg.total());
+        m3::Heap::free(buf);
+    }
 }
 
 void Kernelcalls::revokeFinish(KPE *kernel, mht_key_t initiator, int awaits, bool includeReply) {
@@ -350,18 +417,17 @@ void Kernelcalls::shutdown(KPE *kernel, OpStage stage) {
         kernel->sendTo(msg.bytes(), msg.total());
 }
 
-void Kernelcalls::announceKrnls(KPE* kernel, membership_entry::krnl_id_t exception) {
-    KLOG(KRNLC, "announceKrnls(kernelcore=" << kernel->core() << ", exception=" << exception << ")");
+void Kernelcalls::announceKrnls(KPE* kernel) {
+    KLOG(KRNLC, "announceKrnls(kernelcore=" << kernel->core() << ")");
     Coordinator &coord = Coordinator::get();
-    uint amount = coord._kpes.size();
+    uint amount = coord._krnls.size();
     AutoGateOStream msg(m3::vostreamsize(
         m3::ostreamsize<Kernelcalls::Operation, uint>(),
         m3::ostreamsize<membership_entry::krnl_id_t, membership_entry::pe_id_t>() * amount));
     msg << ANNOUNCEKRNLS << amount;
-    for(auto it = coord._kpes.begin(); it != coord._kpes.end(); it++)
-        if(it->val->id() != exception)
-            msg << static_cast<membership_entry::krnl_id_t>(it->val->id()) <<
-                static_cast<membership_entry::pe_id_t>( it->val->core());
+    for(auto it = coord._krnls.begin(); it != coord._krnls.end(); it++)
+        msg << static_cast<membership_entry::krnl_id_t>(it->id) <<
+            static_cast<membership_entry::pe_id_t>(it->val);
 
     kernel->reply(msg.bytes(), msg.total());
 }
@@ -392,13 +458,18 @@ void Kernelcalls::connect(membership_entry::krnl_id_t kid, membership_entry::pe_
 }
 
 void Kernelcalls::connect(KPE *kernel, OpStage stage, membership_entry::krnl_id_t myKid,
-    membership_entry::pe_id_t myCore, int epid) {
+    membership_entry::pe_id_t myCore, int epid, uint numPEs, MembershipFlags flags, m3::PEDesc PEs[]) {
     KLOG(KRNLC, "connect(kernelcore=" << kernel->core() << ", stage=" <<
-        (stage == OpStage::KREQUEST ? "reque" : "reply") << ", epid=" << epid << ")");
+        (stage == OpStage::KREQUEST ? "reque" : "reply") << ", epid=" << epid <<
+        ", numPEs=" << numPEs << ")");
 
-    StaticGateOStream<m3::ostreamsize<Kernelcalls::Operation, OpStage, membership_entry::krnl_id_t,
-        membership_entry::pe_id_t, int>()> msg;
-    msg << CONNECT << stage << myKid << myCore << epid;
+    AutoGateOStream msg(m3::vostreamsize(
+        m3::ostreamsize<Kernelcalls::Operation, OpStage, membership_entry::krnl_id_t,
+        membership_entry::pe_id_t, int, MembershipFlags, uint>(),
+        numPEs * m3::ostreamsize<m3::PEDesc::value_t>()));
+    msg << CONNECT << stage << myKid << myCore << epid << flags << numPEs;
+    for(size_t i = 0; i < numPEs; i++)
+        msg << PEs[i].value();
 
     kernel->reply(msg.bytes(), msg.total());
 }
@@ -21,6 +21,7 @@
 #include <base/util/String.h>
 #include <base/util/CapRngDesc.h>
 #include <base/Errors.h>
+#include <base/Heap.h>
 #include <base/PEDesc.h>
 
 #include "Gate.h"
@@ -29,11 +30,42 @@
 namespace kernel {
 
 class KPE;
+class BatchGateOStream;
+
+/**
+ * The state of a batched DDL operation (MHTGETV, MHTPUTV, MHTLOCKV, MHTUNLOCKV) with one kernel.
+ * It lives on the stack of the requesting thread and its address is sent along with the request,
+ * so that the reply can be stored directly in the result arrays. If not all entries fit into one
+ * message, the remaining ones are sent with further requests. Entries for keys the kernel does not
+ * maintain (anymore) are answered with INV_ARGS and the kernel that is responsible for them now.
+ */
+struct DDLBatch {
+    explicit DDLBatch(size_t _count, m3::Errors::Code *_results)
+        : count(_count), answered(0), keys(nullptr), items(nullptr), values(nullptr),
+          data(nullptr), owners(nullptr), results(_results) {
+    }
+
+    size_t count;
+    size_t answered;
+    // MHTGETV, MHTLOCKV, MHTUNLOCKV: the keys
+    const mht_key_t *keys;
+    // MHTPUTV: the items
+    MHTItem **items;
+    // MHTLOCKV: the received lock handles; MHTUNLOCKV, MHTPUTV: the lock handles to use (optional)
+    uint *values;
+    // MHTGETV: the data of the received items
+    void **data;
+    // the responsible kernel for the entries that have been answered with INV_ARGS
+    membership_entry::krnl_id_t *owners;
+    m3::Errors::Code *results;
+};
 
 class Kernelcalls {
 public:
     static constexpr size_t MSG_SIZE         = 2048;
     static constexpr size_t MSG_ORD   = m3::nextlog2<MSG_SIZE>::val;
+    // the space for the payload of a message (KPE::sendTo requires it to be less than MSG_SIZE)
+    static constexpr size_t MAX_PAYLOAD = MSG_SIZE - m3::DTU::HEADER_SIZE - DTU_PKG_SIZE;
 
     enum Operation {
         SIGVITAL,
@@ -69,6 +101,11 @@ public:
         CONNECT,
         REPLYKRNLC,
         STARTAPPS,
+        MHTGETV,
+        MHTPUTV,
+        MHTLOCKV,
+        MHTUNLOCKV,
+        DDLLOAD,
         COUNT
     };
 
@@ -78,6 +115,14 @@ public:
         KFORWARD
     };
 
+    // the number of PE ranges that fit into a MEMBERUPDATE message
+    static constexpr size_t MAX_MEMBER_RANGES = (MAX_PAYLOAD - m3::ostreamsize<Operation,
+        membership_entry::krnl_id_t, membership_entry::pe_id_t, MembershipFlags, uint>()) /
+        m3::ostreamsize<membership_entry::pe_id_t, membership_entry::capacity_t>();
+    // the number of capabilities that fit into a REVOKE message
+    static constexpr size_t MAX_REVOKE_CAPS = (MAX_PAYLOAD - m3::ostreamsize<Operation, mht_key_t,
+        mht_key_t, size_t>()) / m3::ostreamsize<mht_key_t>();
+
     static Kernelcalls &get() {
         return _inst;
     }
@@ -91,7 +136,11 @@ private:
     }
 
 public:
-    void sigvital(KPE* kernel, int creatorThread, m3::Errors::Code err);
+    /**
+     * Tells our creator that we are alive or, the second time, ready. With <krnls>, the cores of
+     * the kernels we started during the boot are included.
+     */
+    void sigvital(KPE* kernel, int creatorThread, m3::Errors::Code err, bool krnls = false);
     m3::Errors::Code kcreatevpe(KPE* kernel, OpStage stage, m3::String&& name, const char* core, int tid);
     void kexit(KPE* kernel, int exitcode);
 
@@ -122,10 +171,49 @@ public:
     // Note: releasing is not acknowledged
     void mhtRelease(KPE* kernel, mht_key_t mht_key, uint reservation);
 
-    void membershipUpdate(KPE *kernel, m3::PEDesc releasedPEs[], uint numPEs,
+    /**
+     * Sends the not yet answered entries of <batch> to <kernel>, as many as fit into one message.
+     * The KernelcallHandler stores the results in <batch> and notifies the current thread.
+     *
+     * @param kernel    the kernel that maintains the keys
+     * @param op        MHTGETV, MHTPUTV, MHTLOCKV or MHTUNLOCKV
+     * @param batch     the batch
+     */
+    void mhtBatchRequest(KPE* kernel, Operation op, DDLBatch &batch);
+
+    /**
+     * Tells <kernel> that <krnl> is responsible for the given PE ranges now. The ranges are sent
+     * as (first PE, number of PEs) pairs, so that an update for many contiguous PEs fits into a
+     * single message. Only if there are more than MAX_MEMBER_RANGES ranges, multiple messages are
+     * sent.
+     *
+     * @param kernel    the receiver
+     * @param ranges    the PE ranges (pe_id and capacity)
+     * @param numRanges the number of ranges
+     * @param krnl      the new owner
+     * @param krnlCore  the core of the new owner
+     * @param flags     the new flags
+     */
+    void membershipUpdate(KPE *kernel, const membership_entry ranges[], size_t numRanges,
         membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags);
 
-    void migratePartition(KPE *kernel, AutoGateOStream &payload);
+    /**
+     * Sends a chunk of a partition migration (see MHTInstance::migratePartition). The receiver
+     * acknowledges each chunk with migratePartitionAck.
+     *
+     * @param kernel    the receiver of the partition
+     * @param chunk     the chunk
+     */
+    void migratePartition(KPE *kernel, BatchGateOStream &chunk);
+    void migratePartitionAck(KPE *kernel, int tid, uintptr_t migration, uint seq, m3::Errors::Code res);
+
+    /**
+     * Tells <kernel> the DDL load of this kernel in the last epoch (see MHTRebalancer).
+     *
+     * @param kernel    the receiver
+     * @param load      the number of accesses to our partitions
+     */
+    void ddlLoad(KPE *kernel, size_t load);
 
     void createSessFwd(KPE *kernel, int vpeID, m3::String &srvname, mht_key_t cap, GateOStream args);
     void createSessResp(KPE *kernel, int vpeID, int tid, m3::Errors::Code res, word_t sess, mht_key_t srvCap);
@@ -144,18 +232,38 @@ public:
 
     void announceSrv(KPE *kernel, mht_key_t id, const m3::String &name);
 
-    void revoke(KPE *kernel, mht_key_t capID, mht_key_t parent, mht_key_t originCap);
+    /**
+     * Asks <kernel> to revoke the given children of <parent>. Instead of one message per child,
+     * the children are sent in one message, or in multiple ones if there are more than
+     * MAX_REVOKE_CAPS. The kernel confirms all children it could revoke right away with a single
+     * REVOKEFINISH; the others are confirmed individually once their subtrees are revoked.
+     *
+     * @param kernel    the kernel that is responsible for the children
+     * @param capIDs    the IDs of the children
+     * @param count     the number of children
+     * @param parent    the capability that is being revoked
+     * @param originCap the root of the revocation
+     */
+    void revoke(KPE *kernel, const mht_key_t *capIDs, size_t count, mht_key_t parent,
+        mht_key_t originCap);
+    /**
+     * Tells <kernel> that <-awaits> children of <initiator> have been revoked.
+     */
     void revokeFinish(KPE *kernel, mht_key_t initiator, int awaits, bool includeReply);
 
     void requestShutdown(KPE *kernel, OpStage stage);
     void shutdown(KPE *kernel, OpStage stage);
 
-    void announceKrnls(KPE *kernel, membership_entry::krnl_id_t exception);
+    /**
+     * Sends the IDs and cores of all kernels to <kernel>
+     */
+    void announceKrnls(KPE *kernel);
     void connect(membership_entry::krnl_id_t kid, membership_entry::pe_id_t core, OpStage stage,
         membership_entry::krnl_id_t myKid, membership_entry::pe_id_t myCore, int epid,
         uint numPEs, MembershipFlags flags, m3::PEDesc releasedPEs[]);
     void connect(KPE *kernel, OpStage stage, membership_entry::krnl_id_t myKid,
-        membership_entry::pe_id_t myCore, int epid);
+        membership_entry::pe_id_t myCore, int epid, uint numPEs, MembershipFlags flags,
+        m3::PEDesc PEs[]);
 
     void reply(KPE *krnl);
 
@@ -168,4 +276,37 @@ private:
     static Kernelcalls _inst;
 };
 
+/**
+ * A kernelcall message with a variable number of entries, i.e., a batched DDL operation or a
+ * PARTITIONMIG chunk. The buffer is on the heap, because our thread stacks are too small for
+ * messages of MSG_SIZE. The number of entries is written into the header when the message is
+ * complete, so that entries can be appended as long as there is space for them.
+ */
+class BatchGateOStream : public GateOStream {
+public:
+    explicit BatchGateOStream(Kernelcalls::Operation op, Kernelcalls::OpStage stage, int tid,
+        uintptr_t batch)
+        : GateOStream(static_cast<unsigned char*>(m3::Heap::alloc(Kernelcalls::MAX_PAYLOAD)),
+                      Kernelcalls::MAX_PAYLOAD) {
+        *this << op << stage << tid << batch;
+        _countPos = _bytecount;
+        *this << static_cast<size_t>(0);
+    }
+    BatchGateOStream(const BatchGateOStream &) = delete;
+    BatchGateOStream &operator=(const BatchGateOStream &) = delete;
+    ~BatchGateOStream() {
+        m3::Heap::free(_bytes);
+    }
+
+    bool has_space(size_t bytes) const {
+        return _bytecount + bytes <= _total;
+    }
+    void finish(size_t entries) {
+        *reinterpret_cast<size_t*>(_bytes + _countPos) = entries;
+    }
+
+private:
+    size_t _countPos;
+};
+
 }
@@ -55,6 +55,7 @@ public:
         MemPEDesc mem_mods[MAX_MEM_MODS];
         size_t memOffset;
         uintptr_t memberTable;
+        size_t memberTableSize;
         uintptr_t ddlPartitions;
         size_t ddlPartitionsSize;
     } PACKED;
@@ -115,6 +116,9 @@ public:
     static uint64_t ddl_member_table() {
         return _kenv.memberTable;
     }
+    static size_t ddl_member_table_size() {
+        return _kenv.memberTableSize;
+    }
     static uint64_t ddl_partitions() {
         return _kenv.ddlPartitions;
     }
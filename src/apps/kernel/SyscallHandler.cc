@@ -25,7 +25,9 @@
 
 #include "pes/PEManager.h"
 #include "com/Services.h"
+#include "cap/Revocations.h"
 #include "com/RecvBufs.h"
+#include "com/SyscallRing.h"
 #include "Platform.h"
 #include "SyscallHandler.h"
 #include "Coordinator.h"
@@ -142,6 +144,10 @@ SyscallHandler::SyscallHandler() : _serv_ep(DTU::get().alloc_ep()) {
     add_operation(m3::KIF::Syscall::REVOKE, &SyscallHandler::revoke);
     add_operation(m3::KIF::Syscall::EXIT, &SyscallHandler::exit);
     add_operation(m3::KIF::Syscall::NOOP, &SyscallHandler::noop);
+    add_operation(m3::KIF::Syscall::REVOKEASYNC, &SyscallHandler::revokeasync);
+    add_operation(m3::KIF::Syscall::BATCH, &SyscallHandler::batch);
+    add_operation(m3::KIF::Syscall::SETUPRING, &SyscallHandler::setupring);
+    add_operation(m3::KIF::Syscall::DOORBELL, &SyscallHandler::doorbell);
 #if defined(__host__)
     add_operation(m3::KIF::Syscall::COUNT, &SyscallHandler::init);
 #endif
@@ -176,6 +182,9 @@ void SyscallHandler::createsrv(GateIStream &is) {
         int_target = vpe->pid();
 #endif
 
+    // make the service known to the other kernels
+    s->publish();
+
     // maybe there are VPEs that now have all requirements fullfilled
     // Hack: don't propagate pipe services for the sake of simulation time
     if(!name.contains("pipe"))
@@ -296,18 +305,26 @@ void SyscallHandler::createsess(GateIStream &is) {
         m3::Errors::Code res;
 
         vpe->srvLookupResult(nullptr);
-        // check if service has been announced before
-        RemoteServiceList::RemoteService *remoteSrv = RemoteServiceList::get().find(name);
-        if(remoteSrv) {
+        // the service directory tells us which kernel hosts the service
+        mht_key_t srvId = RemoteServiceList::get().lookup(name);
+        // an entry that points to us is outdated, because we don't know the service
+        if(srvId && MHTInstance::getInstance().responsibleMember(srvId) != Coordinator::get().kid()) {
             Kernelcalls::get().createSessFwd(Coordinator::get().getKPE(
-                MHTInstance::getInstance().responsibleMember(remoteSrv->id)),
+                MHTInstance::getInstance().responsibleMember(srvId)),
                 vpe->id(), name, sessCapId, msg);
 
             vpe->sessAwaitingResp(1);
             // wait for the response
             m3::ThreadManager::get().wait_for(reinterpret_cast<void*>(m3::ThreadManager::get().current()->id()));
         }
-        else if(!vpe->srvLookupResult()) {
+
+        if(!vpe->srvLookupResult()) {
+            // the directory entry might be outdated
+            if(srvId)
+                MHTInstance::getInstance().cache().invalidate(MHTInstance::getInstance().serviceKey(name));
+
+            // the service is not in the directory if its key was taken by another name. ask all
+            // kernels in this case and if the entry is outdated
             uint awaitedResp = Coordinator::get().broadcastCreateSess(vpe->id(), name, sessCapId, msg);
             // if no other kernels in the system the service isn't existing
             if(!awaitedResp)
@@ -927,6 +944,21 @@ void SyscallHandler::activate(GateIStream &is) {
 
     if(newcapobj && newcapobj->type() == Capability::MSG) {
         if(MHTInstance::getInstance().responsibleKrnl(newcapobj->obj->core) == Coordinator::get().kid()) {
+            if(!RecvBufs::is_attached(newcapobj->obj->core, newcapobj->obj->epid) &&
+                    is.capturing()) {
+                // the result is part of the reply to a batch. thus, we can't reply later on, but
+                // have to wait for the receive buffer here
+                int tid = m3::ThreadManager::get().current()->id();
+                bool attached = false;
+                RecvBufs::subscribe(newcapobj->obj->core, newcapobj->obj->epid,
+                    [tid, &attached](bool success, m3::Subscriber<bool> *) {
+                        attached = success;
+                        m3::ThreadManager::get().notify(reinterpret_cast<void*>(tid));
+                    });
+                m3::ThreadManager::get().wait_for(reinterpret_cast<void*>(tid));
+                if(!attached)
+                    SYS_ERROR(vpe, is, m3::Errors::RECV_GONE, "Receive buffer is gone");
+            }
             if(!RecvBufs::is_attached(newcapobj->obj->core, newcapobj->obj->epid)) {
                 ReplyInfo rinfo(is.message());
                 LOG_SYS(vpe, ": syscall::activate", ": waiting for receive buffer "
@@ -999,6 +1031,236 @@ void SyscallHandler::revoke(GateIStream &is) {
     reply_vmsg(is, m3::Errors::NO_ERROR);
 }
 
+void SyscallHandler::revokeasync(GateIStream &is) {
+    EVENT_TRACER_Syscall_revoke();
+    VPE *vpe = is.gate().session<VPE>();
+    m3::CapRngDesc crd;
+    bool own;
+    size_t ep;
+    label_t label;
+    word_t event;
+    is >> crd >> own >> ep >> label >> event;
+    LOG_SYS(vpe, ": syscall::revokeasync", "(" << crd << ", own=" << own << ", ep=" << ep
+        << ", label=" << m3::fmt(label, "#x") << ", event=" << m3::fmt(event, "#x") << ")");
+
+    if(crd.type() == m3::CapRngDesc::OBJ && crd.start() < 2)
+        SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Cap 0 and 1 are not revokeable");
+    if(ep >= EP_COUNT || !RecvBufs::is_attached(vpe->core(), ep))
+        SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "No receive buffer attached to EP " << ep);
+
+    // the reference of the syscall makes sure that no message is sent before we have replied
+    AsyncRevoke *async = new AsyncRevoke(vpe, ep, label, event);
+    async->pending++;
+
+    CapTable &table = crd.type() == m3::CapRngDesc::OBJ ? vpe->objcaps() : vpe->mapcaps();
+    m3::Errors::Code res = table.revoke(crd, own, async);
+
+    // if no remote revocation is outstanding, the reply is the completion notification
+    bool pending = --async->pending > 0;
+    if(!pending)
+        delete async;
+    if(res != m3::Errors::NO_ERROR)
+        SYS_ERROR(vpe, is, res, "Revoke failed");
+
+    reply_vmsg(is, m3::Errors::NO_ERROR, pending);
+}
+
+static bool batchable(m3::KIF::Syscall::Operation op) {
+    switch(op) {
+        case m3::KIF::Syscall::CREATESESSAT:
+        case m3::KIF::Syscall::CREATEGATE:
+        case m3::KIF::Syscall::CREATEMAP:
+        case m3::KIF::Syscall::ATTACHRB:
+        case m3::KIF::Syscall::DETACHRB:
+        case m3::KIF::Syscall::EXCHANGE:
+        case m3::KIF::Syscall::ACTIVATE:
+        case m3::KIF::Syscall::REQMEM:
+        case m3::KIF::Syscall::DERIVEMEM:
+        case m3::KIF::Syscall::REVOKE:
+        case m3::KIF::Syscall::NOOP:
+            return true;
+        default:
+            // the others reply with more than an error code or reply later on
+            return false;
+    }
+}
+
+static bool ringable(m3::KIF::Syscall::Operation op) {
+    switch(op) {
+        case m3::KIF::Syscall::EXCHANGE:
+        case m3::KIF::Syscall::ACTIVATE:
+        case m3::KIF::Syscall::REVOKE:
+            // these might wait for other kernels or receive buffers for an unbounded time. in a
+            // ring, this would stall all other rings, because they are drained by the same thread
+            return false;
+        default:
+            return batchable(op);
+    }
+}
+
+m3::Errors::Code SyscallHandler::execute(RecvGate &gate, m3::DTU::Message *msg, size_t len) {
+#if defined(__t3__)
+    msg->length = len / DTU_PKG_SIZE;
+#else
+    msg->length = len;
+#endif
+
+    m3::KIF::Syscall::Operation op = *reinterpret_cast<m3::KIF::Syscall::Operation*>(msg->data);
+    if(!batchable(op)) {
+        KLOG(ERR, gate.session<VPE>()->name() << ": operation " << op
+            << " is not supported in batches");
+        return m3::Errors::NOT_SUP;
+    }
+
+    m3::Errors::Code res;
+    GateIStream is(gate, msg);
+    // the message is acked as a whole by the caller
+    is.claim();
+    // capture the reply in the stream, not the gate: the handler might block and other messages
+    // on this gate have to be replied to as usual meanwhile
+    is.capture_reply(&res);
+    handle_message(is, nullptr);
+    assert(!is.capturing());
+    return res;
+}
+
+void SyscallHandler::batch(GateIStream &is) {
+    VPE *vpe = is.gate().session<VPE>();
+    size_t count;
+    bool stop;
+    if(is.remaining() < m3::ostreamsize<size_t, bool>())
+        SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Message too short");
+    is >> count >> stop;
+    LOG_SYS(vpe, ": syscall::batch", "(count=" << count << ", stop=" << stop << ")");
+
+    if(count > m3::KIF::Syscall::MAX_BATCH)
+        SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Too many operations");
+
+    // every operation gets a message of its own, so that we can use the usual handlers
+    m3::DTU::Message *sub = reinterpret_cast<m3::DTU::Message*>(
+        new uint8_t[m3::DTU::HEADER_SIZE + is.remaining()]);
+    memcpy(sub, &is.message(), m3::DTU::HEADER_SIZE);
+
+    m3::Errors::Code results[m3::KIF::Syscall::MAX_BATCH];
+    m3::Errors::Code res = m3::Errors::NO_ERROR;
+    size_t done = 0;
+    while(done < count) {
+        size_t len = 0;
+        if(is.remaining() >= m3::ostreamsize<size_t>())
+            is >> len;
+        if(len < sizeof(m3::KIF::Syscall::Operation) || len > is.remaining()) {
+            // the message is truncated or we can't find the next operation anymore
+            results[done++] = m3::Errors::INV_ARGS;
+            if(res == m3::Errors::NO_ERROR)
+                res = m3::Errors::INV_ARGS;
+            break;
+        }
+
+        memcpy(sub->data, is.buffer() + is.pos(), len);
+        is.skip(len);
+        results[done] = execute(is.gate(), sub, len);
+
+        if(results[done++] != m3::Errors::NO_ERROR) {
+            if(res == m3::Errors::NO_ERROR)
+                res = results[done - 1];
+            if(stop)
+                break;
+        }
+    }
+    delete[] reinterpret_cast<uint8_t*>(sub);
+
+    StaticGateOStream<m3::ostreamsize<m3::Errors::Code, size_t>() +
+        m3::KIF::Syscall::MAX_BATCH * m3::ostreamsize<m3::Errors::Code>()> reply;
+    reply << res << done;
+    for(size_t i = 0; i < done; ++i)
+        reply << results[i];
+    is.reply(reply);
+}
+
+void SyscallHandler::setupring(GateIStream &is) {
+    VPE *vpe = is.gate().session<VPE>();
+    capsel_t mem;
+    size_t slots;
+    is >> mem >> slots;
+    LOG_SYS(vpe, ": syscall::setupring", "(mem=" << mem << ", slots=" << slots << ")");
+
+    if(mem != m3::KIF::INV_SEL) {
+        if(slots == 0 || slots > m3::KIF::Syscall::Ring::MAX_SLOTS || (slots & (slots - 1)))
+            SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Invalid number of slots");
+        MemCapability *memcap = static_cast<MemCapability*>(
+            vpe->objcaps().get(mem, Capability::MEM));
+        if(memcap == nullptr || (memcap->perms() & m3::KIF::Perm::RW) != m3::KIF::Perm::RW)
+            SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Invalid memory cap");
+        if(memcap->size() < m3::KIF::Syscall::Ring::size(slots))
+            SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "Memory too small for the ring");
+    }
+
+    delete vpe->syscall_ring();
+    vpe->syscall_ring(mem != m3::KIF::INV_SEL ? new SyscallRing(vpe, mem, slots) : nullptr);
+    reply_vmsg(is, m3::Errors::NO_ERROR);
+}
+
+void SyscallHandler::doorbell(GateIStream &is) {
+    VPE *vpe = is.gate().session<VPE>();
+    LOG_SYS(vpe, ": syscall::doorbell", "()");
+
+    SyscallRing *ring = vpe->syscall_ring();
+    if(ring == nullptr)
+        SYS_ERROR(vpe, is, m3::Errors::INV_ARGS, "No syscall ring");
+
+    // the WorkLoop executes the entries and we reply as soon as it's done
+    ring->ring(is.message());
+}
+
+void SyscallHandler::drain_rings() {
+    // give every ring that is queued right now one turn
+    for(size_t n = SyscallRing::count(); n > 0; --n) {
+        SyscallRing *ring = SyscallRing::take();
+        if(!ring)
+            break;
+
+        // the entries might still block while a DDL partition they access is migrated. this parks
+        // the WorkLoop thread that drains the rings; the thread pool starts another one to keep
+        // handling messages (see ThreadManager::switch_next). don't let the VPE go away meanwhile
+        VPE *vpe = ring->vpe();
+        vpe->ref();
+
+        size_t count;
+        m3::Errors::Code res = ring->fetch(&count);
+        for(size_t i = 0; res == m3::Errors::NO_ERROR && i < count; ++i) {
+            const m3::KIF::Syscall::Ring::SQE &sqe = ring->entry(i);
+            m3::Errors::Code opres = m3::Errors::INV_ARGS;
+            if(sqe.length >= sizeof(m3::KIF::Syscall::Operation) && sqe.length <= sizeof(sqe.data)) {
+                auto op = *reinterpret_cast<const m3::KIF::Syscall::Operation*>(sqe.data);
+                if(!ringable(op)) {
+                    KLOG(ERR, vpe->name() << ": operation " << op << " is not supported in rings");
+                    opres = m3::Errors::NOT_SUP;
+                }
+                else {
+                    memcpy(ring->msg()->data, sqe.data, sqe.length);
+                    opres = execute(vpe->syscall_gate(), ring->msg(), sqe.length);
+                }
+            }
+            ring->complete(i, opres);
+        }
+        if(res == m3::Errors::NO_ERROR)
+            res = ring->commit(count);
+
+        if(vpe->state() == VPE::RUNNING) {
+            if(res != m3::Errors::NO_ERROR || ring->idle()) {
+                LOG_SYS(vpe, ": syscall::doorbell-done", "(res=" << res
+                    << ", completed=" << ring->completed() << ")");
+                ReplyInfo rinfo(ring->doorbell());
+                auto reply = kernel::create_vmsg(res, ring->completed());
+                reply_to_vpe(*vpe, rinfo, reply.bytes(), reply.total());
+            }
+            else
+                ring->queue();
+        }
+        vpe->unref();
+    }
+}
+
 void SyscallHandler::exit(GateIStream &is) {
     EVENT_TRACER_Syscall_exit();
     VPE *vpe = is.gate().session<VPE>();
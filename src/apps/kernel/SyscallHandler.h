@@ -82,6 +82,11 @@ public:
 
     void tryTerminate();
 
+    /**
+     * Executes the next entries of all syscall rings that have been rung (see SyscallRing)
+     */
+    void drain_rings();
+
     void pagefault(GateIStream &is);
     void createsrv(GateIStream &is);
     void createsess(GateIStream &is);
@@ -99,6 +104,10 @@ public:
     void reqmem(GateIStream &is);
     void derivemem(GateIStream &is);
     void revoke(GateIStream &is);
+    void revokeasync(GateIStream &is);
+    void batch(GateIStream &is);
+    void setupring(GateIStream &is);
+    void doorbell(GateIStream &is);
     void exit(GateIStream &is);
     void noop(GateIStream &is);
 
@@ -107,6 +116,8 @@ public:
 #endif
 
 private:
+    // executes the syscall in <msg> with <len> bytes for the VPE of <gate> and returns the result
+    m3::Errors::Code execute(RecvGate &gate, m3::DTU::Message *msg, size_t len);
     m3::Errors::Code do_exchange(VPE *v1, VPE *v2, const m3::CapRngDesc &c1, const m3::CapRngDesc &c2, bool obtain);
     void exchange_over_sess(GateIStream &is, bool obtain);
 
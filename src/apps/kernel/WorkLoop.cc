@@ -18,11 +18,15 @@
 #include <base/Common.h>
 #include <base/tracing/Tracing.h>
 #include <base/log/Kernel.h>
+#include <base/util/Profile.h>
 #include <base/WorkLoop.h>
 
 #include "KernelcallHandler.h"
 #include "SyscallHandler.h"
 #include "WorkLoop.h"
+#include "com/SyscallRing.h"
+#include "ddl/MHTInstance.h"
+#include "ddl/MHTRebalancer.h"
 #include "thread/ThreadManager.h"
 
 #if defined(__host__)
@@ -56,6 +60,30 @@ static void check_childs() {
 
 namespace kernel {
 
+static_assert(EP_COUNT <= 64, "Pending-message mask too small");
+
+#ifdef KERNEL_STATISTICS
+size_t WorkLoop::msgs = 0;
+cycles_t WorkLoop::busyCycles = 0;
+size_t WorkLoop::wakeups = 0;
+cycles_t WorkLoop::wakeupCycles = 0;
+#endif
+
+static inline uint64_t ep_bit(int ep) {
+    return static_cast<uint64_t>(1) << ep;
+}
+
+static inline void dispatched(UNUSED cycles_t &woken) {
+#ifdef KERNEL_STATISTICS
+    WorkLoop::msgs++;
+    if(woken) {
+        WorkLoop::wakeups++;
+        WorkLoop::wakeupCycles += m3::Profile::stop(0) - woken;
+        woken = 0;
+    }
+#endif
+}
+
 void WorkLoop::run() {
 #if defined(__host__)
     signal(SIGCHLD, sigchild);
@@ -66,44 +94,95 @@ void WorkLoop::run() {
     KernelcallHandler &krnlch = KernelcallHandler::get();
     SyscallHandler &sysch = SyscallHandler::get();
     m3::ThreadManager &tmng = m3::ThreadManager::get();
+    MHTRebalancer &rebalancer = MHTRebalancer::get();
+    MHTInstance &mht = MHTInstance::getInstance();
+    uint64_t krnlmask = 0;
     int krnlep[DTU::KRNLC_GATES];
     for(int i = 0; i < DTU::KRNLC_GATES; i++) {
         krnlep[i] = krnlch.epid(i);
+        krnlmask |= ep_bit(krnlep[i]);
     }
+    uint64_t sysmask = 0;
     int sysep[DTU::SYSC_GATES];
-    for(int i = 0; i < DTU::SYSC_GATES; i++)
+    for(int i = 0; i < DTU::SYSC_GATES; i++) {
         sysep[i] = sysch.epid(i);
+        sysmask |= ep_bit(sysep[i]);
+    }
     int srvep = sysch.srvepid();
     const m3::DTU::Message *msg;
     while(has_items()) {
-        m3::DTU::get().wait();
+        cycles_t woken = 0;
+        uint64_t pending = dtu.pending_msgs();
+        // don't sleep as long as there are messages or syscall rings to drain
+        if(!pending && !SyscallRing::pending()) {
+            // we're idle, so get rid of the threads that have been created for the last burst
+            if(tmng.pooled_count())
+                tmng.shrink();
+            dtu.wait();
+#ifdef KERNEL_STATISTICS
+            woken = m3::Profile::start(0);
+#endif
+            pending = dtu.pending_msgs();
+        }
+#ifdef KERNEL_STATISTICS
+        cycles_t passStart = pending ? m3::Profile::start(0) : 0;
+#endif
+        ulong epoch = mht.enterPass();
 
-        for(int i = 0; i < DTU::KRNLC_GATES; i++) {
-            msg = dtu.fetch_msg(krnlep[i]);
-            if(msg) {
-                GateIStream is(krnlch.rcvgate(i), msg);
-                krnlch.handle_message(is, nullptr);
+        if(pending & krnlmask) {
+            for(int i = 0; i < DTU::KRNLC_GATES; i++) {
+                if(!(pending & ep_bit(krnlep[i])))
+                    continue;
+                for(uint n = 0; n < DRAIN && (msg = dtu.fetch_msg(krnlep[i])); n++) {
+                    dispatched(woken);
+                    GateIStream is(krnlch.rcvgate(i), msg);
+                    krnlch.handle_message(is, nullptr);
+                }
             }
         }
 
-        for(int i = 0; i < DTU::SYSC_GATES; i++) {
-            msg = dtu.fetch_msg(sysep[i]);
-            if(msg) {
-                // we know the subscriber here, so optimize that a bit
-                RecvGate *rgate = reinterpret_cast<RecvGate*>(msg->label);
-                GateIStream is(*rgate, msg);
-                sysch.handle_message(is, nullptr);
-                EVENT_TRACE_FLUSH_LIGHT();
+        if(pending & sysmask) {
+            // start with a different gate in every pass
+            int first = _sysnext;
+            _sysnext = (_sysnext + 1) % DTU::SYSC_GATES;
+            for(int j = 0; j < DTU::SYSC_GATES; j++) {
+                int i = (first + j) % DTU::SYSC_GATES;
+                if(!(pending & ep_bit(sysep[i])))
+                    continue;
+                for(uint n = 0; n < DRAIN && (msg = dtu.fetch_msg(sysep[i])); n++) {
+                    dispatched(woken);
+                    // we know the subscriber here, so optimize that a bit
+                    RecvGate *rgate = reinterpret_cast<RecvGate*>(msg->label);
+                    GateIStream is(*rgate, msg);
+                    sysch.handle_message(is, nullptr);
+                    EVENT_TRACE_FLUSH_LIGHT();
+                }
             }
         }
 
-        msg = dtu.fetch_msg(srvep);
-        if(msg) {
-            RecvGate *gate = reinterpret_cast<RecvGate*>(msg->label);
-            GateIStream is(*gate, msg);
-            gate->notify_all(is);
+        // execute the next batch of entries of every syscall ring that has been rung
+        if(SyscallRing::pending())
+            sysch.drain_rings();
+
+        if(pending & ep_bit(srvep)) {
+            for(uint n = 0; n < DRAIN && (msg = dtu.fetch_msg(srvep)); n++) {
+                dispatched(woken);
+                RecvGate *gate = reinterpret_cast<RecvGate*>(msg->label);
+                GateIStream is(*gate, msg);
+                gate->notify_all(is);
+            }
         }
 
+#ifdef KERNEL_STATISTICS
+        if(passStart)
+            busyCycles += m3::Profile::stop(0) - passStart;
+#endif
+
+        // move hot DDL partitions to other kernels from time to time
+        rebalancer.tick();
+
+        // we don't use any DDL items anymore when we let others run
+        mht.leavePass(epoch);
         tmng.yield();
 #if defined(__host__)
         check_childs();
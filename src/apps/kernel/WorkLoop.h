@@ -19,11 +19,40 @@
 
 #include <base/WorkLoop.h>
 
+// the number of messages that are handled per endpoint and pass through the loop
+#ifndef KERNEL_DRAIN
+#   define KERNEL_DRAIN     4
+#endif
+
 namespace kernel {
 
+/**
+ * The loop that is run by all kernel threads. In every pass, it asks the DTU which endpoints have
+ * unread messages (m3::DTU::pending_msgs) and only fetches messages from those. Up to DRAIN
+ * messages are handled per endpoint and pass. The syscall endpoints are visited round-robin,
+ * starting with a different one in every pass, so that no group of VPEs is preferred.
+ */
 class WorkLoop : public m3::WorkLoop {
 public:
+    static const uint DRAIN     = KERNEL_DRAIN;
+
+    explicit WorkLoop() : m3::WorkLoop(), _sysnext() {
+    }
+
     virtual void run() override;
+
+#ifdef KERNEL_STATISTICS
+    // the number of handled messages and the cycles of the passes that handled them
+    static size_t msgs;
+    static cycles_t busyCycles;
+    // the number of times the loop woke up from an idle wait and the cycles until it dispatched
+    // the first message afterwards
+    static size_t wakeups;
+    static cycles_t wakeupCycles;
+#endif
+
+private:
+    int _sysnext;
 };
 
 }
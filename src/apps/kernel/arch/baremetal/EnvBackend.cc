@@ -58,7 +58,7 @@ public:
             m3::Math::round_up<size_t>(size, PAGE_SIZE) >> PAGE_BITS);
 
         // allocate memory
-        MainMemory::Allocation alloc = MainMemory::get().allocate(pages * PAGE_SIZE);
+        MainMemory::Allocation alloc = MainMemory::get().allocate(pages * PAGE_SIZE, PAGE_SIZE);
         if(!alloc)
             return false;
 
@@ -70,21 +70,7 @@ public:
         for(uint i = 0; i < pages; ++i)
             DTU::get().map_page(vpe, virt + i * PAGE_SIZE, phys + i * PAGE_SIZE, m3::KIF::Perm::RW);
 
-        // build new end Area and connect it
-        m3::Heap::Area *end = reinterpret_cast<m3::Heap::Area*>(virt + pages * PAGE_SIZE) - 1;
-        end->next = 0;
-        m3::Heap::Area *prev = m3::Heap::backwards(m3::Heap::_end, m3::Heap::_end->prev);
-        // if the last area is used, we have to keep _end and put us behind there
-        if(m3::Heap::is_used(prev)) {
-            end->prev = (end - m3::Heap::_end) * sizeof(m3::Heap::Area);
-            m3::Heap::_end->next = end->prev;
-        }
-        // otherwise, merge it into the last area
-        else {
-            end->prev = m3::Heap::_end->prev + pages * PAGE_SIZE;
-            prev->next += pages * PAGE_SIZE;
-        }
-        m3::Heap::_end = end;
+        m3::Heap::extend(virt + pages * PAGE_SIZE);
         return true;
     }
 
@@ -24,9 +24,9 @@
 
 namespace kernel {
 
-void KPE::start(int argc, char** argv, size_t pe_count, m3::PEDesc PEs[]) {
+void KPE::start(int argc, char** argv, size_t pe_count, m3::PEDesc PEs[], size_t krnls) {
 #if defined(__gem5__)
-    init_memory(argc, argv, pe_count, PEs);
+    init_memory(argc, argv, pe_count, PEs, krnls);
 #endif
 
     DTU::get().wakeup(VPEDesc(core(), VPE::INVALID_ID));
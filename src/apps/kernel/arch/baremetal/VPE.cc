@@ -19,6 +19,7 @@
 #include <base/log/Kernel.h>
 
 #include "com/RecvBufs.h"
+#include "com/SyscallRing.h"
 #include "pes/PEManager.h"
 #include "pes/VPE.h"
 #include "DTU.h"
@@ -90,6 +91,7 @@ VPE::~VPE() {
     DTU::get().invalidate_eps(desc());
     detach_rbufs();
     free_reqs();
+    delete _ring;
     _objcaps.revoke_all();
     _mapcaps.revoke_all();
     if(_as) {
@@ -18,16 +18,24 @@
 #include <base/stream/Serial.h>
 #include <base/tracing/Tracing.h>
 #include <base/log/Kernel.h>
+#include <base/util/Math.h>
 #include <base/DTU.h>
 #include <base/WorkLoop.h>
 #include <thread/ThreadManager.h>
 
 #include "com/RecvBufs.h"
 #include "mem/MainMemory.h"
+#include "mem/Slab.h"
 #include "pes/PEManager.h"
 #include "SyscallHandler.h"
 #include "Platform.h"
 
+// the maximum number of kernel threads. if all threads are blocked, e.g., waiting for other
+// kernels, more threads are created to keep handling messages
+#ifndef KERNEL_MAX_THREADS
+#   define KERNEL_MAX_THREADS   256
+#endif
+
 using namespace kernel;
 
 
@@ -35,6 +43,8 @@ void shutdown() {
     EVENT_TRACE_FLUSH();
 
     KLOG(INFO, "Shutting down kernel #" << Platform::kernelId());
+    if(m3::KernelLog::level & m3::KernelLog::SLAB)
+        Slab::print(m3::Serial::get());
 
     PEManager::destroy();
 
@@ -64,22 +74,30 @@ int main(int argc, char *argv[]) {
 
     RecvBufs::init();
     PEManager::create();
-    // if we have been created by another kernel, tell him we are alive
-    if(Coordinator::get().creator() != nullptr) {
-        KLOG(KRNLC, "Kernel #" << Platform::kernelId() << " is contacting its creator (kernel #" << Platform::creatorKernelId() << ")");
-        Kernelcalls::get().sigvital(Coordinator::get().creator(), Platform::creatorThread(), m3::Errors::NO_ERROR);
-    }
     // 1 thread per PE (maximum PEs = syscall gates * DTU message slots) + threads for k2k communication
     uint krnlThreads = ( (MHTInstance::getInstance().localPEs() < DTU::SYSC_GATES * m3::DTU::MAX_MSG_SLOTS) ?
         MHTInstance::getInstance().localPEs() : (DTU::SYSC_GATES * m3::DTU::MAX_MSG_SLOTS) ) + 1 +
         (DTU::KRNLC_GATES * m3::DTU::MAX_MSG_SLOTS / KernelcallHandler::MAX_MSG_INFLIGHT);
     for(uint i = 0; i < krnlThreads - 1; i++)
         new m3::Thread(kernel_thrd_entry, nullptr);
+    m3::ThreadManager::get().set_pool(kernel_thrd_entry, nullptr,
+        m3::Math::max<size_t>(krnlThreads, KERNEL_MAX_THREADS));
 
-    // after receiving information about other kernels by announceKrnls kernelcall
-    // this thread will be continued
-    if(Coordinator::get().creator() != nullptr)
+    // if we have been created by another kernel, start the kernels below us and tell him that we
+    // are alive afterwards
+    if(Coordinator::get().creator() != nullptr) {
+        int own = Coordinator::get().parseBootKrnls(argc, argv);
+        Coordinator::get().bootKrnls();
+
+        KLOG(KRNLC, "Kernel #" << Platform::kernelId() << " is contacting its creator (kernel #" << Platform::creatorKernelId() << ")");
+        Kernelcalls::get().sigvital(Coordinator::get().creator(), Platform::creatorThread(),
+            m3::Errors::NO_ERROR, true);
+
+        // after receiving information about other kernels by announceKrnls kernelcall
+        // this thread will be continued
         m3::ThreadManager::get().wait_for(reinterpret_cast<void*>(0));
+        argc = own;
+    }
 
     PEManager::get().load(argc - 1, argv + 1);
 
@@ -203,7 +203,7 @@ void DTU::map_page(const VPEDesc &vpe, uintptr_t virt, uintptr_t phys, int perm)
                     return;
 
                 // TODO this is prelimilary
-                MainMemory::Allocation alloc = MainMemory::get().allocate(PAGE_SIZE);
+                MainMemory::Allocation alloc = MainMemory::get().allocate(PAGE_SIZE, PAGE_SIZE);
                 assert(alloc);
 
                 pte = m3::DTU::build_noc_addr(alloc.pe(), alloc.addr) | m3::DTU::PTE_RWX;
@@ -146,7 +146,7 @@ uintptr_t load_kernel_mod(const VPEDesc &vpe, BootModule *mod, bool copy, bool n
     return header.e_entry;
 }
 
-void KPE::init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[]) {
+void KPE::init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[], size_t krnls) {
     static_assert(RT_SIZE > sizeof(m3::Env),
             "Runtime space too small for kernel environment");
     static_assert(KENV_SIZE > sizeof(Platform::KEnv),
@@ -167,6 +167,15 @@ void KPE::init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[])
     MemoryModule memfs(fsmod.available(), fsmod.pe(), fsmod.addr(), fsmod.size());
     kernMem.mem_mods[0] = &memfs;
     kernMem.mem_mods[1] = &mem;
+    // the memory for the kernels it starts is passed on in a module of its own. the kernel uses it
+    // last for allocations and first for detaching (see MainMemory)
+    MemoryModule memkrnls = krnls > 1 ? MainMemory::get().detach(KRNL_INIT_MEM_SIZE * (krnls - 1))
+                                      : MemoryModule(false, 0, 0, 0);
+    if(krnls > 1) {
+        if(!memkrnls.size())
+            PANIC("No memory available for the kernels below the new kernel");
+        kernMem.mem_mods[2] = &memkrnls;
+    }
 
     if(vm)
         kernMem.set_root_pt(m3::DTU::build_noc_addr(mem.pe(), mem.addr()));
@@ -259,11 +268,18 @@ void KPE::init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[])
 
     // copy memberTable and DDL partitions belonging to the PEs of the new kernel
     MHTInstance &mht = MHTInstance::getInstance();
+    // the membership table is transferred in its compact form, i.e., as PE ranges
+    kenv->memberTableSize = m3::Math::round_up<size_t>(mht.memberTable.serializedSize(), DTU_PKG_SIZE);
     kenv->memberTable = m3::Math::round_up<uintptr_t>(senv.kenv + sizeof(Platform::KEnv), DTU_PKG_SIZE);
-    kenv->ddlPartitions = m3::Math::round_up<uintptr_t>(kenv->memberTable + sizeof(membership_entry) * (1UL << PE_BITS), DTU_PKG_SIZE);
+    kenv->ddlPartitions = m3::Math::round_up<uintptr_t>(kenv->memberTable + kenv->memberTableSize, DTU_PKG_SIZE);
 
+    unsigned char *memberStore = static_cast<unsigned char*>(m3::Heap::alloc(kenv->memberTableSize));
+    if(!memberStore)
+        PANIC("No memory to serialize DDL membership table");
+    mht.memberTable.serialize(memberStore);
     DTU::get().write_mem(VPEDesc(0, 0), m3::DTU::noc_to_virt(kenv->memberTable),
-        mht.memberTable, m3::Math::round_up<size_t>(sizeof(membership_entry) * (1UL << PE_BITS), DTU_PKG_SIZE));
+        memberStore, kenv->memberTableSize);
+    m3::Heap::free(memberStore);
 
     // calculate size necessary for migrating DDL partitions
     MHTPartition *partitions[pe_count];
@@ -287,7 +303,7 @@ void KPE::init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[])
         partitionSize += partitions[partsFound]->serializedSize();
         partsFound++;
     }
-    assert(sizeof(Platform::KEnv) + partitionSize + (sizeof(membership_entry) * (1UL << PE_BITS)) <= KENV_SIZE);
+    assert(sizeof(Platform::KEnv) + partitionSize + kenv->memberTableSize <= KENV_SIZE);
 
     unsigned char *partitionStore = static_cast<unsigned char*>(m3::Heap::alloc(partitionSize));
     if(!partitionStore)
@@ -20,29 +20,35 @@
 
 namespace kernel {
 
-MHTInstance::MHTInstance(uint64_t memberTab, uint64_t parts, size_t partsSize)
-    : partitions(), _migratingPartitions()
+MHTInstance::MHTInstance(uint64_t memberTab, size_t memberTabSize, uint64_t parts, size_t partsSize)
+    : partitions(), memberTable(), _migratingPartitions(), _incomingPartitions(), _migratedItems(0),
+      _migrationCycles(0), _retiredPartitions(), _epoch(0), _activePasses(0)
 {
-    memberTable = new membership_entry[Platform::MAX_PES];
-    if(!memberTable)
-        PANIC("Not enought memory to create membership table");
     membership_entry::krnl_id_t kid = Platform::kernelId();
+    void *memberContent = m3::Heap::alloc(memberTabSize);
+    if(!memberContent)
+        PANIC("Not enought memory to create membership table");
     DTU::get().read_mem(VPEDesc(0, 0), m3::DTU::noc_to_virt(reinterpret_cast<uintptr_t>(memberTab)),
-        memberTable, sizeof(membership_entry) * (1UL << PE_BITS));
+        memberContent, memberTabSize);
+    if(!memberTable.deserialize(memberContent, memberTabSize))
+        PANIC("Invalid membership table");
+    m3::Heap::free(memberContent);
 
     void *partitionContent = m3::Heap::alloc(partsSize);
     DTU::get().read_mem(VPEDesc(0, 0), m3::DTU::noc_to_virt(reinterpret_cast<uintptr_t>(parts)),
         partitionContent, partsSize);
     m3::Unmarshaller input(const_cast<const unsigned char*>(reinterpret_cast<unsigned char*>(partitionContent)), partsSize);
-    for(size_t i = 0; i < (1L << PE_BITS); i++) {
-        if(memberTable[i].krnl_id == kid) {
+    for(membership_entry::pe_id_t i = 0; i < (1L << PE_BITS); i++) {
+        if(memberTable.krnl(i) == kid) {
             MHTPartition *part = new MHTPartition(i);
             part->deserialize(input);
             partitions.append(new PartitionEntry(part));
             // remove the MIGRATING status of partitions
-            memberTable[i].flags = static_cast<MembershipFlags>(
-                static_cast<uint8_t>(memberTable[i].flags) &
-                ~(MembershipFlags::MIGRATING));
+            MembershipFlags flags = memberTable.flags(i);
+            if(flags & MembershipFlags::MIGRATING) {
+                memberTable.set(i, 1, kid, static_cast<MembershipFlags>(
+                    static_cast<uint8_t>(flags) & ~(MembershipFlags::MIGRATING)));
+            }
         }
     }
     m3::Heap::free(partitionContent);
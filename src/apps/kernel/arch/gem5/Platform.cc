@@ -104,6 +104,7 @@ Platform::KEnv::KEnv(uintptr_t* _mods, size_t _pe_count, m3::PEDesc _pes[], uint
     }
     memOffset = _memOffset;
     memberTable = 0;
+    memberTableSize = 0;
     ddlPartitions = 0;
 }
 
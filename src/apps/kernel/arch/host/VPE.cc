@@ -24,6 +24,7 @@
 #include <cstring>
 #include <cerrno>
 
+#include "com/SyscallRing.h"
 #include "pes/PEManager.h"
 #include "pes/VPE.h"
 #include "SyscallHandler.h"
@@ -118,6 +119,7 @@ VPE::~VPE() {
     DTU::get().invalidate_eps(desc());
     detach_rbufs();
     free_reqs();
+    delete _ring;
 
     // revoke all caps first because we might need the sepsgate for that
     _objcaps.revoke_all();
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/util/Math.h>
+
+#include "cap/CapRadix.h"
+
+namespace kernel {
+
+CapRadix::~CapRadix() {
+    for(size_t d = 0; d < _dirSize; ++d)
+        delete _dir[d];
+    delete[] _dir;
+}
+
+void CapRadix::insert(Capability *c) {
+    capsel_t sel = c->sel();
+    if(sel >= MAX_DIRECT) {
+        _overflow.insert(c);
+        return;
+    }
+
+    size_t d = sel >> LEAF_BITS;
+    if(d >= _dirSize) {
+        size_t nsize = m3::Math::max<size_t>(_dirSize * 2, 8);
+        while(nsize <= d)
+            nsize *= 2;
+        Leaf **ndir = new Leaf*[nsize];
+        for(size_t i = 0; i < nsize; ++i)
+            ndir[i] = i < _dirSize ? _dir[i] : nullptr;
+        delete[] _dir;
+        _dir = ndir;
+        _dirSize = nsize;
+    }
+    if(!_dir[d])
+        _dir[d] = new Leaf();
+
+    Leaf *leaf = _dir[d];
+    assert(leaf->caps[sel & (LEAF_SIZE - 1)] == nullptr);
+    leaf->caps[sel & (LEAF_SIZE - 1)] = c;
+    leaf->count++;
+    if(d < _scan)
+        _scan = d;
+}
+
+void CapRadix::remove(Capability *c) {
+    capsel_t sel = c->sel();
+    if(sel >= MAX_DIRECT) {
+        _overflow.remove(c);
+        return;
+    }
+
+    size_t d = sel >> LEAF_BITS;
+    assert(d < _dirSize && _dir[d] && _dir[d]->caps[sel & (LEAF_SIZE - 1)] == c);
+    Leaf *leaf = _dir[d];
+    leaf->caps[sel & (LEAF_SIZE - 1)] = nullptr;
+    // free empty leaves, so that the memory stays proportional to the number of capabilities
+    if(--leaf->count == 0) {
+        delete leaf;
+        _dir[d] = nullptr;
+    }
+}
+
+Capability *CapRadix::remove_root() {
+    for(; _scan < _dirSize; ++_scan) {
+        Leaf *leaf = _dir[_scan];
+        if(!leaf)
+            continue;
+        for(size_t i = 0; i < LEAF_SIZE; ++i) {
+            Capability *c = leaf->caps[i];
+            if(c) {
+                remove(c);
+                return c;
+            }
+        }
+    }
+    return static_cast<Capability*>(_overflow.remove_root());
+}
+
+bool CapRadix::range_check(capsel_t start, uint count, bool used) const {
+    size_t sel = start;
+    size_t end = static_cast<size_t>(start) + count;
+    while(sel < end && sel < MAX_DIRECT) {
+        size_t d = sel >> LEAF_BITS;
+        size_t leafEnd = m3::Math::min(end, (d + 1) << LEAF_BITS);
+        Leaf *leaf = d < _dirSize ? _dir[d] : nullptr;
+        if(!leaf) {
+            if(used)
+                return false;
+        }
+        // a full leaf has only used selectors
+        else if(!used || leaf->count < LEAF_SIZE) {
+            for(; sel < leafEnd; ++sel) {
+                if((leaf->caps[sel & (LEAF_SIZE - 1)] != nullptr) != used)
+                    return false;
+            }
+        }
+        sel = leafEnd;
+    }
+    for(; sel < end; ++sel) {
+        if((_overflow.find(static_cast<capsel_t>(sel)) != nullptr) != used)
+            return false;
+    }
+    return true;
+}
+
+void CapRadix::print(m3::OStream &os, bool tree) const {
+    for(size_t d = 0; d < _dirSize; ++d) {
+        if(!_dir[d])
+            continue;
+        for(size_t i = 0; i < LEAF_SIZE; ++i) {
+            if(_dir[d]->caps[i]) {
+                _dir[d]->caps[i]->print(os);
+                os << "\n";
+            }
+        }
+    }
+    _overflow.print(os, tree);
+}
+
+}
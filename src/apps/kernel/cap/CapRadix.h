@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/col/Treap.h>
+
+#include "cap/Capability.h"
+
+namespace kernel {
+
+/**
+ * A two-level table of capabilities, indexed by selector, that can be used instead of the treap in
+ * CapTable (build with M3_CAPTABLE=radix). The selectors of a VPE are allocated densely, starting
+ * at 0. Thus, the table consists of a directory of leaves with LEAF_SIZE capability pointers each,
+ * which are allocated on demand. A lookup takes two memory accesses and range checks scan the
+ * pointer arrays of the leaves.
+ *
+ * The directory grows with the highest selector in use, but only up to MAX_DIRECT selectors. The
+ * remaining ones (e.g., the sparse page numbers of mapping capabilities) are kept in a treap.
+ */
+class CapRadix {
+    static const size_t LEAF_BITS   = 7;
+    static const size_t LEAF_SIZE   = 1 << LEAF_BITS;
+    static const size_t MAX_DIRECT  = 1 << 20;
+
+    struct Leaf {
+        explicit Leaf() : count() {
+            for(size_t i = 0; i < LEAF_SIZE; ++i)
+                caps[i] = nullptr;
+        }
+
+        Capability *caps[LEAF_SIZE];
+        size_t count;
+    };
+
+public:
+    explicit CapRadix() : _dir(nullptr), _dirSize(), _scan(), _overflow() {
+    }
+    CapRadix(const CapRadix &) = delete;
+    CapRadix &operator=(const CapRadix &) = delete;
+    ~CapRadix();
+
+    Capability *find(capsel_t sel) const {
+        if(sel >= MAX_DIRECT)
+            return _overflow.find(sel);
+        size_t d = sel >> LEAF_BITS;
+        if(d >= _dirSize || !_dir[d])
+            return nullptr;
+        return _dir[d]->caps[sel & (LEAF_SIZE - 1)];
+    }
+
+    /**
+     * Inserts <c> at its selector, which has to be unused.
+     */
+    void insert(Capability *c);
+    /**
+     * Removes <c> from the table.
+     */
+    void remove(Capability *c);
+    /**
+     * Removes an arbitrary capability and returns it.
+     *
+     * @return the capability or nullptr if the table is empty
+     */
+    Capability *remove_root();
+
+    /**
+     * @return true if none of the selectors <start> .. <start> + <count> - 1 is in use
+     */
+    bool range_empty(capsel_t start, uint count) const {
+        return range_check(start, count, false);
+    }
+    /**
+     * @return true if all of the selectors <start> .. <start> + <count> - 1 are in use
+     */
+    bool range_full(capsel_t start, uint count) const {
+        return range_check(start, count, true);
+    }
+
+    void print(m3::OStream &os, bool tree = true) const;
+
+private:
+    bool range_check(capsel_t start, uint count, bool used) const;
+
+    Leaf **_dir;
+    size_t _dirSize;
+    // no leaf before this one contains capabilities (see remove_root)
+    size_t _scan;
+    m3::Treap<Capability> _overflow;
+};
+
+}
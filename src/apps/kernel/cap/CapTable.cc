@@ -15,6 +15,8 @@
  * General Public License version 2 for more details.
  */
 
+#include <string.h>
+
 #include <base/util/Util.h>
 #include <base/log/Kernel.h>
 #include <base/benchmark/capbench.h>
@@ -58,16 +60,126 @@ void CapTable::setparent_and_set(mht_key_t parent, Capability *child, capsel_t d
     set(dst, child);
 }
 
-int CapTable::revoke_rec(Capability *c, mht_key_t origin, m3::CapRngDesc::Type type) {
-    mht_key_t parent = (type == m3::CapRngDesc::Type::OBJ) ?
-        (c->_parent | TYPE_MASK_OCAP) : (c->_parent | TYPE_MASK_MCAP);
-    mht_key_t id = (type == m3::CapRngDesc::Type::OBJ) ?
-        (c->_id | TYPE_MASK_OCAP) : (c->_id | TYPE_MASK_MCAP);
-    Revocation *ongoing = nullptr;
+/**
+ * The work list of CapTable::revoke_tree, which holds the capabilities of the revoked subtree in
+ * breadth-first order. It lives on the heap, so that the depth of the capability tree is not limited
+ * by the stack size of the kernel threads. The remote children of the current level are collected
+ * as well, so that they are sent after the level has been revoked (see CapTable::revoke_remote).
+ */
+class RevokeList {
+    struct Node {
+        mht_key_t key;
+        size_t parent;
+        // whether we revoked it; otherwise it was under revocation already or did not exist
+        bool revoked;
+    };
+    struct Remote {
+        mht_key_t key;
+        membership_entry::krnl_id_t krnl;
+        size_t node;
+    };
+
+public:
+    static constexpr size_t NO_PARENT = static_cast<size_t>(-1);
+
+    explicit RevokeList(mht_key_t mask, mht_key_t origin)
+        : _nodes(nullptr), _count(), _size(), _remote(nullptr), _remoteCount(), _remoteSize(),
+          _mask(mask), _origin(origin) {
+    }
+    RevokeList(const RevokeList &) = delete;
+    RevokeList &operator=(const RevokeList &) = delete;
+    ~RevokeList() {
+        delete[] _remote;
+        delete[] _nodes;
+    }
+
+    size_t length() const {
+        return _count;
+    }
+    mht_key_t origin() const {
+        return _origin;
+    }
+    mht_key_t key(size_t idx) const {
+        return _nodes[idx].key;
+    }
+    // the generic cap ID that is used for the revocation entries
+    mht_key_t id(size_t idx) const {
+        return _nodes[idx].key | _mask;
+    }
+    size_t parent(size_t idx) const {
+        return _nodes[idx].parent;
+    }
+    bool revoked(size_t idx) const {
+        return _nodes[idx].revoked;
+    }
+    void set_revoked(size_t idx) {
+        _nodes[idx].revoked = true;
+    }
+
+    void append(mht_key_t key, size_t parent) {
+        if(_count == _size) {
+            size_t nsize = _size ? _size * 2 : 16;
+            Node *nnodes = new Node[nsize];
+            if(_count)
+                memcpy(nnodes, _nodes, _count * sizeof(Node));
+            delete[] _nodes;
+            _nodes = nnodes;
+            _size = nsize;
+        }
+        _nodes[_count++] = {key, parent, false};
+    }
+
+    size_t remote_count() const {
+        return _remoteCount;
+    }
+    Remote &remote(size_t idx) {
+        return _remote[idx];
+    }
+    void append_remote(mht_key_t key, membership_entry::krnl_id_t krnl, size_t node) {
+        if(_remoteCount == _remoteSize) {
+            size_t nsize = _remoteSize ? _remoteSize * 2 : 16;
+            Remote *nremote = new Remote[nsize];
+            if(_remoteCount)
+                memcpy(nremote, _remote, _remoteCount * sizeof(Remote));
+            delete[] _remote;
+            _remote = nremote;
+            _remoteSize = nsize;
+        }
+        _remote[_remoteCount++] = {key, krnl, node};
+    }
+    void clear_remote() {
+        _remoteCount = 0;
+    }
+
+    // returns the ongoing revocation of the given node, which is created if necessary. Note that the
+    // entry of the root is always present.
+    Revocation *revocation(size_t idx) const {
+        Revocation *rev = RevocationList::get().find(id(idx));
+        if(!rev) {
+            assert(_nodes[idx].parent != NO_PARENT);
+            rev = RevocationList::get().add(id(idx), id(_nodes[idx].parent), _origin);
+        }
+        return rev;
+    }
+
+private:
+    Node *_nodes;
+    size_t _count;
+    size_t _size;
+    Remote *_remote;
+    size_t _remoteCount;
+    size_t _remoteSize;
+    mht_key_t _mask;
+    mht_key_t _origin;
+};
+
+void CapTable::revoke_node(RevokeList &nodes, size_t idx, Capability *c) {
+    mht_key_t id = nodes.id(idx);
+    nodes.set_revoked(idx);
 
     // reset the child-pointer since we're revoking all childs
     // note that we would need to do much more if delegatable capabilities could deny a revoke
-    m3::SList<Capability::Child> children = m3::Util::move(c->_children);
+    ChildSet children(m3::Util::move(c->_children));
 
     m3::Errors::Code res = c->revoke();
     // actually, this is a bit specific for service+session. although it failed to revoke the service
@@ -83,82 +195,147 @@ int CapTable::revoke_rec(Capability *c, mht_key_t origin, m3::CapRngDesc::Type t
     // TODO
     // change revocation of service capabilities so revoke is actually error free
 
-    for(auto it : children) {
-        membership_entry::krnl_id_t authority = MHTInstance::getInstance().responsibleMember(it.id);
-        if(authority == Coordinator::get().kid()) {
-            const MHTItem &childIt = MHTInstance::getInstance().get(it.id);
-            if(childIt.isEmpty()) {
+    // the local children are revoked with the next level, the remote ones by their kernels.
+    // We expect the responses before sending anything, because sending might block and let
+    // responses in.
+    size_t numRemote = 0;
+    for(mht_key_t child : children) {
+        membership_entry::krnl_id_t authority = MHTInstance::getInstance().responsibleMember(child);
+        if(authority == Coordinator::get().kid())
+            nodes.append(child, idx);
+        else {
+            nodes.append_remote(child, authority, idx);
+            numRemote++;
+        }
+    }
+    if(numRemote)
+        nodes.revocation(idx)->awaitedResp += static_cast<int>(numRemote);
+}
+
+void CapTable::revoke_remote(RevokeList &nodes) {
+    // every kernel gets a single request per node for all children it is responsible for and
+    // confirms the ones it revoked right away with a single response. The children of a node
+    // are contiguous in the list.
+    for(size_t i = 0; i < nodes.remote_count(); ) {
+        size_t node = nodes.remote(i).node;
+        // move the children of the same node and kernel to the front
+        size_t end = i + 1;
+        for(size_t j = end; j < nodes.remote_count() && nodes.remote(j).node == node; ++j) {
+            if(nodes.remote(j).krnl == nodes.remote(i).krnl)
+                m3::Util::swap(nodes.remote(end++), nodes.remote(j));
+        }
+
+        mht_key_t *ids = new mht_key_t[end - i];
+        for(size_t j = i; j < end; ++j)
+            ids[j - i] = nodes.remote(j).key;
+        Kernelcalls::get().revoke(Coordinator::get().getKPE(nodes.remote(i).krnl), ids, end - i,
+            nodes.id(node), nodes.origin());
+        delete[] ids;
+        i = end;
+    }
+    nodes.clear_remote();
+}
+
+int CapTable::revoke_tree(Capability *c, mht_key_t origin, m3::CapRngDesc::Type type,
+        AsyncRevoke *async) {
+    mht_key_t mask = (type == m3::CapRngDesc::Type::OBJ) ? TYPE_MASK_OCAP : TYPE_MASK_MCAP;
+    mht_key_t parent = c->_parent | mask;
+    mht_key_t id = c->_id | mask;
+
+    // Responses to our requests arrive as soon as this thread blocks, i.e., while we are still
+    // walking through the subtree. Thus, we hold a reference to the entry of the root that
+    // prevents them from finishing the revocation early.
+    Revocation *ongoing = RevocationList::get().add(id, parent, origin);
+    ongoing->awaitedResp++;
+
+    // revoke the subtree level by level. The local children of a level are fetched at once and
+    // the requests for the remote children are sent afterwards, because sending might block and
+    // the fetched capabilities might be revoked by someone else meanwhile.
+    RevokeList nodes(mask, origin);
+    nodes.append(c->_id, RevokeList::NO_PARENT);
+    for(size_t level = 0; level < nodes.length(); ) {
+        size_t end = nodes.length();
+        size_t count = end - level;
+        mht_key_t *keys = new mht_key_t[count];
+        void **caps = new void*[count];
+        m3::Errors::Code *res = new m3::Errors::Code[count];
+        if(level == 0)
+            caps[0] = c;
+        else {
+            for(size_t i = level; i < end; ++i)
+                keys[i - level] = nodes.key(i);
+            MHTInstance::getInstance().getv(keys, count, caps, res);
+        }
+
+        for(size_t i = level; i < end; ++i) {
+            if(level == 0 || res[i - level] == m3::Errors::NO_ERROR)
+                revoke_node(nodes, i, static_cast<Capability*>(caps[i - level]));
+            else {
                 // check whether this child is part of an ongoing revocation
-                Revocation *childRevoke = RevocationList::get().find(childIt.getKey());
+                Revocation *childRevoke = RevocationList::get().find(nodes.id(i));
                 if(childRevoke) {
-                    if(!ongoing)
-                        ongoing = RevocationList::get().add(id, parent, origin);
-                    childRevoke->subscribe(ongoing);
-                    ongoing->awaitedResp++;
-                }
-            }
-            else {
-                int add = revoke_rec(childIt.getData<Capability>(), origin, type);
-                // If the revocation of that child caused remote requests,
-                // we have to subscribe to that revocation.
-                if(add) {
-                    if(!ongoing)
-                        ongoing = RevocationList::get().add(id, parent, origin);
-                    ongoing->awaitedResp += add;
-                    RevocationList::get().find(it.id)->subscribe(ongoing);
+                    Revocation *rev = nodes.revocation(nodes.parent(i));
+                    childRevoke->subscribe(rev);
+                    rev->awaitedResp++;
                 }
             }
         }
-        else {
-            if(!ongoing)
-                ongoing = RevocationList::get().add(id, parent, origin);
-            ongoing->awaitedResp++;
-            Kernelcalls::get().revoke(Coordinator::get().getKPE(authority), it.id, id, origin);
-        }
+        delete[] res;
+        delete[] caps;
+        delete[] keys;
+        revoke_remote(nodes);
+        level = end;
     }
 
-    // Once all directly reachable children are done, check if some of them were remote.
+    // Now that all nodes are revoked, check if some of them wait for remote responses. Each of
+    // them subscribes to its parent, which waits for it in turn. Since the list is in breadth-first
+    // order, all children of a node are handled before the node itself. The entries that are gone
+    // have been finished while we were walking through the subtree.
+    // The root is handled below:
     // 1. If we are the revocation root this thread is going to wait for incoming responses.
-    // 2. If we are not the revocation root: (TL;DR: do nothing)
-    // 2.1. If the parent is local, the number of awaited responses will be returned by
-    //      revoke_rec() and thus added to the parent's awaitedResp counter.
-    // 2.2. If the parent is remote this thread is done.
-    //      The incoming responses will be handled by the KernelcallHandler.
-
-
+    // 2. If we are not the revocation root, the parent is remote and this thread is done.
+    //    The incoming responses will be handled by the KernelcallHandler.
+    for(size_t i = nodes.length() - 1; i > 0; --i) {
+        Revocation *rev = nodes.revoked(i) ? RevocationList::get().find(nodes.id(i)) : nullptr;
+        if(rev) {
+            Revocation *prev = nodes.revocation(nodes.parent(i));
+            rev->subscribe(prev);
+            prev->awaitedResp++;
+        }
+    }
 
+    // drop our reference
+    int awaited = --ongoing->awaitedResp;
     if(id == origin) {
-        if(ongoing) {
-            if( ongoing->awaitedResp > 0) { // remote revokes appeared
-                // wait for the outstanding revokes to finish
-                int mytid = m3::ThreadManager::get().current()->id();
-                m3::ThreadManager::get().wait_for(reinterpret_cast<void*>(mytid));
-                CAP_BENCH_TRACE_X_F(KERNEL_REV_THRD_WAKEUP);
-                // this thread will be notified once all responses arrived
-                KLOG(KRNLC, "Continued revoke for cap " << PRINT_HASH(id) << ". Finishing revoke");
+        if(awaited > 0) { // remote revokes appeared
+            if(async) {
+                // the syscall returns now; whoever finishes the last remote revoke finishes ours
+                ongoing->tid = -1;
+                ongoing->async = async;
+                async->pending++;
+                return 0;
             }
-        // remove ongoing entry
-            ongoing->notifySubscribers();
-            RevocationList::get().remove(id);
-            ongoing = nullptr;
-        }
 
-        // revocation finished, tell parent to removes the child ptr to this cap
-        if(parent & ~TYPE_MASK_CAP) {
-            membership_entry::krnl_id_t parentAuthority =
-                MHTInstance::getInstance().responsibleKrnl(HashUtil::hashToPeId(parent));
-            if(parentAuthority == Coordinator::get().kid())
-                MHTInstance::getInstance().get(parent).getData<Capability>()->removeChildAllTypes(id);
-            else
-                Kernelcalls::get().removeChildCapPtr(Coordinator::get().getKPE(parentAuthority),
-                    DDLCapRngDesc(parent, 1), DDLCapRngDesc(id, 1));
+            // wait for the outstanding revokes to finish
+            int mytid = m3::ThreadManager::get().current()->id();
+            m3::ThreadManager::get().wait_for(reinterpret_cast<void*>(mytid));
+            CAP_BENCH_TRACE_X_F(KERNEL_REV_THRD_WAKEUP);
+            // this thread will be notified once all responses arrived
+            KLOG(KRNLC, "Continued revoke for cap " << PRINT_HASH(id) << ". Finishing revoke");
         }
+        RevocationList::get().finish_root(ongoing);
+        return 0;
     }
 
-    return ongoing ? ongoing->awaitedResp : 0;
+    if(awaited == 0) {
+        // there is nothing to wait for, but others might have subscribed in the meantime
+        ongoing->notifySubscribers();
+        RevocationList::get().remove(id);
+    }
+    return awaited;
 }
 
-int CapTable::revoke(Capability *c, mht_key_t capID, mht_key_t origin) {
+int CapTable::revoke(Capability *c, mht_key_t capID, mht_key_t origin, AsyncRevoke *async) {
     int res = 0;
     if(_type == m3::CapRngDesc::Type::OBJ)
         origin |= TYPE_MASK_OCAP;
@@ -166,7 +343,7 @@ int CapTable::revoke(Capability *c, mht_key_t capID, mht_key_t origin) {
         origin |= TYPE_MASK_MCAP;
 
     if(c) {
-        res = revoke_rec(c, origin, _type);
+        res = revoke_tree(c, origin, _type, async);
     }
     else {
         // check whether this cap is currently being revoked
@@ -189,7 +366,13 @@ int CapTable::revoke(Capability *c, mht_key_t capID, mht_key_t origin) {
             ongoingRevoke->subscribe(subscriber);
 
 
-            if(capID == origin) {
+            if(capID == origin && async) {
+                // finish_root notifies the syscall once the revocation we subscribed to is done
+                subscriber->tid = -1;
+                subscriber->async = async;
+                async->pending++;
+            }
+            else if(capID == origin) {
                 // If this cap is the revocation root, this thread waits for it to finish.
                 // Otherwise this revoke was initiated by a request from another kernel.
                 // The parent of the capability will be informed by the kernelcall handler
@@ -208,7 +391,7 @@ int CapTable::revoke(Capability *c, mht_key_t capID, mht_key_t origin) {
     return res;
 }
 
-m3::Errors::Code CapTable::revoke(const m3::CapRngDesc &crd, bool own) {
+m3::Errors::Code CapTable::revoke(const m3::CapRngDesc &crd, bool own, AsyncRevoke *async) {
     for(capsel_t i = 0; i < crd.count(); ++i) {
         m3::Errors::Code res = m3::Errors::NO_ERROR;
         if(own) {
@@ -223,7 +406,7 @@ m3::Errors::Code CapTable::revoke(const m3::CapRngDesc &crd, bool own) {
                 cap ? cap->_id :
                     HashUtil::structured_hash(_id, _id,
                         (_type == m3::CapRngDesc::Type::MAP) ? ItemType::GENERICOCAP : ItemType::MAPCAP,
-                        i + crd.start()));
+                        i + crd.start()), async);
         }
         else {
             Capability *c = get(i + crd.start());
@@ -25,10 +25,15 @@
 #include "com/Services.h"
 #include "cap/Capability.h"
 #include "cap/Revocations.h"
+#if defined(CAPTABLE_RADIX)
+#   include "cap/CapRadix.h"
+#endif
 
 namespace kernel {
 
 class CapTable;
+class RevokeList;
+struct AsyncRevoke;
 
 m3::OStream &operator<<(m3::OStream &os, const CapTable &ct);
 
@@ -63,32 +68,41 @@ public:
     bool range_unused(const m3::CapRngDesc &crd) const {
         if(!range_valid(crd))
             return false;
+#if defined(CAPTABLE_RADIX)
+        return _caps.range_empty(crd.start(), crd.count());
+#else
         for(capsel_t i = crd.start(); i < crd.start() + crd.count(); ++i) {
             if(get(i) != nullptr)
                 return false;
         }
         return true;
+#endif
     }
     bool range_used(const m3::CapRngDesc &crd) const {
         if(!range_valid(crd))
             return false;
+#if defined(CAPTABLE_RADIX)
+        return _caps.range_full(crd.start(), crd.count());
+#else
         for(capsel_t i = crd.start(); i < crd.start() + crd.count(); ++i) {
             if(get(i) == nullptr)
                 return false;
         }
         return true;
+#endif
     }
 
     Capability *obtain(capsel_t dst, Capability *c);
     void inherit_and_set(Capability *parent, Capability *child, capsel_t dst);
     void setparent_and_set(mht_key_t parent, Capability *child, capsel_t dst);
 
-    // this function is called by the SyscallHandler when starting a revocation
-    m3::Errors::Code revoke(const m3::CapRngDesc &crd, bool own);
+    // this function is called by the SyscallHandler when starting a revocation. if <async> is
+    // given, it does not wait for remote revocations, but lets <async> know when they are done
+    m3::Errors::Code revoke(const m3::CapRngDesc &crd, bool own, AsyncRevoke *async = nullptr);
 
     // that's the revoke that is called by both the revoke(CapRngDesc, bool) function
     // and the KernelcallHandler when it receives a revoke request
-    int revoke(Capability *c, mht_key_t capID, mht_key_t origin);
+    int revoke(Capability *c, mht_key_t capID, mht_key_t origin, AsyncRevoke *async = nullptr);
 
     Capability *get(capsel_t i) {
         return _caps.find(i);
@@ -139,14 +153,22 @@ public:
     void revoke_all();
 
 private:
-    static int revoke_rec(Capability *c, mht_key_t origin, m3::CapRngDesc::Type type);
+    // revokes <c> and its subtree without recursion (see RevokeList)
+    static int revoke_tree(Capability *c, mht_key_t origin, m3::CapRngDesc::Type type,
+        AsyncRevoke *async);
+    static void revoke_node(RevokeList &nodes, size_t idx, Capability *c);
+    static void revoke_remote(RevokeList &nodes);
     bool range_valid(const m3::CapRngDesc &crd) const {
         return crd.count() == 0 || crd.start() + crd.count() > crd.start();
     }
 
     uint _id;
     m3::CapRngDesc::Type _type;
+#if defined(CAPTABLE_RADIX)
+    CapRadix _caps;
+#else
     m3::Treap<Capability> _caps;
+#endif
     m3::SList<Reservation> _reserved;
 };
 
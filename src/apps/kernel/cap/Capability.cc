@@ -29,51 +29,15 @@ m3::OStream &operator<<(m3::OStream &os, const Capability &cc) {
 }
 
 void Capability::addChild(mht_key_t child) {
-    // sort list w.r.t locality
-    // local items are put first
-    if (MHTInstance::getInstance().keyLocality(child) || _children.length() == 0) {
-        _children.insert(nullptr, new Child(child));
-        return;
-    }
-
-    // sort other kernels' capabilities
-    membership_entry::pe_id_t peID = HashUtil::hashToPeId(child);
-    Child *prev = &*_children.begin();
-    membership_entry::krnl_id_t current_respKrnl = 0;
-    membership_entry::krnl_id_t respKrnl = 0;
-    respKrnl = MHTInstance::getInstance().responsibleKrnl(peID);
-    if(respKrnl <= MHTInstance::getInstance().responsibleMember(prev->id)) {
-        _children.insert(nullptr, new Child(child));
-        return;
-    }
-    for(auto &it : _children) {
-        current_respKrnl = MHTInstance::getInstance().responsibleMember(it.id);
-        if(respKrnl >= current_respKrnl) {
-            _children.insert(prev, new Child(child));
-            return;
-        }
-        prev = &it;
-    }
+    _children.insert(child);
 }
 
 void Capability::removeChild(mht_key_t child) {
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if(it->id == child) {
-            _children.remove(&*it);
-            delete &*it;
-            return;
-        }
-    }
+    _children.remove(child);
 }
 
 void Capability::removeChildAllTypes(mht_key_t child) {
-    for(auto it = _children.begin(); it != _children.end(); it++) {
-        if((it->id & ~TYPE_MASK_CAP) == (child & ~TYPE_MASK_CAP)) {
-            _children.remove(&*it);
-            delete &*it;
-            return;
-        }
-    }
+    _children.removeAllTypes(child);
 }
 
 size_t Capability::serializedSizeTyped(Capability *cap) {
@@ -225,7 +189,7 @@ void MsgCapability::print(m3::OStream &os) const {
        << ", crd=#" << m3::fmt(obj->credits, "x") << "], parent=["
        << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -237,7 +201,7 @@ void MemCapability::print(m3::OStream &os) const {
        << ", crd=#" << m3::fmt(obj->credits, "x") << "], parent=["
        << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -248,7 +212,7 @@ void MapCapability::print(m3::OStream &os) const {
        << ", attr=#" << m3::fmt(attr, "x") << "], parent=["
        << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -257,7 +221,7 @@ void ServiceCapability::print(m3::OStream &os) const {
     os << ": serv[name=" << inst->name() << "], parent=["
        << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -269,7 +233,7 @@ void SessionCapability::print(m3::OStream &os) const {
         << ", servowned=" << obj->servowned << "], parent=["
         << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -280,7 +244,7 @@ void VPECapability::print(m3::OStream &os) const {
     os << ", parent=["
        << PRINT_HASH(parent()) << "], chld=[ ";
     for(auto it : children())
-        os << PRINT_HASH(it.id) << " ";
+        os << PRINT_HASH(it) << " ";
     os << "]";
 }
 
@@ -289,7 +253,7 @@ void Capability::printChilds(m3::OStream &os, int layer) const {
     os << m3::fmt("", layer * 2) << " \\-";
     print(os);
     for(auto it : _children)
-        os << PRINT_HASH(it.id);
+        os << PRINT_HASH(it);
 }
 
 }
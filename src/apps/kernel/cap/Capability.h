@@ -26,6 +26,7 @@
 #include <base/util/Reference.h>
 #include <base/col/SList.h>
 
+#include "cap/ChildSet.h"
 #include "com/Services.h"
 #include "ddl/MHTTypes.h"
 #include "mem/SlabCache.h"
@@ -57,12 +58,6 @@ public:
         VIRTPE  = 0x20,
     };
 
-    struct Child : public SlabObject<Child>, public m3::SListItem {
-        explicit Child(mht_key_t _id) : id(_id) {
-        }
-        mht_key_t id;
-    };
-
     explicit Capability(CapTable *tbl, capsel_t sel, unsigned type, mht_key_t capid)
         : TreapNode<capsel_t>(sel), _type(type), _id(capid), _tbl(tbl), _parent(), _children() {
     }
@@ -74,10 +69,6 @@ public:
         _parent(rhs._parent), _children() {
     }
     virtual ~Capability() {
-        for(auto it = _children.begin(); it != _children.end(); ) {
-            auto old = it++;
-            delete &*old;
-        }
     }
 
     unsigned type() {
@@ -104,10 +95,10 @@ public:
     mht_key_t parent() const {
         return _parent;
     }
-    m3::SList<Child> &children() {
+    ChildSet &children() {
         return _children;
     }
-    const m3::SList<Child> &children() const {
+    const ChildSet &children() const {
         return _children;
     }
     void addChild(mht_key_t child);
@@ -184,7 +175,7 @@ protected:
 private:
     CapTable *_tbl;
     mht_key_t _parent;
-    m3::SList<Child> _children;
+    ChildSet _children;
 };
 
 class MsgObject : public SlabObject<MsgObject>, public m3::RefCounted {
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include "cap/ChildSet.h"
+
+namespace kernel {
+
+void ChildSet::insert(mht_key_t id) {
+    if(!_table) {
+        if(_count < INLINE_CHILDS) {
+            _inline[_count++] = id;
+            return;
+        }
+
+        // the array is full; switch to the hash table
+        _table = new table_t(INLINE_CHILDS * 4);
+        for(size_t i = 0; i < _count; ++i)
+            _table->insert(key(_inline[i]), new Child(_inline[i]));
+        _count = 0;
+    }
+
+    Child *old = _table->insert(key(id), new Child(id));
+    if(old)
+        delete old;
+}
+
+bool ChildSet::remove(mht_key_t id) {
+    if(!_table) {
+        for(size_t i = 0; i < _count; ++i) {
+            if(_inline[i] == id) {
+                _inline[i] = _inline[--_count];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Child *c = _table->find(key(id));
+    if(!c || c->id != id)
+        return false;
+    delete _table->remove(key(id));
+    return true;
+}
+
+bool ChildSet::removeAllTypes(mht_key_t id) {
+    // try the kind of capability the ID belongs to first
+    mht_key_t base = id & ~TYPE_MASK_CAP;
+    mht_key_t keys[] = {key(id), (id & TYPE_MASK_MCAP) ? base : (base | TYPE_MASK_MCAP)};
+    for(mht_key_t k : keys) {
+        if(!_table) {
+            for(size_t i = 0; i < _count; ++i) {
+                if(key(_inline[i]) == k) {
+                    _inline[i] = _inline[--_count];
+                    return true;
+                }
+            }
+        }
+        else {
+            Child *c = _table->remove(k);
+            if(c) {
+                delete c;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ChildSet::clear() {
+    if(_table) {
+        for(auto it = _table->begin(); it != _table->end(); ++it)
+            delete &*it;
+        delete _table;
+        _table = nullptr;
+    }
+    _count = 0;
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/col/HashTable.h>
+
+#include "ddl/MHTTypes.h"
+#include "mem/SlabCache.h"
+
+namespace kernel {
+
+/**
+ * The IDs of the children of a capability. Most capabilities have no or only a few children, which
+ * are stored in a small inline array. Capabilities of servers, however, often have thousands of
+ * children. Thus, once the array is full, the children are moved to a hash table, so that adding
+ * and removing a child is O(1) in both cases. The order of the children is unspecified.
+ *
+ * The hash table is keyed by the ID without the object capability type bits, because a child can be
+ * removed without knowing its type (see removeAllTypes). Since object and mapping capabilities are
+ * still distinguished by the MCAP bit, the keys are unique.
+ */
+class ChildSet {
+    struct Child : public SlabObject<Child> {
+        explicit Child(mht_key_t _id) : id(_id) {
+        }
+        mht_key_t id;
+    };
+
+    using table_t = m3::HashTable<mht_key_t, Child>;
+
+public:
+    static const size_t INLINE_CHILDS = 4;
+
+    class iterator {
+        friend class ChildSet;
+
+        explicit iterator(const ChildSet *set, size_t idx, table_t::const_iterator it)
+            : _set(set), _idx(idx), _it(it) {
+        }
+
+    public:
+        mht_key_t operator*() const {
+            return _set->_table ? _it->id : _set->_inline[_idx];
+        }
+        iterator &operator++() {
+            if(_set->_table)
+                ++_it;
+            else
+                ++_idx;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp(*this);
+            operator++();
+            return tmp;
+        }
+        bool operator==(const iterator &rhs) const {
+            return _idx == rhs._idx && _it == rhs._it;
+        }
+        bool operator!=(const iterator &rhs) const {
+            return !operator==(rhs);
+        }
+
+    private:
+        const ChildSet *_set;
+        size_t _idx;
+        table_t::const_iterator _it;
+    };
+
+    explicit ChildSet() : _count(), _table(nullptr) {
+    }
+    ChildSet(ChildSet &&s) : _count(s._count), _table(s._table) {
+        for(size_t i = 0; i < _count && !_table; ++i)
+            _inline[i] = s._inline[i];
+        s._count = 0;
+        s._table = nullptr;
+    }
+    ChildSet(const ChildSet &) = delete;
+    ChildSet &operator=(const ChildSet &) = delete;
+    ~ChildSet() {
+        clear();
+    }
+
+    size_t length() const {
+        return _table ? _table->length() : _count;
+    }
+
+    iterator begin() const {
+        if(_table)
+            return iterator(this, 0, static_cast<const table_t*>(_table)->begin());
+        return iterator(this, 0, table_t::const_iterator());
+    }
+    iterator end() const {
+        return iterator(this, _table ? 0 : _count, table_t::const_iterator());
+    }
+
+    /**
+     * Adds the child <id>.
+     */
+    void insert(mht_key_t id);
+
+    /**
+     * Removes the child <id>.
+     *
+     * @return true if it was found
+     */
+    bool remove(mht_key_t id);
+
+    /**
+     * Removes the child whose ID matches <id> except for the capability type bits.
+     *
+     * @return true if it was found
+     */
+    bool removeAllTypes(mht_key_t id);
+
+    /**
+     * Removes all children.
+     */
+    void clear();
+
+private:
+    static mht_key_t key(mht_key_t id) {
+        return id & ~TYPE_MASK_OCAP;
+    }
+
+    size_t _count;
+    table_t *_table;
+    mht_key_t _inline[INLINE_CHILDS];
+};
+
+}
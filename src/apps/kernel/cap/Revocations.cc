@@ -15,51 +15,111 @@
  * General Public License version 2 for more details.
  */
 
+#include "cap/Capability.h"
 #include "cap/Revocations.h"
+#include "com/RecvBufs.h"
 #include "ddl/MHTInstance.h"
+#include "pes/VPE.h"
+#include "DTU.h"
+#include "Gate.h"
 
 namespace kernel {
 
 RevocationList RevocationList::_inst;
 
+AsyncRevoke::AsyncRevoke(VPE *_vpe, size_t _ep, label_t _label, word_t _event)
+    : vpe(_vpe), ep(_ep), label(_label), event(_event), pending() {
+    // keep the VPE alive until it has been notified
+    vpe->ref();
+}
+
+AsyncRevoke::~AsyncRevoke() {
+    vpe->unref();
+}
+
+void AsyncRevoke::finished() {
+    if(--pending > 0)
+        return;
+
+    // the VPE might have exited or detached the receive buffer in the meantime
+    if(vpe->state() == VPE::RUNNING && RecvBufs::is_attached(vpe->core(), ep)) {
+        auto msg = kernel::create_vmsg(event, m3::Errors::NO_ERROR);
+        DTU::get().send_to(vpe->desc(), ep, label, msg.bytes(), msg.total(), 0, 0);
+    }
+    delete this;
+}
+
 void Revocation::notifySubscribers() {
     for (auto sub = subscribers.begin(); sub != subscribers.end();) {
         auto curSub = sub++;
-        for (auto it = RevocationList::get().begin(); it != RevocationList::get().end(); it++) {
-            if (it->capID == curSub->rev->capID) {
-                it->awaitedResp--;
-
-                if (it->awaitedResp == 0) {
-                    // notify our subscribers too
-                    // Note: this will inform local parents
-                    it->notifySubscribers();
-
-                    // If the parent is local
-                    membership_entry::krnl_id_t parentAuthority =
-                        MHTInstance::getInstance().responsibleKrnl(HashUtil::hashToPeId(it->parent));
-
-                    // if there is a thread ID this is the entry of a revocation root
-                    if(it->tid != -1) {
-                        assert(it->capID == it->origin);
-                        m3::ThreadManager::get().notify(reinterpret_cast<void*> (it->tid));
-                    }
-                    else if(parentAuthority != Coordinator::get().kid()) {
-                        // we only need to inform remote parents here
-                        // if we have a local parent it subscribed to this
-                        // revocation before and is informed by notifySubscribers()
-                        assert(it->parent != 0);
-                        Kernelcalls::get().revokeFinish(Coordinator::get().getKPE(parentAuthority),
-                            it->parent, -1, false);
-                    }
-                }
-
-                subscribers.remove(&*curSub);
-                delete &*curSub;
-                break;
+        Revocation *it = curSub->rev;
+        it->awaitedResp--;
+
+        if (it->awaitedResp == 0 && it->async) {
+            // the root of an asynchronous revoke, which no thread waits for
+            RevocationList::get().finish_root(it);
+        }
+        else if (it->awaitedResp == 0) {
+            // notify our subscribers too
+            // Note: this will inform local parents
+            it->notifySubscribers();
+
+            // If the parent is local
+            membership_entry::krnl_id_t parentAuthority =
+                MHTInstance::getInstance().responsibleKrnl(HashUtil::hashToPeId(it->parent));
+
+            // if there is a thread ID this is the entry of a revocation root
+            if(it->tid != -1) {
+                assert(it->capID == it->origin);
+                m3::ThreadManager::get().notify(reinterpret_cast<void*> (it->tid));
             }
+            else if(parentAuthority != Coordinator::get().kid()) {
+                // we only need to inform remote parents here
+                // if we have a local parent it subscribed to this
+                // revocation before and is informed by notifySubscribers()
+                assert(it->parent != 0);
+                Kernelcalls::get().revokeFinish(Coordinator::get().getKPE(parentAuthority),
+                    it->parent, -1, false);
+            }
+
+            // the entry is finished now, unless the waiting thread removes it
+            if(it->tid == -1 && RevocationList::get().find(it->capID) == it)
+                RevocationList::get().remove(it->capID);
         }
+
+        subscribers.remove(&*curSub);
+        delete &*curSub;
     }
 }
 
+void RevocationList::finish_root(Revocation *rev) {
+    mht_key_t id = rev->capID;
+    mht_key_t parent = rev->parent;
+    AsyncRevoke *async = rev->async;
+
+    if(find(id) != rev) {
+        // we only subscribed to the revocation of someone else, who does the rest
+        delete rev;
+    }
+    else {
+        rev->notifySubscribers();
+        remove(id);
+
+        // revocation finished, tell parent to removes the child ptr to this cap
+        if(parent & ~TYPE_MASK_CAP) {
+            membership_entry::krnl_id_t parentAuthority =
+                MHTInstance::getInstance().responsibleKrnl(HashUtil::hashToPeId(parent));
+            if(parentAuthority == Coordinator::get().kid())
+                MHTInstance::getInstance().get(parent).getData<Capability>()->removeChildAllTypes(id);
+            else
+                Kernelcalls::get().removeChildCapPtr(Coordinator::get().getKPE(parentAuthority),
+                    DDLCapRngDesc(parent, 1), DDLCapRngDesc(id, 1));
+        }
+    }
+
+    if(async)
+        async->finished();
+}
+
 
 }
@@ -18,22 +18,49 @@
 #pragma once
 
 #include <base/col/SList.h>
+#include <base/col/HashTable.h>
 
 #include "ddl/MHTTypes.h"
+#include "mem/SlabCache.h"
 
 namespace kernel {
 
+class VPE;
 struct Revocation;
 
-struct RevocationSub : m3::SListItem {
+/**
+ * An asynchronous revoke syscall. Instead of blocking the syscall until all remote revocations are
+ * finished, the roots of the unfinished revocations refer to this object. As soon as the last of
+ * them is finished, the VPE receives a message with <event> and <label> on its receive EP <ep>.
+ */
+struct AsyncRevoke : public SlabObject<AsyncRevoke> {
+    explicit AsyncRevoke(VPE *_vpe, size_t _ep, label_t _label, word_t _event);
+    ~AsyncRevoke();
+
+    /**
+     * Marks one of the revocations as finished and notifies the VPE if it was the last one.
+     * The object is deleted afterwards.
+     */
+    void finished();
+
+    VPE *vpe;
+    size_t ep;
+    label_t label;
+    word_t event;
+    int pending; // the number of unfinished revocations
+};
+
+struct RevocationSub : public m3::SListItem, public SlabObject<RevocationSub> {
     explicit RevocationSub(Revocation *_rev) : rev(_rev) {}
 
+    // the subscribed revocation itself, which stays in the RevocationList until it is finished
     Revocation *rev;
 };
 
-struct Revocation : m3::SListItem {
+struct Revocation : public SlabObject<Revocation> {
     explicit Revocation(mht_key_t _capID, mht_key_t _parent, mht_key_t _origin, int _awaitedResp, int _tid)
-    : capID(_capID), parent(_parent), origin(_origin), awaitedResp(_awaitedResp), tid(_tid), subscribers() {
+    : capID(_capID), parent(_parent), origin(_origin), awaitedResp(_awaitedResp), tid(_tid), async(),
+      subscribers() {
 #ifndef NDEBUG
         // correctness checks
         // we only use generic cap IDs for revocations
@@ -60,48 +87,51 @@ struct Revocation : m3::SListItem {
     mht_key_t capID;
     mht_key_t parent;
     mht_key_t origin; // cap which started revocation
-    int awaitedResp; // own awaited resps
+    int awaitedResp; // own awaited resps, i.e., the number of children not confirmed yet
     int tid; // tid of origin's thread
+    AsyncRevoke *async; // the syscall to notify, if origin's thread does not wait
     m3::SList<RevocationSub> subscribers; // revocations waiting for this one to finish
 };
 
+/**
+ * The ongoing revocations of this kernel, indexed by the generic cap ID (see find).
+ */
 class RevocationList {
-    explicit RevocationList() : _list() {
+    explicit RevocationList() : _revocations() {
     }
 public:
 
-    using iterator = m3::SList<Revocation>::iterator;
+    using iterator = m3::HashTable<mht_key_t, Revocation>::iterator;
 
     static RevocationList &get() {
         return _inst;
     }
 
     iterator begin() {
-        return _list.begin();
+        return _revocations.begin();
     }
     iterator end() {
-        return _list.end();
+        return _revocations.end();
+    }
+
+    size_t length() const {
+        return _revocations.length();
     }
 
     Revocation *add(mht_key_t cap, mht_key_t parent, mht_key_t origin) {
-#ifndef NDEBUG
+        Revocation *rev = new Revocation(cap, parent, origin, 0,
+                (origin == cap) ? m3::ThreadManager::get().current()->id() : -1);
         // make sure there's only one entry per cap ID, otherwise the revoke algorithm fails
-        for(auto &it : _list)
-            if(it.capID == cap)
-                PANIC("Cannot insert second entry for revocation of cap: " << PRINT_HASH(cap));
-#endif
-        return &*_list.append(new Revocation(cap, parent, origin, 0,
-                (origin == cap) ? m3::ThreadManager::get().current()->id() : -1));
+        Revocation *old = _revocations.insert(cap, rev);
+        if(old)
+            PANIC("Cannot insert second entry for revocation of cap: " << PRINT_HASH(cap));
+        return rev;
     }
 
     Revocation *find(mht_key_t cap) {
         cap = (HashUtil::hashToType(cap) == ItemType::MAPCAP) ?
             (cap | TYPE_MASK_MCAP) : (cap | TYPE_MASK_OCAP);
-        for(auto it = _list.begin(); it != _list.end(); it++) {
-            if(it->capID == cap)
-                return &*it;
-        }
-        return nullptr;
+        return _revocations.find(cap);
     }
 
     /**
@@ -110,17 +140,22 @@ public:
      * @param cap       The cap ID to remove
      */
     void remove(mht_key_t cap) {
-        for(auto it = _list.begin(); it != _list.end(); it++) {
-            if(it->capID == cap) {
-                _list.remove(&*it);
-                delete &*it;
-                return;
-            }
-        }
+        Revocation *rev = _revocations.remove(cap);
+        if(rev)
+            delete rev;
     }
 
+    /**
+     * Finishes the revocation root <rev>, whose children have all been revoked: notifies its
+     * subscribers, removes the capability from its parent and deletes the entry. If <rev> belongs
+     * to an asynchronous revoke, the syscall is notified.
+     *
+     * @param rev       The revocation root
+     */
+    void finish_root(Revocation *rev);
+
 private:
-    m3::SList<Revocation> _list;
+    m3::HashTable<mht_key_t, Revocation> _revocations;
     static RevocationList _inst;
 };
 
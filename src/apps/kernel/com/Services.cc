@@ -17,7 +17,10 @@
 
 #include <base/Common.h>
 
+#include <cstring>
+
 #include "com/Services.h"
+#include "ddl/MHTInstance.h"
 #include "SyscallHandler.h"
 
 namespace kernel {
@@ -28,6 +31,40 @@ RemoteServiceList RemoteServiceList::_inst;
 Service::~Service() {
     // we have allocated the selector and stored it in our cap-table on creation; undo that
     ServiceList::get().remove(this);
+    if(_published)
+        MHTInstance::getInstance().release(MHTInstance::getInstance().serviceKey(_name), 0);
+}
+
+void Service::publish() {
+    MHTInstance &mht = MHTInstance::getInstance();
+    mht_key_t key = mht.serviceKey(_name);
+    uint reservation = mht.reserve(key);
+    if(reservation == 0) {
+        KLOG(SERV, "Service '" << _name << "' is not published; directory entry "
+            << PRINT_HASH(key) << " is taken");
+        return;
+    }
+
+    ServiceEntry *e = ServiceEntry::create(_id, _name.c_str(), _name.length());
+    mht.putUnlocking(MHTItem(e, static_cast<uint>(ServiceEntry::size(_name.length())), key),
+        reservation);
+    _published = true;
+}
+
+mht_key_t RemoteServiceList::lookup(const m3::String &name) {
+    RemoteService *srv = find(name);
+    if(srv)
+        return srv->id();
+
+    const MHTItem &item = MHTInstance::getInstance().get(MHTInstance::getInstance().serviceKey(name));
+    if(item.isEmpty() || !item.validData())
+        return 0;
+    // the key is only a hash of the name
+    const ServiceEntry *e = item.getData<ServiceEntry>();
+    if(item.getLength() != ServiceEntry::size(name.length()) ||
+       memcmp(e->name(), name.c_str(), name.length()) != 0)
+        return 0;
+    return e->srvId;
 }
 
 void ServiceList::send_and_receive(m3::Reference<Service> serv, const void *msg, size_t size, bool free) {
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <base/Common.h>
+#include <base/col/DList.h>
+#include <base/col/HashTable.h>
 #include <base/col/SList.h>
 #include <base/util/String.h>
 #include <base/util/Reference.h>
@@ -31,14 +33,26 @@ namespace kernel {
 
 class VPE;
 
-class Service : public SlabObject<Service>, public m3::SListItem, public m3::RefCounted {
+class Service : public SlabObject<Service>, public m3::DListItem, public m3::RefCounted {
 public:
     static const size_t SRV_MSG_SIZE     = 256;
 
+    /**
+     * @return the hash of the service name <name> (FNV-1a)
+     */
+    static uint64_t name_hash(const m3::String &name) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for(size_t i = 0; i < name.length(); ++i) {
+            hash ^= static_cast<unsigned char>(name.c_str()[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
     explicit Service(VPE &vpe, int sel, const m3::String &name, int ep, label_t label,
             int capacity, mht_key_t id)
-        : m3::SListItem(), RefCounted(), closing(), _vpe(vpe), _sel(sel), _name(name),
-          _sgate(vpe, ep, label), _queue(capacity), _id(id) {
+        : m3::DListItem(), RefCounted(), closing(), _vpe(vpe), _sel(sel), _name(name),
+          _hash(name_hash(name)), _sgate(vpe, ep, label), _queue(capacity), _id(id), _published() {
     }
     ~Service();
 
@@ -51,6 +65,9 @@ public:
     const m3::String &name() const {
         return _name;
     }
+    uint64_t hash() const {
+        return _hash;
+    }
     SendGate &send_gate() const {
         return const_cast<SendGate&>(_sgate);
     }
@@ -58,6 +75,14 @@ public:
         return _id;
     }
 
+    /**
+     * Enters the service into the service directory in the DDL, so that other kernels can find
+     * it by its name (see RemoteServiceList::lookup). If another kernel has already entered a
+     * service with this name, the entry is kept and the service is only reachable locally.
+     * The entry is removed when the service is destroyed.
+     */
+    void publish();
+
     int pending() const {
         return _queue.inflight() + _queue.pending();
     }
@@ -74,21 +99,71 @@ private:
     VPE &_vpe;
     int _sel;
     m3::String _name;
+    uint64_t _hash;
     SendGate _sgate;
     SendQueue _queue;
     mht_key_t _id;
+    bool _published;
+};
+
+/**
+ * Indexes services of type T by the hash of their name, which T caches (T::hash()). Since different
+ * names might have the same hash, only the first service with a certain hash is put into the
+ * table. The others are found by walking the list of all services, which is only done as long as
+ * there are such services.
+ */
+template<class T>
+class ServiceIndex {
+public:
+    explicit ServiceIndex() : _table(), _unindexed() {
+    }
+
+    void add(T *srv) {
+        if(_table.find(srv->hash()))
+            _unindexed++;
+        else
+            _table.insert(srv->hash(), srv);
+    }
+    void remove(T *srv) {
+        if(_table.find(srv->hash()) == srv)
+            _table.remove(srv->hash());
+        else
+            _unindexed--;
+    }
+
+    /**
+     * @param list  the list of all services
+     * @param name  the name of the service
+     * @param hash  the hash of <name>
+     * @return the service with given name or nullptr
+     */
+    template<class L>
+    T *find(L &list, const m3::String &name, uint64_t hash) const {
+        T *srv = _table.find(hash);
+        if(srv && srv->name() == name)
+            return srv;
+        if(_unindexed == 0)
+            return nullptr;
+        for(auto &s : list) {
+            if(s.hash() == hash && s.name() == name)
+                return &s;
+        }
+        return nullptr;
+    }
+
+private:
+    m3::HashTable<uint64_t, T> _table;
+    size_t _unindexed;
 };
 
 class ServiceList {
-    explicit ServiceList() : _list() {
+    explicit ServiceList() : _list(), _index() {
     }
 
 public:
     friend class Service;
 
-    using iterator = m3::SList<Service>::iterator;
-
-    static const size_t MAX_SERVICES = 32;
+    using iterator = m3::DList<Service>::iterator;
 
     static ServiceList &get() {
         return _inst;
@@ -105,37 +180,50 @@ public:
         int capacity, mht_key_t id) {
         Service *inst = new Service(vpe, sel, name, ep, label, capacity, id);
         _list.append(inst);
+        _index.add(inst);
         return inst;
     }
     Service *find(const m3::String &name) {
-        for(auto &s : _list) {
-            if(s.name() == name)
-                return &s;
-        }
-        return nullptr;
+        return _index.find(_list, name, Service::name_hash(name));
     }
     void send_and_receive(m3::Reference<Service> serv, const void *msg, size_t size, bool free);
 
 private:
     void remove(Service *inst) {
+        _index.remove(inst);
         _list.remove(inst);
     }
 
-    m3::SList<Service> _list;
+    m3::DList<Service> _list;
+    ServiceIndex<Service> _index;
     static ServiceList _inst;
 };
 
 class RemoteServiceList {
-    explicit RemoteServiceList() {
+    explicit RemoteServiceList() : _list(), _index() {
     }
 
 public:
-    struct RemoteService : m3::SListItem {
-        explicit RemoteService(mht_key_t _id, const m3::String &_name) : id(_id), name(_name) {
+    class RemoteService : public m3::SListItem {
+    public:
+        explicit RemoteService(mht_key_t id, const m3::String &name)
+            : m3::SListItem(), _id(id), _name(name), _hash(Service::name_hash(name)) {
+        }
+
+        mht_key_t id() const {
+            return _id;
+        }
+        const m3::String &name() const {
+            return _name;
+        }
+        uint64_t hash() const {
+            return _hash;
         }
 
-        mht_key_t id;
-        m3::String name;
+    private:
+        mht_key_t _id;
+        m3::String _name;
+        uint64_t _hash;
     };
 
     using iterator = m3::SList<RemoteService>::iterator;
@@ -154,25 +242,28 @@ public:
     RemoteService *add(const m3::String &name, mht_key_t id) {
         RemoteService *inst = new RemoteService(id, name);
         _list.append(inst);
+        _index.add(inst);
         return inst;
     }
     bool exists(const m3::String &name) {
-        for(auto &s : _list) {
-            if(s.name == name)
-                return true;
-        }
-        return false;
+        return find(name) != nullptr;
     }
     RemoteService *find(const m3::String &name) {
-        for(auto &s : _list) {
-            if(s.name == name)
-                return &s;
-        }
-        return nullptr;
+        return _index.find(_list, name, Service::name_hash(name));
     }
 
+    /**
+     * Determines the id of the remote service <name>. Services that have been announced to us are
+     * found in the list; all others are looked up in the service directory in the DDL.
+     *
+     * @param name  The name of the service
+     * @return  The id of the service or 0 if it does not exist
+     */
+    mht_key_t lookup(const m3::String &name);
+
 private:
     m3::SList<RemoteService> _list;
+    ServiceIndex<RemoteService> _index;
     static RemoteServiceList _inst;
 };
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/util/Math.h>
+
+#include <cstring>
+
+#include "com/SyscallRing.h"
+#include "pes/VPE.h"
+#include "DTU.h"
+
+namespace kernel {
+
+m3::DList<SyscallRing> SyscallRing::_queue;
+
+SyscallRing::SyscallRing(VPE *vpe, capsel_t mem, size_t slots)
+    : m3::DListItem(), _vpe(vpe), _mem(mem), _slots(slots), _queued(), _completed(), _hd(),
+      _msg(reinterpret_cast<m3::DTU::Message*>(new uint8_t[m3::KIF::Syscall::MSG_SIZE])),
+      _sqes(new Ring::SQE[BATCH]) {
+}
+
+SyscallRing::~SyscallRing() {
+    dequeue();
+    delete[] _sqes;
+    delete[] reinterpret_cast<uint8_t*>(_msg);
+}
+
+void SyscallRing::ring(const m3::DTU::Message &msg) {
+    memcpy(_doorbell, &msg, m3::DTU::HEADER_SIZE);
+    memcpy(_msg, &msg, m3::DTU::HEADER_SIZE);
+    _completed = 0;
+    queue();
+}
+
+void SyscallRing::queue() {
+    if(!_queued) {
+        _queue.append(this);
+        _queued = true;
+    }
+}
+
+void SyscallRing::dequeue() {
+    if(_queued) {
+        _queue.remove(this);
+        _queued = false;
+    }
+}
+
+SyscallRing *SyscallRing::take() {
+    SyscallRing *r = _queue.removeFirst();
+    if(r)
+        r->_queued = false;
+    return r;
+}
+
+m3::Errors::Code SyscallRing::access(size_t off, void *data, size_t size, bool write) {
+    // look the capability up every time, because the entries might have revoked it
+    MemCapability *cap = static_cast<MemCapability*>(_vpe->objcaps().get(_mem, Capability::MEM));
+    if(!cap || (cap->perms() & m3::KIF::Perm::RW) != m3::KIF::Perm::RW ||
+       cap->size() < Ring::size(_slots))
+        return m3::Errors::INV_ARGS;
+
+    VPEDesc mem(cap->obj->core, cap->obj->vpe);
+    if(write)
+        DTU::get().write_mem(mem, cap->addr() + off, data, size);
+    else
+        DTU::get().read_mem(mem, cap->addr() + off, data, size);
+    return m3::Errors::NO_ERROR;
+}
+
+m3::Errors::Code SyscallRing::transfer(uint64_t first, size_t count, bool sq) {
+    // the entries might wrap around at the end of the queue
+    size_t done = 0;
+    while(done < count) {
+        uint64_t idx = first + done;
+        size_t amount = m3::Math::min(count - done, _slots - (idx & (_slots - 1)));
+        m3::Errors::Code res;
+        if(sq) {
+            res = access(Ring::sqe_offset(_slots, idx), _sqes + done,
+                amount * sizeof(Ring::SQE), false);
+        }
+        else {
+            res = access(Ring::cqe_offset(_slots, idx), _cqes + done,
+                amount * sizeof(Ring::CQE), true);
+        }
+        if(res != m3::Errors::NO_ERROR)
+            return res;
+        done += amount;
+    }
+    return m3::Errors::NO_ERROR;
+}
+
+m3::Errors::Code SyscallRing::fetch(size_t *count) {
+    *count = 0;
+    m3::Errors::Code res = access(0, &_hd, sizeof(_hd), false);
+    if(res != m3::Errors::NO_ERROR)
+        return res;
+
+    // the counters are controlled by the VPE; don't trust them
+    uint64_t avail = _hd.sq_tail - _hd.sq_head;
+    uint64_t used = _hd.cq_tail - _hd.cq_head;
+    if(avail > _slots || used > _slots)
+        return m3::Errors::INV_ARGS;
+
+    size_t num = m3::Math::min<uint64_t>(m3::Math::min<uint64_t>(avail, _slots - used), BATCH);
+    res = transfer(_hd.sq_head, num, true);
+    if(res == m3::Errors::NO_ERROR)
+        *count = num;
+    return res;
+}
+
+m3::Errors::Code SyscallRing::commit(size_t count) {
+    if(count == 0)
+        return m3::Errors::NO_ERROR;
+
+    m3::Errors::Code res = transfer(_hd.cq_tail, count, false);
+    if(res != m3::Errors::NO_ERROR)
+        return res;
+
+    _hd.sq_head += count;
+    _hd.cq_tail += count;
+    _completed += count;
+    // sq_head and cq_tail are adjacent
+    return access(offsetof(Ring::Header, sq_head), &_hd.sq_head,
+        sizeof(_hd.sq_head) + sizeof(_hd.cq_tail), true);
+}
+
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/col/DList.h>
+#include <base/DTU.h>
+#include <base/Errors.h>
+#include <base/KIF.h>
+
+#include "mem/SlabCache.h"
+
+namespace kernel {
+
+class VPE;
+
+/**
+ * The kernel side of a syscall ring (see KIF::Syscall::Ring). The ring lives in memory of the VPE,
+ * which is accessed via one of its memory capabilities. After the VPE rang the doorbell, the ring
+ * is queued and the WorkLoop executes up to BATCH entries of every queued ring per iteration (see
+ * SyscallHandler::drain_rings). The doorbell is answered as soon as the submission queue is empty
+ * or the completion queue is full.
+ *
+ * In contrast to BATCH, the syscalls that might wait for other kernels or receive buffers
+ * (EXCHANGE, ACTIVATE and REVOKE) are not supported, because all rings are drained by the same
+ * thread.
+ */
+class SyscallRing : public m3::DListItem, public SlabObject<SyscallRing> {
+    using Ring = m3::KIF::Syscall::Ring;
+
+public:
+    static const size_t BATCH   = 8;
+
+    explicit SyscallRing(VPE *vpe, capsel_t mem, size_t slots);
+    SyscallRing(const SyscallRing &) = delete;
+    SyscallRing &operator=(const SyscallRing &) = delete;
+    ~SyscallRing();
+
+    VPE *vpe() const {
+        return _vpe;
+    }
+    capsel_t mem() const {
+        return _mem;
+    }
+    size_t slots() const {
+        return _slots;
+    }
+
+    /**
+     * @return the header of the doorbell message, which is answered at the end
+     */
+    const m3::DTU::Message &doorbell() const {
+        return *reinterpret_cast<const m3::DTU::Message*>(_doorbell);
+    }
+    /**
+     * @return the message that is used to execute the entries (with the header of the doorbell)
+     */
+    m3::DTU::Message *msg() {
+        return _msg;
+    }
+    /**
+     * @return the number of entries that have been completed since the last doorbell
+     */
+    size_t completed() const {
+        return _completed;
+    }
+
+    /**
+     * Remembers the doorbell <msg> and queues the ring.
+     */
+    void ring(const m3::DTU::Message &msg);
+    /**
+     * Queues the ring to execute more entries later on.
+     */
+    void queue();
+    /**
+     * Removes the ring from the queue.
+     */
+    void dequeue();
+    bool queued() const {
+        return _queued;
+    }
+
+    /**
+     * Reads the header and the next entries from the ring.
+     *
+     * @param count will be set to the number of fetched entries
+     * @return the error, if the ring is not accessible anymore or inconsistent
+     */
+    m3::Errors::Code fetch(size_t *count);
+    const Ring::SQE &entry(size_t i) const {
+        return _sqes[i];
+    }
+    /**
+     * Sets the result of the fetched entry <i> to <res>.
+     */
+    void complete(size_t i, m3::Errors::Code res) {
+        _cqes[i].tag = _sqes[i].tag;
+        _cqes[i].error = res;
+    }
+    /**
+     * Writes the results of the <count> fetched entries back to the ring.
+     *
+     * @return the error, if the ring is not accessible anymore
+     */
+    m3::Errors::Code commit(size_t count);
+    /**
+     * @return true if the doorbell should be answered, because the submission queue is empty or
+     *  the completion queue is full (the VPE can't consume completions before the answer)
+     */
+    bool idle() const {
+        return _hd.sq_head == _hd.sq_tail || _hd.cq_tail - _hd.cq_head == _slots;
+    }
+
+    /**
+     * @return true if there are rings to drain
+     */
+    static bool pending() {
+        return _queue.length() > 0;
+    }
+    /**
+     * @return the number of queued rings
+     */
+    static size_t count() {
+        return _queue.length();
+    }
+    /**
+     * Removes the first ring from the queue and returns it.
+     */
+    static SyscallRing *take();
+
+private:
+    m3::Errors::Code access(size_t off, void *data, size_t size, bool write);
+    m3::Errors::Code transfer(uint64_t first, size_t count, bool sq);
+
+    VPE *_vpe;
+    capsel_t _mem;
+    size_t _slots;
+    bool _queued;
+    size_t _completed;
+    Ring::Header _hd;
+    m3::DTU::Message *_msg;
+    Ring::SQE *_sqes;
+    Ring::CQE _cqes[BATCH];
+    alignas(DTU_PKG_SIZE) uint8_t _doorbell[m3::DTU::HEADER_SIZE];
+    static m3::DList<SyscallRing> _queue;
+};
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>, 
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+#include <base/log/Kernel.h>
+
+#include <cstring>
+
+#include "ddl/MHTCache.h"
+
+namespace kernel {
+
+const MHTItem *MHTCache::find(mht_key_t key) {
+    Entry *e = _entries.find(key);
+    if(!e) {
+        _misses++;
+        return nullptr;
+    }
+
+    _hits++;
+    if(&*_lru.begin() != e) {
+        _lru.remove(e);
+        _lru.prepend(e);
+    }
+    return &e->item;
+}
+
+void *MHTCache::copy(const MHTItem &item) {
+    void *data = m3::Heap::alloc(item.getLength());
+    memcpy(data, item.data, item.getLength());
+    return data;
+}
+
+void MHTCache::insert(const MHTItem &item) {
+    if(_capacity == 0 || !cacheable(item))
+        return;
+
+    Entry *e = _entries.find(item.getKey());
+    if(e) {
+        m3::Heap::free(e->item.data);
+        e->item.data = copy(item);
+        e->item.length = item.length;
+        _lru.remove(e);
+        _lru.prepend(e);
+        return;
+    }
+
+    if(_lru.length() >= _capacity) {
+        Entry *victim = &*_lru.tail();
+        KLOG(MHT, "Evicting cached item " << PRINT_HASH(victim->item.getKey()));
+        remove(victim);
+        _evictions++;
+    }
+
+    e = new Entry(item);
+    _entries.insert(item.getKey(), e);
+    _lru.prepend(e);
+}
+
+void MHTCache::invalidate(mht_key_t start, uint count) {
+    for(uint i = 0; i < count && _lru.length(); ++i) {
+        Entry *e = _entries.find(start + i);
+        if(e) {
+            remove(e);
+            _invalidations++;
+        }
+    }
+}
+
+void MHTCache::invalidatePartition(membership_entry::pe_id_t pe) {
+    for(auto it = _lru.begin(); it != _lru.end(); ) {
+        auto old = it++;
+        if(HashUtil::hashToPeId(old->item.getKey()) == pe) {
+            remove(&*old);
+            _invalidations++;
+        }
+    }
+}
+
+void MHTCache::clear() {
+    for(auto it = _lru.begin(); it != _lru.end(); ) {
+        auto old = it++;
+        delete &*old;
+    }
+    _lru.clear();
+    _entries.clear();
+}
+
+void MHTCache::remove(Entry *e) {
+    _entries.remove(e->item.getKey());
+    _lru.remove(e);
+    delete e;
+}
+
+}
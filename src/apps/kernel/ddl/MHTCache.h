@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>, 
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+#pragma once
+
+#include <base/col/DList.h>
+#include <base/col/HashTable.h>
+
+#include "ddl/MHTTypes.h"
+#include "mem/SlabCache.h"
+
+#ifndef DDL_CACHE_SIZE
+#   define DDL_CACHE_SIZE   256
+#endif
+
+namespace kernel {
+
+/**
+ * A bounded cache for items that have been fetched from other kernels. If the cache is full, the
+ * least recently used item is evicted.
+ *
+ * Only service directory entries are cached, because they do not change after they have been
+ * published. Capabilities, in contrast, are modified by their owner (e.g., their children) without
+ * notifying the kernels that fetched them. The owner does not know where its entries are cached,
+ * so users have to validate a cached entry when using it and invalidate it if it turned out to be
+ * outdated (see SyscallHandler::createsess). Besides that, MEMBERUPDATE and PARTITIONMIG
+ * invalidate the entries of partitions that change their owner. Locking gets never use the cache.
+ *
+ * Each entry owns a copy of the data, which is freed if the entry is evicted or invalidated.
+ */
+class MHTCache {
+    struct Entry : public m3::DListItem, public SlabObject<Entry> {
+        explicit Entry(const MHTItem &src)
+            : m3::DListItem(), item(copy(src), src.getLength(), src.getKey()) {
+        }
+        ~Entry() {
+            m3::Heap::free(item.data);
+        }
+        MHTItem item;
+    };
+
+public:
+    explicit MHTCache(size_t capacity = DDL_CACHE_SIZE)
+        : _capacity(capacity), _lru(), _entries(capacity), _hits(), _misses(), _invalidations(),
+          _evictions() {
+    }
+    MHTCache(const MHTCache &) = delete;
+    MHTCache &operator=(const MHTCache &) = delete;
+    ~MHTCache() {
+        clear();
+    }
+
+    /**
+     * Looks up <key> and marks the item as recently used.
+     *
+     * @param key the key
+     * @return the cached item or nullptr
+     */
+    const MHTItem *find(mht_key_t key);
+
+    /**
+     * Caches a copy of <item>, which has been received from another kernel. Items of other types
+     * than SRVDIR and items without data (e.g., reservations) are ignored.
+     *
+     * @param item the item
+     */
+    void insert(const MHTItem &item);
+
+    /**
+     * @return true if <item> can be cached
+     */
+    static bool cacheable(const MHTItem &item) {
+        return item.validData() && HashUtil::hashToType(item.getKey()) == SRVDIR;
+    }
+
+    /**
+     * @return a copy of the data of <item> on the heap
+     */
+    static void *copy(const MHTItem &item);
+
+    /**
+     * Removes the entries for the keys <start> .. <start> + <count> - 1, if present.
+     */
+    void invalidate(mht_key_t start, uint count = 1);
+
+    /**
+     * Removes all entries of the partition <pe>, e.g., because it changed its owner.
+     */
+    void invalidatePartition(membership_entry::pe_id_t pe);
+
+    void clear();
+
+    size_t length() const {
+        return _lru.length();
+    }
+    size_t capacity() const {
+        return _capacity;
+    }
+    ulong hits() const {
+        return _hits;
+    }
+    ulong misses() const {
+        return _misses;
+    }
+    ulong invalidations() const {
+        return _invalidations;
+    }
+    ulong evictions() const {
+        return _evictions;
+    }
+
+private:
+    void remove(Entry *e);
+
+    size_t _capacity;
+    // most recently used entries first
+    m3::DList<Entry> _lru;
+    m3::HashTable<mht_key_t, Entry> _entries;
+    ulong _hits;
+    ulong _misses;
+    ulong _invalidations;
+    ulong _evictions;
+};
+
+}
@@ -19,6 +19,7 @@
 #include <limits.h>
 #include <base/log/Kernel.h>
 #include <base/util/Random.h>
+#include <base/util/Profile.h>
 #include <base/Panic.h>
 #include <thread/ThreadManager.h>
 
@@ -34,39 +35,28 @@ MHTInstance *MHTInstance::_inst;
 // TODO
 MHTInstance::nextResItem MHTInstance::nextIdx;
 MHTItem MHTInstance::resItems[3];
+void *MHTInstance::resData[3];
 
-MHTInstance::MHTInstance() {
+MHTInstance::MHTInstance() : _migratedItems(0), _migrationCycles(0), _epoch(0),
+        _activePasses(0) {
     KLOG(MHT, "Initializing DDL.\n\tID bits=" << ID_BITS << ", max PEs=" << MAX_PES_DDL <<
         ", PE bits=" << PE_BITS << ",\n\tVPE bits=" << VPE_BITS << ", type bits=" <<
         TYPE_BITS << ", hash bits=" << HASH_BITS << ",\n\ttype mask=" << m3::fmt(TYPE_MASK, "0x#", ID_BITS/4));
 
-    memberTable = new membership_entry[Platform::MAX_PES];
-    if(!memberTable)
-        PANIC("Not enought memory to create membership table");
-    // create partitions and fill membership table
+    // create partitions and fill membership table; unused slots in the ID space are UNPOPULATED
     m3::Random::init(1);
     size_t kid = Coordinator::get().kid();
-    for(membership_entry::pe_id_t i = 0; i < Platform::pe_count(); i++) {
-        memberTable[i] = {i, static_cast<membership_entry::krnl_id_t>(kid), 1, MembershipFlags::NONE};
+    memberTable.init(Platform::pe_count(), static_cast<membership_entry::krnl_id_t>(kid));
+    for(membership_entry::pe_id_t i = 0; i < MAX_PES_DDL; i++) {
         PartitionEntry *p = new PartitionEntry(new MHTPartition(i));
         partitions.append(p);
     }
-
-    // handle unused slots in the ID space
-    if(Platform::pe_count() < MAX_PES_DDL) {
-        // create partitions
-        for(membership_entry::pe_id_t i = Platform::pe_count(); i < MAX_PES_DDL; i++) {
-            memberTable[i] = {i, static_cast<membership_entry::krnl_id_t>(kid), 1, MembershipFlags::UNPOPULATED};
-            PartitionEntry *p = new PartitionEntry(new MHTPartition(i));
-            partitions.append(p);
-        }
-    }
 }
 
 m3::Errors::Code MHTInstance::put(MHTItem &&kv_pair) {
     KLOG(MHT, "Put mht_key: " << PRINT_HASH(kv_pair._mht_key));
 
-    MHTPartition *part = findPartition(kv_pair._mht_key);
+    MHTPartition *part = findWritablePartition(kv_pair._mht_key);
     if(part) {
         // the partition is local, get it and insert the kv_pair
         return part->put(m3::Util::move(kv_pair));
@@ -90,7 +80,7 @@ m3::Errors::Code MHTInstance::put(MHTItem &&kv_pair) {
 m3::Errors::Code MHTInstance::putUnlocking(MHTItem &&item, uint lockHandle) {
     KLOG(MHT, "PutUnlocking mht_key: " << PRINT_HASH(item._mht_key));
 
-    MHTPartition *part = findPartition(item._mht_key);
+    MHTPartition *part = findWritablePartition(item._mht_key);
     if(part) {
         // the partition is local, get it and insert the kv_pair
         return part->put(m3::Util::move(item), lockHandle);
@@ -105,8 +95,12 @@ m3::Errors::Code MHTInstance::putUnlocking(MHTItem &&item, uint lockHandle) {
 const MHTItem &MHTInstance::localGet(mht_key_t mht_key, bool locking) {
     KLOG(MHT, "Requesting mht_key: " << PRINT_HASH(mht_key));
 
-    MHTPartition *part = findPartition(mht_key);
-    assert(part);
+    MHTPartition *part = locking ? findWritablePartition(mht_key) : findPartition(mht_key);
+    // the partition has been migrated in the meantime; get the item from the new owner
+    if(!part) {
+        assert(getMigrationDestination(HashUtil::hashToPeId(mht_key)) != nullptr);
+        return get(mht_key, locking);
+    }
     return part->get(mht_key, locking);
 }
 
@@ -123,7 +117,7 @@ void MHTInstance::remoteGet(mht_key_t mht_key, bool locking) {
 const MHTItem &MHTInstance::get(mht_key_t mht_key, bool locking) {
     KLOG(MHT, "Requesting mht_key: " << PRINT_HASH(mht_key));
 
-    MHTPartition *part = findPartition(mht_key);
+    MHTPartition *part = locking ? findWritablePartition(mht_key) : findPartition(mht_key);
     if(part) { // local partition
         KLOG(MHT,"Request is local");
         // capabilities are stored in CapTables
@@ -136,6 +130,9 @@ const MHTItem &MHTInstance::get(mht_key_t mht_key, bool locking) {
         // when restructuring the interface, we also need to incorporate the check if the VPE exists
 //        if(!PEManager::get().exists(HashUtil::hashToPeId(mht_key)))
 //            return MHTPartition::emptyIndicator;
+        // these items are not stored in the partition, so account the access here
+        if((type & ItemType::GENERICOCAP) || type == MAPCAP || type == SERVICE)
+            part->account(locking ? part->_stats.locks : part->_stats.gets);
         if(type & ItemType::GENERICOCAP) {
             // TODO
             // dirty workaround, the interface needs to change
@@ -172,6 +169,24 @@ const MHTItem &MHTInstance::get(mht_key_t mht_key, bool locking) {
         }
     } else {
         KLOG(MHT, "Request is remote");
+        // locking requests have to go to the owner in any case
+        if(!locking) {
+            const MHTItem *cached = _cache.find(mht_key);
+            if(cached) {
+                KLOG(MHT, "Request served from cache");
+                // TODO
+                // dirty workaround, the interface needs to change
+                // hand out a copy, because the entry might be evicted while the caller uses it
+                size_t idx = nextIdx.getnext();
+                m3::Heap::free(resData[idx]);
+                resData[idx] = MHTCache::copy(*cached);
+                resItems[idx]._mht_key = cached->_mht_key;
+                resItems[idx].data = resData[idx];
+                resItems[idx].length = cached->length;
+                return resItems[idx];
+            }
+        }
+
         // request has to be served by another kernel
         // the request is identified by the current thread's ID
         KPE *remoteKrnl = Coordinator::get().getKPE(responsibleMember(mht_key));
@@ -185,21 +200,25 @@ const MHTItem &MHTInstance::get(mht_key_t mht_key, bool locking) {
         // when the thread is resumed the thread's message buffer contains the result
         assert(m3::ThreadManager::get().get_current_msg() != nullptr);
         const MHTItem *res = reinterpret_cast<const MHTItem*>(m3::ThreadManager::get().get_current_msg());
+        if(!locking)
+            _cache.insert(*res);
         return *res;
     }
-    }
+}
 
 uint MHTInstance::lockLocal(mht_key_t mht_key) {
-    MHTPartition *part = findPartition(mht_key);
+    MHTPartition *part = findWritablePartition(mht_key);
+    // the partition has been migrated in the meantime
+    if(part == nullptr)
+        return lock(mht_key);
     int lockHandle = part->lock(mht_key);
     // let this thread wait until the item is unlocked
     if(lockHandle == -1) {
         part->enqueueTicket(mht_key);
         // when we resume the thread, the partition could have been migrated in the meantime
-        MHTPartition *part = findPartition(mht_key);
+        part = findWritablePartition(mht_key);
         if(part == nullptr)
-            PANIC("Locking key " << PRINT_HASH(mht_key) << " failed! Partition not found. "
-                    "Migrating partitions not implemented yet.");
+            return lock(mht_key);
         lockHandle = part->lock(mht_key);
     }
     return lockHandle;
@@ -208,7 +227,7 @@ uint MHTInstance::lockLocal(mht_key_t mht_key) {
 uint MHTInstance::lock(mht_key_t mht_key) {
     KLOG(MHT, "Locking key " << PRINT_HASH(mht_key));
 
-    MHTPartition *part = findPartition(mht_key);
+    MHTPartition *part = findWritablePartition(mht_key);
     if(part) { // local partition
         return lockLocal(mht_key);
     } else {
@@ -239,7 +258,7 @@ bool MHTInstance::unlock(mht_key_t mht_key, uint lockHandle) {
 uint MHTInstance::reserve(mht_key_t mht_key) {
     KLOG(MHT, "Reserving key " << PRINT_HASH(mht_key));
 
-    MHTPartition *part = findPartition(mht_key);
+    MHTPartition *part = findWritablePartition(mht_key);
     if(part) {
         return part->reserve(mht_key);
     } else {
@@ -256,7 +275,7 @@ uint MHTInstance::reserve(mht_key_t mht_key) {
 m3::Errors::Code MHTInstance::release(mht_key_t mht_key, uint reservation) {
     KLOG(MHT, "Releasing key " << PRINT_HASH(mht_key));
 
-    MHTPartition *part = findPartition(mht_key);
+    MHTPartition *part = findWritablePartition(mht_key);
     if(part) {
         return part->release(mht_key, reservation);
     } else {
@@ -266,106 +285,500 @@ m3::Errors::Code MHTInstance::release(mht_key_t mht_key, uint reservation) {
     }
 }
 
-void MHTInstance::migratePartitions(m3::PEDesc pes[], uint numPEs, membership_entry::krnl_id_t receiver) {
+void MHTInstance::getv(const mht_key_t keys[], size_t count, void *data[], m3::Errors::Code res[]) {
+    DDLBatch all(count, res);
+    all.keys = keys;
+    all.data = data;
+    batch(Kernelcalls::MHTGETV, all);
+}
+
+void MHTInstance::putv(MHTItem *items[], size_t count, const uint lockHandles[], m3::Errors::Code res[]) {
+    DDLBatch all(count, res);
+    all.items = items;
+    all.values = const_cast<uint*>(lockHandles);
+    batch(Kernelcalls::MHTPUTV, all);
+}
+
+void MHTInstance::lockv(const mht_key_t keys[], size_t count, uint lockHandles[], m3::Errors::Code res[]) {
+    DDLBatch all(count, res);
+    all.keys = keys;
+    all.values = lockHandles;
+    batch(Kernelcalls::MHTLOCKV, all);
+}
+
+void MHTInstance::unlockv(const mht_key_t keys[], size_t count, const uint lockHandles[], m3::Errors::Code res[]) {
+    DDLBatch all(count, res);
+    all.keys = keys;
+    all.values = const_cast<uint*>(lockHandles);
+    batch(Kernelcalls::MHTUNLOCKV, all);
+}
+
+bool MHTInstance::batchLocal(Kernelcalls::Operation op, DDLBatch &all, size_t i) {
+    mht_key_t key = op == Kernelcalls::MHTPUTV ? all.items[i]->_mht_key : all.keys[i];
+    MHTPartition *part = op == Kernelcalls::MHTGETV ? findPartition(key) : findWritablePartition(key);
+    // like the single-key operations, the cache is not used here, because it does not hold
+    // capabilities and the result has to be up to date for the callers
+    if(!part)
+        return false;
+
+    switch(op) {
+        case Kernelcalls::MHTGETV: {
+            const MHTItem &item = get(key);
+            all.data[i] = item.data;
+            all.results[i] = item.isEmpty() ? m3::Errors::NO_SUCH_FILE : m3::Errors::NO_ERROR;
+            break;
+        }
+        case Kernelcalls::MHTPUTV:
+            all.results[i] = part->put(m3::Util::move(*all.items[i]), all.values ? all.values[i] : 0);
+            break;
+        case Kernelcalls::MHTLOCKV:
+            all.values[i] = lockLocal(key);
+            all.results[i] = all.values[i] ? m3::Errors::NO_ERROR : m3::Errors::NO_SUCH_FILE;
+            break;
+        case Kernelcalls::MHTUNLOCKV:
+            all.results[i] = part->unlock(key, all.values[i]) ? m3::Errors::NO_ERROR : m3::Errors::NO_PERM;
+            break;
+        default:
+            PANIC("Unsupported batch operation " << op);
+    }
+    return true;
+}
+
+bool MHTInstance::batchMoved(mht_key_t key, membership_entry::krnl_id_t asked,
+        membership_entry::krnl_id_t owner) {
+    if(owner == asked || owner == Coordinator::get().kid())
+        return false;
+    KPE *dest = Coordinator::get().tryGetKPE(owner);
+    if(dest == nullptr)
+        dest = getMigrationDestination(HashUtil::hashToPeId(key));
+    if(dest == nullptr)
+        return false;
+    // the partition has been migrated and we did not get the membership update yet
+    KLOG(MHT, "Key " << PRINT_HASH(key) << " moved from kernel #" << asked << " to #" << owner);
+    updateMembership(HashUtil::hashToPeId(key), owner, dest->core(), 1, NOCHANGE, false);
+    return true;
+}
+
+void MHTInstance::batch(Kernelcalls::Operation op, DDLBatch &all) {
+    if(all.count == 0)
+        return;
+
+    // handle the local keys first and remember the remote ones
+    size_t *remote = new size_t[all.count];
+    size_t remoteCount = 0;
+    for(size_t i = 0; i < all.count; ++i) {
+        if(!batchLocal(op, all, i))
+            remote[remoteCount++] = i;
+    }
+    if(remoteCount == 0) {
+        delete[] remote;
+        return;
+    }
+
+    // the entries for the kernel we are currently talking to
+    size_t *sel = new size_t[remoteCount];
+    mht_key_t *keys = new mht_key_t[remoteCount];
+    MHTItem **items = new MHTItem*[remoteCount];
+    uint *values = new uint[remoteCount];
+    void **data = new void*[remoteCount];
+    membership_entry::krnl_id_t *owners = new membership_entry::krnl_id_t[remoteCount];
+    m3::Errors::Code *results = new m3::Errors::Code[remoteCount];
+
+    auto keyOf = [&all, op](size_t i) {
+        return op == Kernelcalls::MHTPUTV ? all.items[i]->_mht_key : all.keys[i];
+    };
+
+    while(remoteCount > 0) {
+        // collect all entries that belong to the same kernel as the first one
+        membership_entry::krnl_id_t krnl = responsibleMember(keyOf(remote[0]));
+        DDLBatch sub(0, results);
+        sub.keys = keys;
+        sub.items = items;
+        sub.values = all.values ? values : nullptr;
+        sub.data = data;
+        sub.owners = owners;
+        size_t left = 0;
+        for(size_t j = 0; j < remoteCount; ++j) {
+            size_t i = remote[j];
+            if(responsibleMember(keyOf(i)) != krnl) {
+                remote[left++] = i;
+                continue;
+            }
+            sel[sub.count] = i;
+            if(op == Kernelcalls::MHTPUTV) {
+                _cache.invalidate(all.items[i]->_mht_key);
+                items[sub.count] = all.items[i];
+            }
+            else
+                keys[sub.count] = all.keys[i];
+            if(all.values)
+                values[sub.count] = all.values[i];
+            sub.count++;
+        }
+        remoteCount = left;
+
+        KPE *dest = Coordinator::get().tryGetKPE(krnl);
+        // check if the partition currently migrates and send the request to the new owner if so
+        if(dest == nullptr)
+            dest = getMigrationDestination(HashUtil::hashToPeId(keyOf(sel[0])));
+        if(dest == nullptr) {
+            KLOG(ERR, "Ignoring batch request to unknown kernel #" << krnl);
+            for(size_t j = 0; j < sub.count; ++j) {
+                results[j] = m3::Errors::INV_ARGS;
+                owners[j] = krnl;
+            }
+            sub.answered = sub.count;
+        }
+
+        m3::ThreadManager &tmng = m3::ThreadManager::get();
+        while(sub.answered < sub.count) {
+            Kernelcalls::get().mhtBatchRequest(dest, op, sub);
+            tmng.wait_for(reinterpret_cast<void*>(tmng.current()->id()));
+        }
+
+        for(size_t j = 0; j < sub.count; ++j) {
+            size_t i = sel[j];
+            // keys of partitions that have been migrated are sent to the new owner again
+            if(results[j] == m3::Errors::INV_ARGS && batchMoved(keyOf(i), krnl, owners[j])) {
+                remote[remoteCount++] = i;
+                continue;
+            }
+
+            all.results[i] = results[j];
+            if(op == Kernelcalls::MHTGETV)
+                all.data[i] = results[j] == m3::Errors::NO_ERROR ? data[j] : nullptr;
+            else if(op == Kernelcalls::MHTLOCKV)
+                all.values[i] = results[j] == m3::Errors::NO_ERROR ? values[j] : 0;
+            else if(op == Kernelcalls::MHTPUTV && results[j] == m3::Errors::NO_ERROR) {
+                // the owner stores a copy; like a local put, the data belongs to the DDL now
+                m3::Heap::free(all.items[i]->data);
+                all.items[i]->data = nullptr;
+            }
+        }
+    }
+
+    delete[] results;
+    delete[] owners;
+    delete[] data;
+    delete[] values;
+    delete[] items;
+    delete[] keys;
+    delete[] sel;
+    delete[] remote;
+}
+
+m3::Errors::Code MHTInstance::migratePartitions(m3::PEDesc pes[], uint numPEs,
+        membership_entry::krnl_id_t receiver) {
     KLOG(MHT, "Migrating " << numPEs << " DDL partitions to kernel #" << (uint)receiver);
-    // calculate memory necessary to transmit data
-    MHTPartition *parts[numPEs];
-    size_t size = 0;
+    m3::Errors::Code res = m3::Errors::NO_ERROR;
     for(size_t i = 0; i < numPEs; i++) {
-        parts[i] = findPartition(HashUtil::structured_hash(pes[i].core_id(), 0, NOTYPE, 0));
-        assert(parts[i]);
-        size = parts[i]->serializedSize();
+        m3::Errors::Code err = migratePartition(pes[i].core_id(), receiver);
+        if(res == m3::Errors::NO_ERROR)
+            res = err;
     }
-    // stream content: number of partitions [<< partition number << number of items << items]
-    AutoGateOStream ser(m3::vostreamsize(
-        m3::ostreamsize<uint>(), size));
-    ser << numPEs;
-    for(size_t i = 0; i < numPEs; i++)
-        parts[i]->serialize(ser);
+    return res;
+}
 
-    Kernelcalls::get().migratePartition(Coordinator::get().getKPE(receiver), ser);
+m3::Errors::Code MHTInstance::migratePartition(membership_entry::pe_id_t id,
+        membership_entry::krnl_id_t receiver) {
+    MHTPartition *part = findPartition(HashUtil::structured_hash(id, 0, NOTYPE, 0));
+    KPE *dest = Coordinator::get().tryGetKPE(receiver);
+    if(!part || !dest || part->_migrating)
+        return m3::Errors::INV_ARGS;
+
+    cycles_t start = m3::Profile::start(0);
+    m3::ThreadManager &tmng = m3::ThreadManager::get();
+    PartitionMigration mig(part, dest);
+    mht_key_t *keys = new mht_key_t[part->_storage.length()];
+    size_t end = part->startMigration(keys);
+    size_t total = end;
+    size_t pos = 0;
+    size_t deferred = 0;
+    KLOG(MHT, "Migrating DDL partition #" << id << " with " << total << " items to kernel #" << receiver);
+
+    while(mig.err == m3::Errors::NO_ERROR && (pos < end || deferred > 0)) {
+        if(pos == end) {
+            // only locked items are left. the acknowledgements wake us up as well, so receive them
+            // first and wait until the next item is unlocked afterwards
+            while(mig.acked < mig.sent)
+                tmng.wait_for(reinterpret_cast<void*>(mig.tid));
+            part->waitUnlocked(keys[0]);
+            end = deferred;
+            pos = 0;
+            deferred = 0;
+            continue;
+        }
+
+        while(mig.sent - mig.acked >= MIGRATION_WINDOW)
+            tmng.wait_for(reinterpret_cast<void*>(mig.tid));
+        if(mig.err == m3::Errors::NO_ERROR)
+            sendPartitionChunk(mig, keys, pos, end, deferred, false);
+    }
+
+    // let the receiver make the partition visible
+    if(mig.err == m3::Errors::NO_ERROR) {
+        while(mig.sent - mig.acked >= MIGRATION_WINDOW)
+            tmng.wait_for(reinterpret_cast<void*>(mig.tid));
+        if(mig.err == m3::Errors::NO_ERROR)
+            sendPartitionChunk(mig, keys, pos, end, deferred, true);
+    }
+    while(mig.acked < mig.sent)
+        tmng.wait_for(reinterpret_cast<void*>(mig.tid));
+    delete[] keys;
+
+    if(mig.err != m3::Errors::NO_ERROR) {
+        KLOG(ERR, "Migrating DDL partition #" << id << " to kernel #" << receiver << " failed: " << mig.err);
+        part->abortMigration();
+        tmng.notify(part);
+        return mig.err;
+    }
+
+    // the receiver is the owner now. tell everybody and forward the requests that still arrive here
+    m3::PEDesc pe = Platform::pe_by_core(id);
+    updateMembership(&pe, 1, receiver, dest->core(), MembershipFlags::NONE, true);
+    _migratingPartitions.append(new MigratingPartitionEntry(id, receiver, dest->core()));
+    for(auto it = partitions.begin(); it != partitions.end(); it++) {
+        if(it->partition == part) {
+            partitions.remove(&*it);
+            delete &*it;
+            break;
+        }
+    }
+    // wake up the threads that want to change sent items; they go to the receiver now
+    tmng.notify(part);
+    // threads that are in the middle of an operation might still use items of the partition
+    _retiredPartitions.append(new RetiredPartition(part, ++_epoch, _activePasses));
+
+    cycles_t cycles = m3::Profile::stop(0) - start;
+    _migratedItems += total;
+    _migrationCycles += cycles;
+    KLOG(MHT, "Migrated DDL partition #" << id << " to kernel #" << receiver << ": " << total <<
+        " items in " << mig.sent << " chunks, " << cycles << " cycles (" <<
+        (total * 1000000) / (cycles ? cycles : 1) << " items/Mcycle)");
+    return m3::Errors::NO_ERROR;
 }
 
-void MHTInstance::receivePartitions(GateIStream& is) {
-    uint numPEs;
-    is >> numPEs;
-    KLOG(MHT, "Receiving " << numPEs << " DDL partitions");
-    for(size_t i = 0; i < numPEs; i++) {
-        MHTPartition *part = new MHTPartition(0);
-        part->deserialize(is);
-        assert(findPartition(HashUtil::structured_hash(part->_id, 0, NOTYPE, 0)) == nullptr);
-        partitions.append(new PartitionEntry(part));
+void MHTInstance::sendPartitionChunk(PartitionMigration &mig, mht_key_t keys[], size_t &pos,
+        size_t end, size_t &deferred, bool last) {
+    BatchGateOStream chunk(Kernelcalls::PARTITIONMIG, Kernelcalls::KREQUEST, mig.tid,
+        reinterpret_cast<uintptr_t>(&mig));
+    chunk << mig.sent << mig.part->_id << last;
+    size_t n = 0;
+    if(!last) {
+        n = mig.part->serializeChunk(chunk, keys, pos, end, deferred);
+        if(n == 0) {
+            // the chunk was empty, so the item did not fit into a message at all
+            if(pos < end)
+                PANIC("DDL item " << PRINT_HASH(keys[pos]) << " is too large to be migrated");
+            // all remaining items are locked or removed
+            return;
+        }
+    }
+    chunk.finish(n);
+    mig.sent++;
+    Kernelcalls::get().migratePartition(mig.dest, chunk);
+}
+
+void MHTInstance::partitionChunkAcked(uintptr_t migration, uint seq, m3::Errors::Code res) {
+    PartitionMigration *mig = reinterpret_cast<PartitionMigration*>(migration);
+    if(res != m3::Errors::NO_ERROR && mig->err == m3::Errors::NO_ERROR) {
+        KLOG(ERR, "Kernel #" << mig->dest->id() << " refused chunk " << seq << " of DDL partition #"
+            << mig->part->_id << ": " << res);
+        mig->err = res;
     }
+    mig->acked++;
+    m3::ThreadManager::get().notify(reinterpret_cast<void*>(mig->tid));
+}
+
+m3::Errors::Code MHTInstance::receivePartitionChunk(GateIStream &is, membership_entry::krnl_id_t src,
+        uint seq, membership_entry::pe_id_t id, bool last, size_t count) {
+    IncomingPartition *in = nullptr;
+    for(auto it = _incomingPartitions.begin(); it != _incomingPartitions.end(); it++) {
+        if(it->partition->_id == id && it->source == src) {
+            in = &*it;
+            break;
+        }
+    }
+    if(!in) {
+        // we have dropped the partition after an error
+        if(seq != 0)
+            return m3::Errors::INV_ARGS;
+        in = new IncomingPartition(new MHTPartition(id), src);
+        _incomingPartitions.append(in);
+    }
+
+    m3::Errors::Code res = m3::Errors::INV_ARGS;
+    if(seq == in->nextSeq)
+        res = in->partition->deserializeItems(is, count);
+    if(res != m3::Errors::NO_ERROR) {
+        KLOG(ERR, "Receiving chunk " << seq << " of DDL partition #" << id << " failed: " << res);
+        _incomingPartitions.remove(in);
+        delete in->partition;
+        delete in;
+        return res;
+    }
+    in->nextSeq++;
+
+    if(last) {
+        KLOG(MHT, "Received DDL partition #" << id << " with " << in->partition->_storage.length() <<
+            " items in " << in->nextSeq << " chunks");
+        assert(findPartition(HashUtil::structured_hash(id, 0, NOTYPE, 0)) == nullptr);
+        // don't move it around again right away
+        in->partition->_stats.cooldown = DDL_REBALANCE_COOLDOWN;
+        partitions.append(new PartitionEntry(in->partition));
+        _incomingPartitions.remove(in);
+        delete in;
+        // we are the owner now (this drops our copies of its items as well)
+        m3::PEDesc pe = Platform::pe_by_core(id);
+        updateMembership(&pe, 1, Coordinator::get().kid(), Platform::kernel_pe(),
+            MembershipFlags::NONE, false);
+    }
+    return m3::Errors::NO_ERROR;
 }
 
 void MHTInstance::updateMembership(membership_entry::pe_id_t start, membership_entry::krnl_id_t krnl,
     membership_entry::pe_id_t krnlCore, membership_entry::capacity_t capacity, MembershipFlags flags,
     bool propagate) {
-    assert(capacity <= MAX_PES_DDL);
-    // update membership array
-    m3::PEDesc releasedPEs[capacity];
-    size_t count = 0;
-    for(membership_entry::pe_id_t id = start; id < start + capacity; id++, count++) {
-        releasedPEs[count] = Platform::pe_by_core(id);
+    assert(start + capacity <= MAX_PES_DDL);
+    // inform other kernels if this is a completed update
+    if(propagate && !(flags & MembershipFlags::MIGRATING)) {
+        membership_entry range = {start, krnl, capacity, flags};
+        Coordinator::get().broadcastMemberUpdate(&range, 1, krnl, krnlCore, flags);
     }
-    updateMembership(releasedPEs, start + capacity, krnl, krnlCore, flags, propagate);
+    applyMembership(start, capacity, krnl, krnlCore, flags);
 }
 
 void MHTInstance::updateMembership(m3::PEDesc releasedPEs[], uint numPEs, membership_entry::krnl_id_t krnl,
     membership_entry::pe_id_t krnlCore, MembershipFlags flags, bool propagate) {
     assert(numPEs <= MAX_PES_DDL);
+    if(numPEs == 0)
+        return;
+
+    membership_entry *ranges = new membership_entry[numPEs];
+    size_t numRanges = MembershipTable::toRanges(releasedPEs, numPEs, ranges);
 
     // inform other kernels if this is a completed update
     if(propagate && !(flags & MembershipFlags::MIGRATING))
-        Coordinator::get().broadcastMemberUpdate(releasedPEs, numPEs, krnl, krnlCore, flags);
-
-    size_t idx = 0;
-    for(size_t id = 0; id < numPEs; id++) {
-        idx = releasedPEs[id].core_id();
-        memberTable[idx].krnl_id = krnl;
-        if(flags != NOCHANGE) {
-            // if we modify a partition that was migrated, it finished the migration
-            // hence, remove it from the migration list
-            if(memberTable[idx].flags & MIGRATING){
-                for(auto it = _migratingPartitions.begin(); it != _migratingPartitions.end(); ) {
-                    auto old = it++;
-                    if(old->destKrnl.id() == idx) {
-                        _migratingPartitions.remove(&(*old));
-                        delete &(*old);
-                    }
-                }
+        Coordinator::get().broadcastMemberUpdate(ranges, numRanges, krnl, krnlCore, flags);
+
+    for(size_t i = 0; i < numRanges; i++)
+        applyMembership(ranges[i].pe_id, ranges[i].capacity, krnl, krnlCore, flags);
+    delete[] ranges;
+}
+
+void MHTInstance::applyMembership(membership_entry::pe_id_t start, membership_entry::capacity_t count,
+    membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags) {
+    memberTable.set(start, count, krnl, flags);
+    for(membership_entry::pe_id_t id = start; id < start + count; id++)
+        _cache.invalidatePartition(id);
+    PEManager::membership_changed(start, count);
+
+    if(flags != NOCHANGE) {
+        // if we modify a partition that was migrated, it finished the migration
+        // hence, remove it from the migration list
+        for(auto it = _migratingPartitions.begin(); it != _migratingPartitions.end(); ) {
+            auto old = it++;
+            if(old->partitionID >= start && old->partitionID < start + count) {
+                _migratingPartitions.remove(&(*old));
+                delete &(*old);
             }
-            if(flags & MIGRATING)
-                _migratingPartitions.append(new MigratingPartitionEntry(idx, krnl, krnlCore));
-            memberTable[idx].flags = flags;
+        }
+        if(flags & MIGRATING) {
+            for(membership_entry::pe_id_t id = start; id < start + count; id++)
+                _migratingPartitions.append(new MigratingPartitionEntry(id, krnl, krnlCore));
         }
     }
 }
 
 bool MHTInstance::keyLocality(mht_key_t key) {
-    if(!(memberTable[HashUtil::hashToPeId(key)].flags & MembershipFlags::MIGRATING))
+    if(!(memberTable.flags(HashUtil::hashToPeId(key)) & MembershipFlags::MIGRATING))
         return (responsibleMember(key) == Coordinator::get().kid()) ? true : false;
     else
         return false;
 }
 
+void MHTInstance::accountRemote(mht_key_t key) {
+    MHTPartition *part = findPartition(key);
+    if(part)
+        part->_stats.remote++;
+}
+
+bool MHTInstance::isMigrating(membership_entry::pe_id_t id) {
+    MHTPartition *part = findPartition(HashUtil::structured_hash(id, 0, NOTYPE, 0));
+    return part && part->_migrating;
+}
+
+bool MHTInstance::servesKey(mht_key_t key) {
+    return findPartition(key) != nullptr ||
+        getMigrationDestination(HashUtil::hashToPeId(key)) != nullptr;
+}
+
 uint MHTInstance::localPEs() const {
     membership_entry::krnl_id_t kid = Coordinator::get().kid();
     uint count = 0;
-    for(uint i = 0; i < Platform::MAX_PES; i++)
-        if(memberTable[i].krnl_id == kid && memberTable[i].flags != MembershipFlags::UNPOPULATED &&
-            memberTable[i].flags != MembershipFlags::UNMANAGED)
-            count++;
+    for(auto r = memberTable.begin(); r != memberTable.end(); r++)
+        if(r->krnl_id == kid && r->flags != MembershipFlags::UNPOPULATED &&
+            r->flags != MembershipFlags::UNMANAGED)
+            count += r->capacity;
     return count;
 }
 
+uint MHTInstance::localPEs(m3::PEDesc pes[]) {
+    membership_entry::krnl_id_t kid = Coordinator::get().kid();
+    uint count = 0;
+    for(size_t i = 0; i < Platform::pe_count(); i++) {
+        m3::PEDesc pe = Platform::pe_by_index(i);
+        // check if this PE is actually ours
+        if(responsibleKrnl(pe.core_id()) == kid)
+            pes[count++] = pe;
+    }
+    return count;
+}
+
+mht_key_t MHTInstance::serviceKey(const m3::String &name) const {
+    uint64_t hash = Service::name_hash(name);
+    // the PE ID space is sparse; only populated PEs have a partition that is managed by a kernel
+    membership_entry::pe_id_t pe = memberTable.populated(hash % memberTable.populated());
+    return HashUtil::structured_hash(pe,
+        static_cast<vpe_id_t>((hash >> 32) & ((1 << VPE_BITS) - 1)), SRVDIR, static_cast<uint>(hash));
+}
+
 void MHTInstance::printMembership() {
     KLOG(MHT, "--- Membership Table ---\n# | PE Id | kernel | capacity | flags");
-    for(uint i = 0; i < (1U << PE_BITS); i++) {
-        if(memberTable[i].flags != UNPOPULATED)
-            KLOG(MHT, "#" << i << " | " << memberTable[i].pe_id << " | " << memberTable[i].krnl_id <<
-                " | " << memberTable[i].capacity << " | " << memberTable[i].flags);
+    uint i = 0;
+    for(auto r = memberTable.begin(); r != memberTable.end(); r++, i++) {
+        if(r->flags != UNPOPULATED)
+            KLOG(MHT, "#" << i << " | " << r->pe_id << " | " << r->krnl_id <<
+                " | " << r->capacity << " | " << r->flags);
+    }
+}
+
+void MHTInstance::leavePass(ulong epoch) {
+    _activePasses--;
+    // nothing has been retired since the pass began
+    if(epoch == _epoch)
+        return;
+
+    for(auto it = _retiredPartitions.begin(); it != _retiredPartitions.end(); ) {
+        auto old = it++;
+        if(old->epoch > epoch && --old->passes == 0) {
+            KLOG(MHT, "Deleting migrated DDL partition #" << old->partition->_id);
+            _retiredPartitions.remove(&*old);
+            delete old->partition;
+            delete &*old;
+        }
+    }
+}
+
+MHTPartition* MHTInstance::findWritablePartition(mht_key_t key) {
+    MHTPartition *part = findPartition(key);
+    // the item has already been sent to the new owner of the partition. wait until the migration
+    // is finished; the request goes to the new owner afterwards.
+    while(part && !part->writable(key)) {
+        m3::ThreadManager::get().wait_for(part);
+        part = findPartition(key);
     }
+    return part;
 }
 
 MHTPartition* MHTInstance::findPartition(mht_key_t key) {
@@ -23,6 +23,9 @@
 #include "pes/KPE.h"
 #include "ddl/MHTTypes.h"
 #include "ddl/MHTPartition.h"
+#include "ddl/MHTCache.h"
+#include "ddl/MembershipTable.h"
+#include "ddl/MHTRebalancer.h"
 #include "KernelcallHandler.h"
 #include "Coordinator.h"
 #include "Platform.h"
@@ -34,9 +37,35 @@ struct PartitionEntry : public m3::SListItem {
     MHTPartition* partition;
 };
 
+/**
+ * A partition that is currently received from another kernel. It is not visible until the last
+ * chunk has been received.
+ */
+struct IncomingPartition : public m3::SListItem {
+    explicit IncomingPartition(MHTPartition *part, membership_entry::krnl_id_t src)
+        : partition(part), source(src), nextSeq(0) {}
+    MHTPartition* partition;
+    membership_entry::krnl_id_t source;
+    uint nextSeq;
+};
+
+/**
+ * A partition that has been migrated to another kernel, but might still be used by threads that
+ * were in the middle of an operation when it was migrated.
+ */
+struct RetiredPartition : public m3::SListItem {
+    explicit RetiredPartition(MHTPartition *part, ulong ep, size_t activePasses)
+        : partition(part), epoch(ep), passes(activePasses) {}
+    MHTPartition* partition;
+    ulong epoch;
+    // the number of WorkLoop passes that have been active at that time and are not finished yet
+    size_t passes;
+};
+
 class MHTInstance {
     friend KernelcallHandler;
     friend KPE;
+    friend MHTRebalancer;
 public:
     MHTInstance(const MHTInstance &) = delete;
     MHTInstance &operator=(const MHTInstance &) = delete;
@@ -44,14 +73,17 @@ public:
     static void create(){
         _inst = new MHTInstance();
     }
-    static void create(uint64_t memberTab, uint64_t parts, size_t partsSize){
-        _inst = new MHTInstance(memberTab, parts, partsSize);
+    static void create(uint64_t memberTab, size_t memberTabSize, uint64_t parts, size_t partsSize){
+        _inst = new MHTInstance(memberTab, memberTabSize, parts, partsSize);
     }
 
     static MHTInstance& getInstance(){
         return *_inst;
     }
 
+    // the number of unacknowledged chunks during a partition migration
+    static const uint MIGRATION_WINDOW = KernelcallHandler::MAX_MSG_INFLIGHT - 2;
+
     m3::Errors::Code put(MHTItem &&kv_pair);
     m3::Errors::Code putUnlocking(MHTItem &&item, uint lockHandle);
 
@@ -70,8 +102,12 @@ public:
 
     bool unlock(mht_key_t mht_key, uint lockHandle);
     inline bool unlockLocal(mht_key_t mht_key, uint lockHandle) {
-        MHTPartition *part = findPartition(mht_key);
-        assert(part);
+        MHTPartition *part = findWritablePartition(mht_key);
+        // the partition has been migrated in the meantime
+        if(!part) {
+            assert(responsibleMember(mht_key) != Coordinator::get().kid());
+            return unlock(mht_key, lockHandle);
+        }
         return part->unlock(mht_key, lockHandle);
     }
 
@@ -92,16 +128,65 @@ public:
      */
     m3::Errors::Code release(mht_key_t mht_key, uint reservation);
 
+    /**
+     * Batched versions of get, put, lock and unlock. The keys of remote partitions are grouped by
+     * the responsible kernel and sent with as few kernelcalls as possible (see Kernelcalls::MHTGETV
+     * and friends). If a kernel answers that a partition has been migrated, the membership table is
+     * updated and the keys are sent to the new owner. The result for the i-th key is stored in
+     * <res>[i]: NO_ERROR on success, NO_SUCH_FILE if the item does not exist and INV_ARGS if the
+     * responsible kernel is unknown.
+     *
+     * @param keys          the keys
+     * @param items         the items to put (on success, the data belongs to the DDL afterwards)
+     * @param count         the number of keys/items
+     * @param data          will be set to the data of the items (nullptr if not existing)
+     * @param lockHandles   lockv: receives the lock handles; unlockv: the lock handles to use;
+     *                      putv: the lock handles to use for locked items (may be nullptr)
+     * @param res           the results
+     */
+    void getv(const mht_key_t keys[], size_t count, void *data[], m3::Errors::Code res[]);
+    void putv(MHTItem *items[], size_t count, const uint lockHandles[], m3::Errors::Code res[]);
+    void lockv(const mht_key_t keys[], size_t count, uint lockHandles[], m3::Errors::Code res[]);
+    void unlockv(const mht_key_t keys[], size_t count, const uint lockHandles[], m3::Errors::Code res[]);
+
     /**
      * Migrates partitions which are owned by the local kernel to another kernel.
      *
      * @param pes       Array of PEs for which the partitions should be migrated
      * @param numPEs    Number of PEs to be migrated
      * @param receiver  The target kernel
+     * @return  the error of the first migration that failed
+     */
+    m3::Errors::Code migratePartitions(m3::PEDesc pes[], uint numPEs, membership_entry::krnl_id_t receiver);
+
+    /**
+     * Migrates the partition <id> to <receiver>. The items are streamed in chunks that fit into
+     * a kernelcall message and at most MIGRATION_WINDOW chunks are unacknowledged at a time.
+     * Meanwhile, the partition keeps answering requests: items that have not been sent yet can
+     * still be changed, whereas requests that change sent items wait until the migration is
+     * finished and go to the new owner afterwards. The receiver makes the partition visible with
+     * the last chunk. Afterwards, the new owner is announced to all kernels and requests that
+     * still arrive here are forwarded (see getMigrationDestination).
+     *
+     * @param id        The partition
+     * @param receiver  The target kernel
+     * @return  m3::Errors::NO_ERROR on success
      */
-    void migratePartitions(m3::PEDesc pes[], uint numPEs, membership_entry::krnl_id_t receiver);
+    m3::Errors::Code migratePartition(membership_entry::pe_id_t id, membership_entry::krnl_id_t receiver);
 
-    void receivePartitions(GateIStream & is);
+    /**
+     * Applies a chunk of a partition that is migrated from kernel <src> to us.
+     *
+     * @param is        The stream containing the items
+     * @param src       The sender
+     * @param seq       The sequence number of the chunk
+     * @param id        The partition
+     * @param last      Whether this is the last chunk, which finishes the migration
+     * @param count     The number of items in the chunk
+     * @return  m3::Errors::NO_ERROR on success
+     */
+    m3::Errors::Code receivePartitionChunk(GateIStream &is, membership_entry::krnl_id_t src, uint seq,
+        membership_entry::pe_id_t id, bool last, size_t count);
 
     void finishMigration(membership_entry::krnl_id_t krnlId);
 
@@ -136,8 +221,38 @@ public:
 
     bool keyLocality(mht_key_t key);
 
+    /**
+     * @param key   The key
+     * @return  true if requests of other kernels for <key> are answered by us, i.e., if the
+     *          partition is stored here or we have migrated it to another kernel, in which case the
+     *          request is forwarded
+     */
+    bool servesKey(mht_key_t key);
+
+    /**
+     * @param key   The key
+     * @return  true if the partition containing <key> is stored here
+     */
+    bool ownsKey(mht_key_t key) {
+        return findPartition(key) != nullptr;
+    }
+
+    /**
+     * Counts a request for <key> that has been received from another kernel in the statistics of
+     * the partition, if it is stored here.
+     *
+     * @param key   The key
+     */
+    void accountRemote(mht_key_t key);
+
+    /**
+     * @param id    The partition
+     * @return  true if the partition is currently migrated to another kernel
+     */
+    bool isMigrating(membership_entry::pe_id_t id);
+
     membership_entry::krnl_id_t inline responsibleKrnl(membership_entry::pe_id_t peid) {
-        return memberTable[peid].krnl_id;
+        return memberTable.krnl(peid);
     }
     membership_entry::krnl_id_t inline responsibleMember(mht_key_t key) {
         // membership table lookup
@@ -145,9 +260,60 @@ public:
     }
 
     uint localPEs() const;
+    /**
+     * Stores the descriptors of our PEs in <pes>, which needs room for Platform::pe_count() PEs.
+     * @return the number of PEs
+     */
+    uint localPEs(m3::PEDesc pes[]);
+
+    /**
+     * Determines the key of the service directory entry for the service <name>. The key is derived
+     * from a hash of the name and belongs to a populated PE, so that every kernel finds the
+     * entry without knowing where the service lives. Different names might map to the same key.
+     *
+     * @param name  The name of the service
+     * @return  The key of the SRVDIR item
+     */
+    mht_key_t serviceKey(const m3::String &name) const;
 
     MHTPartition* findPartition(mht_key_t key);
 
+    /**
+     * @return the cache for items of remote partitions
+     */
+    MHTCache &cache() {
+        return _cache;
+    }
+
+    /**
+     * @return the number of items that have been migrated to other kernels
+     */
+    size_t migratedItems() const {
+        return _migratedItems;
+    }
+    /**
+     * @return the time spent on migrating partitions to other kernels in cycles
+     */
+    cycles_t migrationCycles() const {
+        return _migrationCycles;
+    }
+
+    /**
+     * Marks the beginning of a pass of the WorkLoop. Threads keep references to the items they
+     * got from a partition until the end of their pass, also if they block in between.
+     *
+     * @return the epoch to pass to leavePass
+     */
+    ulong enterPass() {
+        _activePasses++;
+        return _epoch;
+    }
+    /**
+     * Marks the end of a pass that began in <epoch>. Partitions that have been migrated to other
+     * kernels are deleted as soon as all passes that were active at that time are finished.
+     */
+    void leavePass(ulong epoch);
+
     KPE* getMigrationDestination(membership_entry::pe_id_t partID) {
         for(auto it = _migratingPartitions.begin(); it != _migratingPartitions.end(); it++) {
             if(it->partitionID == partID)
@@ -161,14 +327,63 @@ public:
     void printContents();
 
 private:
+    /**
+     * The state of an outgoing partition migration. It lives on the stack of the sending thread and
+     * its address is sent along with the chunks, so that the acknowledgements can be stored in it.
+     */
+    struct PartitionMigration {
+        explicit PartitionMigration(MHTPartition *_part, KPE *_dest)
+            : part(_part), dest(_dest), tid(m3::ThreadManager::get().current()->id()), sent(0),
+              acked(0), err(m3::Errors::NO_ERROR) {
+        }
+
+        MHTPartition *part;
+        KPE *dest;
+        int tid;
+        uint sent;
+        uint acked;
+        m3::Errors::Code err;
+    };
+
     explicit MHTInstance();
-    explicit MHTInstance(uint64_t memberTab, uint64_t parts, size_t partsSize);
+
+    /**
+     * Like findPartition, but waits until the migration of the partition is finished if the item
+     * for <key> must not be changed (see MHTPartition::writable).
+     */
+    MHTPartition* findWritablePartition(mht_key_t key);
+
+    /**
+     * Sends the next chunk of <mig> with sequence number mig.sent.
+     */
+    void sendPartitionChunk(PartitionMigration &mig, mht_key_t keys[], size_t &pos, size_t end,
+        size_t &deferred, bool last);
+    void partitionChunkAcked(uintptr_t migration, uint seq, m3::Errors::Code res);
+
+    /**
+     * Applies a membership update for the PEs <start> .. <start> + <count> - 1 locally.
+     */
+    void applyMembership(membership_entry::pe_id_t start, membership_entry::capacity_t count,
+        membership_entry::krnl_id_t krnl, membership_entry::pe_id_t krnlCore, MembershipFlags flags);
+
+    void batch(Kernelcalls::Operation op, DDLBatch &all);
+    bool batchLocal(Kernelcalls::Operation op, DDLBatch &all, size_t i);
+    bool batchMoved(mht_key_t key, membership_entry::krnl_id_t asked, membership_entry::krnl_id_t owner);
+    explicit MHTInstance(uint64_t memberTab, size_t memberTabSize, uint64_t parts, size_t partsSize);
 
     // list of MHTPartitions
     m3::SList<PartitionEntry> partitions;
     // membership table
-    membership_entry *memberTable;
+    MembershipTable memberTable;
     m3::SList<MigratingPartitionEntry> _migratingPartitions;
+    m3::SList<IncomingPartition> _incomingPartitions;
+    MHTCache _cache;
+    size_t _migratedItems;
+    cycles_t _migrationCycles;
+    m3::SList<RetiredPartition> _retiredPartitions;
+    // incremented whenever a partition is retired
+    ulong _epoch;
+    size_t _activePasses;
     static MHTInstance *_inst;
 
     // TODO
@@ -184,5 +399,7 @@ private:
     };
     static nextResItem nextIdx;
     static MHTItem resItems[3];
+    // copies of cached items, owned by the corresponding entry in resItems
+    static void *resData[3];
 };
 }
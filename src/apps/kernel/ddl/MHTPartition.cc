@@ -16,7 +16,6 @@
  */
 
 #include <base/log/Kernel.h>
-#include <base/col/SList.h>
 #include <base/util/Util.h>
 #include <base/Heap.h>
 #include <base/Errors.h>
@@ -24,43 +23,44 @@
 
 #include "ddl/MHTPartition.h"
 #include "ddl/MHTInstance.h"
+#include "mem/SlabCache.h"
+#include "Kernelcalls.h"
 
 namespace kernel {
 
 const MHTItem MHTPartition::emptyIndicator;
+size_t MHTPartition::_accesses = 0;
 
-struct MHTItemStorable : m3::SListItem {
-    MHTItemStorable(MHTItem &&dat) : data(m3::Util::move(dat)) {}
+struct MHTItemStorable : public SlabObject<MHTItemStorable> {
+    MHTItemStorable(MHTItem &&dat) : data(m3::Util::move(dat)), sent(false) {}
     MHTItem data;
+    // true if the item has been sent to the new owner of the partition during a migration
+    bool sent;
 };
 
 MHTPartition::~MHTPartition() {
-    for(auto it = _storage.begin(); it != _storage.end(); it++) {
-        if(it.operator ->() != nullptr)
-            m3::Heap::free(it.operator ->());
-    }
-    _storage.remove_all();
+    for(auto it = _storage.begin(); it != _storage.end(); it++)
+        delete &(*it);
+    _storage.clear();
 }
 
 m3::Errors::Code MHTPartition::put(MHTItem &&kv_pair, uint lockHandle) {
+    account(_stats.puts);
     // check if this replaces another item
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == kv_pair._mht_key) {
-            if(!it->data.islocked() || lockHandle == it->data.getLockHandle()) {
-                if(lockHandle)
-                    it->data.lockHandle = 0;
-                if(it->data.data)
-                    m3::Heap::free(it->data.data);
-                it->data.transferData(kv_pair);
-                return m3::Errors::NO_ERROR;
-            } else {
-                if(lockHandle == it->data.getLockHandle())
-                KLOG(MHT, "Inserting MHTItem failed! Item is locked. mhtKey: " <<
-                    PRINT_HASH(kv_pair._mht_key) << " lockHandle: " << kv_pair.getLockHandle() <<
-                    " (" << lockHandle << ")");
-                return m3::Errors::NO_PERM;
-            }
+    MHTItemStorable *existing = _storage.find(kv_pair._mht_key);
+    if(existing) {
+        if(!existing->data.islocked() || lockHandle == existing->data.getLockHandle()) {
+            // transferData frees the old data
+            existing->data.transferData(kv_pair);
+            // wake up the threads that wait for the (reserved) item
+            if(lockHandle)
+                existing->data.unlock(lockHandle);
+            return m3::Errors::NO_ERROR;
         }
+        KLOG(MHT, "Inserting MHTItem failed! Item is locked. mhtKey: " <<
+            PRINT_HASH(kv_pair._mht_key) << " lockHandle: " << kv_pair.getLockHandle() <<
+            " (" << lockHandle << ")");
+        return m3::Errors::NO_PERM;
     }
     // otherwise create a new item for the kv_pair
     MHTItemStorable *item = new MHTItemStorable(m3::Util::move(kv_pair));
@@ -68,98 +68,91 @@ m3::Errors::Code MHTPartition::put(MHTItem &&kv_pair, uint lockHandle) {
         KLOG(ERR, "Could not get storage for item in MHT!");
         return m3::Errors::OUT_OF_MEM;
     }
-    _storage.append(item);
+    _storage.insert(item->data._mht_key, item);
     return m3::Errors::NO_ERROR;
 }
 
 const MHTItem &MHTPartition::get(mht_key_t mht_key, bool locking) {
+    account(locking ? _stats.locks : _stats.gets);
     // Note: we enforce the locking policy here
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key) {
-            if(it->data.islocked()) {
-                // let this thread wait until the item is unlocked
-                it->data.enqueueTicket();
-            }
-            if(locking)
-                it->data.lock();
-
-            return it->data;
-        }
+    MHTItemStorable *item = _storage.find(mht_key);
+    if(!item) {
+        // not found - return an empty item
+        return emptyIndicator;
     }
-    // not found - return an empty item
-    return emptyIndicator;
+
+    if(item->data.islocked()) {
+        // let this thread wait until the item is unlocked
+        item->data.enqueueTicket();
+    }
+    if(locking)
+        item->data.lock();
+    return item->data;
 }
 
 bool MHTPartition::remove(mht_key_t mht_key) {
     // TODO
     // if there are waiting requests, delete them and answer them as failed
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key) {
-            if(it.operator ->() != nullptr)
-                m3::Heap::free(it.operator ->());
-            return _storage.remove(it.operator ->());
-        }
-    }
-    return false;
+    account(_stats.puts);
+    MHTItemStorable *item = _storage.remove(mht_key);
+    if(!item)
+        return false;
+    delete item;
+    return true;
 }
 
 int MHTPartition::lock(mht_key_t mht_key) {
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key) {
-            if(it->data.islocked()) {
-                return -1;
-            }
-            return it->data.lock();
-        }
+    account(_stats.locks);
+    MHTItemStorable *item = _storage.find(mht_key);
+    if(!item) {
+        // not found - locking impossible
+        KLOG(MHT, "MHT: Could not lock key " << PRINT_HASH(mht_key) << " (not found).");
+        return 0;
     }
-    // not found - locking impossible
-    KLOG(MHT, "MHT: Could not lock key " << PRINT_HASH(mht_key) << " (not found).");
-    return 0;
+    if(item->data.islocked())
+        return -1;
+    return item->data.lock();
 }
 
 bool MHTPartition::unlock(mht_key_t mht_key, uint lockHandle) {
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key)
-            return it->data.unlock(lockHandle);
-    }
+    account(_stats.locks);
+    MHTItemStorable *item = _storage.find(mht_key);
     // not found - unlocking succeeds
-    return true;
+    if(!item)
+        return true;
+    return item->data.unlock(lockHandle);
 }
 
 uint MHTPartition::reserve(mht_key_t mht_key) {
+    account(_stats.puts);
     // check whether there exists an item already
-    for(auto it = _storage.begin(); it != _storage.end(); it++)
-        if(it->data._mht_key == mht_key)
-            return 0;
+    if(_storage.find(mht_key))
+        return 0;
 
     // reserve the slot
     MHTItem placeholder(nullptr, 0, mht_key);
     placeholder.reservation = true;
     uint reservationNr = placeholder.lock();
-    _storage.append(new MHTItemStorable(m3::Util::move(placeholder)));
+    _storage.insert(mht_key, new MHTItemStorable(m3::Util::move(placeholder)));
     return reservationNr;
 }
 
 m3::Errors::Code MHTPartition::release(mht_key_t mht_key, uint reservation) {
-    m3::Errors::Code err = m3::Errors::NO_ERROR;
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key) {
-            if(it->data.unlock(reservation)) {
-                delete &(*it);
-                break;
-            }
-            else
-                err = m3::Errors::NO_PERM;
-        }
-    }
-    return err;
+    account(_stats.puts);
+    MHTItemStorable *item = _storage.find(mht_key);
+    if(!item)
+        return m3::Errors::NO_ERROR;
+    if(!item->data.unlock(reservation))
+        return m3::Errors::NO_PERM;
+    _storage.remove(mht_key);
+    delete item;
+    return m3::Errors::NO_ERROR;
 }
 
 void MHTPartition::enqueueTicket(mht_key_t mht_key) {
-    for(auto it = _storage.begin(); it != _storage.end(); it++){
-        if(it->data._mht_key == mht_key)
-            it->data.enqueueTicket();
-    }
+    MHTItemStorable *item = _storage.find(mht_key);
+    if(item)
+        item->data.enqueueTicket();
 }
 
 size_t MHTPartition::serializedSize() {
@@ -179,24 +172,83 @@ template<class T>
 m3::Errors::Code MHTPartition::deserialize(T &ser) {
     size_t numItems;
     ser >> _id >> numItems;
+    m3::Errors::Code res = deserializeItems(ser, numItems);
+    if(res != m3::Errors::NO_ERROR) {
+        for(auto it = _storage.begin(); it != _storage.end(); it++)
+            delete &(*it);
+        _storage.clear();
+    }
+    return res;
+}
+
+template<class T>
+m3::Errors::Code MHTPartition::deserializeItems(T &ser, size_t numItems) {
     for(size_t i = 0; i < numItems; i++) {
         MHTItem it(ser);
         MHTItemStorable *item = new MHTItemStorable(m3::Util::move(it));
         if(!item) {
             KLOG(ERR, "Could not get storage for item in MHT!");
-            for(auto it = _storage.begin(); it != _storage.end(); ) {
-                auto old = it++;
-                delete &(*old);
-            }
-            _storage.remove_all();
             return m3::Errors::OUT_OF_MEM;
         }
-        _storage.append(item);
+        MHTItemStorable *old = _storage.insert(item->data._mht_key, item);
+        if(old)
+            delete old;
     }
     return m3::Errors::NO_ERROR;
 }
 template m3::Errors::Code MHTPartition::deserialize<m3::Unmarshaller>(m3::Unmarshaller &ser);
 template m3::Errors::Code MHTPartition::deserialize<GateIStream>(GateIStream &ser);
+template m3::Errors::Code MHTPartition::deserializeItems<GateIStream>(GateIStream &ser, size_t numItems);
+
+size_t MHTPartition::startMigration(mht_key_t keys[]) {
+    size_t count = 0;
+    for(auto it = _storage.begin(); it != _storage.end(); it++)
+        keys[count++] = it.key();
+    _migrating = true;
+    return count;
+}
+
+size_t MHTPartition::serializeChunk(BatchGateOStream &ser, mht_key_t keys[], size_t &pos, size_t end,
+        size_t &deferred) {
+    size_t n = 0;
+    for(; pos < end; ++pos) {
+        MHTItemStorable *item = _storage.find(keys[pos]);
+        // removed in the meantime
+        if(!item || item->sent)
+            continue;
+        if(item->data.islocked()) {
+            keys[deferred++] = keys[pos];
+            continue;
+        }
+        if(!ser.has_space(item->data.serializedSize()))
+            break;
+        item->data.serialize(ser);
+        item->sent = true;
+        n++;
+    }
+    return n;
+}
+
+void MHTPartition::waitUnlocked(mht_key_t mht_key) {
+    MHTItemStorable *item = _storage.find(mht_key);
+    while(item && item->data.islocked()) {
+        item->data.enqueueTicket();
+        item = _storage.find(mht_key);
+    }
+}
+
+void MHTPartition::abortMigration() {
+    for(auto it = _storage.begin(); it != _storage.end(); it++)
+        it->sent = false;
+    _migrating = false;
+}
+
+bool MHTPartition::writable(mht_key_t mht_key) const {
+    if(!_migrating)
+        return true;
+    MHTItemStorable *item = _storage.find(mht_key);
+    return item && !item->sent;
+}
 
 void MHTPartition::printItems() {
     KLOG(MHT, "-- Printing Items of partition #" << _id);
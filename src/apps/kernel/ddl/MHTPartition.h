@@ -17,7 +17,7 @@
 
 #pragma once
 
-#include <base/col/SList.h>
+#include <base/col/HashTable.h>
 
 #include "MHTTypes.h"
 
@@ -26,17 +26,65 @@ namespace kernel {
 struct MHTItem;
 struct MHTItemStorable;
 class MHTInstance;
+class MHTRebalancer;
+class BatchGateOStream;
+#ifdef KERNEL_TESTS
+class DDLTestSuite;
+#endif
 
 class MHTPartition {
     friend MHTInstance;
+    friend MHTRebalancer;
     friend KPE;
+#ifdef KERNEL_TESTS
+    friend DDLTestSuite;
+#endif
 public:
-    MHTPartition(membership_entry::pe_id_t id) : _id(id), _storage() {}
+    /**
+     * The access statistics of a partition, which are used by the MHTRebalancer. The counters are
+     * halved at the end of every rebalancing epoch, so that they reflect the recent load.
+     */
+    struct Stats {
+        explicit Stats() : gets(), puts(), locks(), remote(), cooldown() {
+        }
+
+        size_t load() const {
+            return gets + puts + locks;
+        }
+        void decay() {
+            gets /= 2;
+            puts /= 2;
+            locks /= 2;
+            remote /= 2;
+            if(cooldown)
+                cooldown--;
+        }
+
+        size_t gets;
+        size_t puts;
+        size_t locks;
+        // the number of the above requests that came from other kernels
+        size_t remote;
+        // the number of epochs until the partition may be migrated again
+        uint cooldown;
+    };
+
+    MHTPartition(membership_entry::pe_id_t id) : _id(id), _migrating(false), _storage(), _stats() {}
     MHTPartition(const MHTPartition &) = delete;
     MHTPartition &operator=(const MHTPartition &) = delete;
     MHTPartition(MHTPartition &&) = delete;
     ~MHTPartition();
 
+    const Stats &stats() const {
+        return _stats;
+    }
+    /**
+     * @return the number of accesses to all partitions of this kernel so far
+     */
+    static size_t accesses() {
+        return _accesses;
+    }
+
     //debug
     void printItems();
 
@@ -136,8 +184,75 @@ private:
     template<class T>
     m3::Errors::Code deserialize(T &ser);
 
+    /**
+     * Reads <numItems> items from the stream and inserts them into this partition, replacing
+     * existing items with the same key. This is used to apply the chunks of a migration.
+     *
+     * @param ser       Stream to read from
+     * @param numItems  Number of items in the stream
+     * @return      m3::Errors::OUT_OF_MEM if allocating memory for items fails.
+     */
+    template<class T>
+    m3::Errors::Code deserializeItems(T &ser, size_t numItems);
+
+    /**
+     * Starts the migration of this partition to another kernel and stores the keys of all items
+     * in <keys>, which has to have space for _storage.length() keys. From now on, items that have
+     * been sent to the new owner are not changed anymore (see <writable>).
+     *
+     * @param keys  Receives the keys of the items to send
+     * @return      Number of keys
+     */
+    size_t startMigration(mht_key_t keys[]);
+
+    /**
+     * Appends the items for <keys>[<pos>] to <keys>[<end> - 1] to <ser> until it is full and
+     * marks them as sent. Removed items are skipped. Locked items can't be sent, because the
+     * lock holder still works on it; their keys are moved to <keys>[0] to <keys>[<deferred> - 1]
+     * to send them later.
+     *
+     * @param ser       Stream to write to
+     * @param keys      The keys of the items to send
+     * @param pos       The next key to send; is updated accordingly
+     * @param end       The end of <keys>
+     * @param deferred  Number of deferred keys; is updated accordingly
+     * @return      Number of items appended
+     */
+    size_t serializeChunk(BatchGateOStream &ser, mht_key_t keys[], size_t &pos, size_t end,
+        size_t &deferred);
+
+    /**
+     * Lets the current thread wait until the item with the given key is not locked anymore.
+     *
+     * @param mht_key   Key of the item
+     */
+    void waitUnlocked(mht_key_t mht_key);
+
+    /**
+     * Aborts a migration, i.e., allows changes to all items again.
+     */
+    void abortMigration();
+
+    /**
+     * During a migration, items that have been sent to the new owner must not be changed
+     * anymore. The same holds for keys that do not exist, because they will be created at the
+     * new owner.
+     *
+     * @param mht_key   The key of the item to change
+     * @return  true if the item can be changed in this partition
+     */
+    bool writable(mht_key_t mht_key) const;
+
+    void account(size_t &counter) {
+        counter++;
+        _accesses++;
+    }
+
     membership_entry::pe_id_t _id;
-    m3::SList<MHTItemStorable> _storage;
+    bool _migrating;
+    m3::HashTable<mht_key_t, MHTItemStorable> _storage;
+    Stats _stats;
+    static size_t _accesses;
     static const MHTItem emptyIndicator;
 };
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Kernel.h>
+
+#include "ddl/MHTRebalancer.h"
+#include "ddl/MHTInstance.h"
+#include "pes/PEManager.h"
+#include "Coordinator.h"
+#include "Kernelcalls.h"
+#include "Platform.h"
+
+namespace kernel {
+
+MHTRebalancer MHTRebalancer::_inst;
+
+void MHTRebalancer::rebalance() {
+    Coordinator &coord = Coordinator::get();
+    _epochStart = MHTPartition::accesses();
+    // don't move partitions around while the kernels shut down
+    if(coord.shutdownIssued)
+        return;
+
+    _running = true;
+    _epochs++;
+
+    // tell the others about our load
+    size_t load = localLoad();
+    KVStore<size_t, KPE*> &kpes = coord.getKPEList();
+    for(auto it = kpes.begin(); it != kpes.end(); it++)
+        Kernelcalls::get().ddlLoad(it->val, load);
+
+    // determine the average load and the least loaded kernel
+    size_t total = load;
+    uint kernels = 1;
+    KPE *target = nullptr;
+    size_t targetLoad = 0;
+    for(auto it = kpes.begin(); it != kpes.end(); it++) {
+        if(!_peerLoads.exists(it->id))
+            continue;
+        size_t peer = _peerLoads.get(it->id);
+        total += peer;
+        kernels++;
+        if(!target || peer < targetLoad) {
+            target = it->val;
+            targetLoad = peer;
+        }
+    }
+    KLOG(MHT, "DDL rebalancing epoch " << _epochs << ": load=" << load << ", avg="
+        << total / kernels << ", least loaded kernel #" << (target ? target->id() : 0) << " ("
+        << targetLoad << ")");
+
+    if(target && load * kernels * 100 > total * DDL_REBALANCE_THRESHOLD) {
+        MHTPartition *part = selectPartition(load - targetLoad);
+        if(part) {
+            membership_entry::pe_id_t id = part->_id;
+            size_t partLoad = part->_stats.load();
+            KLOG(MHT, "Moving DDL partition #" << id << " (load=" << partLoad << ", remote="
+                << part->_stats.remote << ") to kernel #" << target->id());
+            // note that the partition is gone afterwards
+            if(MHTInstance::getInstance().migratePartition(id, target->id()) == m3::Errors::NO_ERROR) {
+                _migrations++;
+                _migratedLoad += partLoad;
+                // until it reports again, assume that the target got the load of the partition
+                _peerLoads.put(target->id(), targetLoad + partLoad);
+            }
+        }
+    }
+
+    // start the next epoch
+    MHTInstance &mht = MHTInstance::getInstance();
+    for(auto it = mht.partitions.begin(); it != mht.partitions.end(); it++)
+        it->partition->_stats.decay();
+    _running = false;
+}
+
+size_t MHTRebalancer::localLoad() {
+    size_t load = 0;
+    MHTInstance &mht = MHTInstance::getInstance();
+    for(auto it = mht.partitions.begin(); it != mht.partitions.end(); it++)
+        load += it->partition->_stats.load();
+    return load;
+}
+
+MHTPartition *MHTRebalancer::selectPartition(size_t diff) {
+    MHTInstance &mht = MHTInstance::getInstance();
+    MHTPartition *best = nullptr;
+    for(auto it = mht.partitions.begin(); it != mht.partitions.end(); it++) {
+        MHTPartition *part = it->partition;
+        membership_entry::pe_id_t id = part->_id;
+        size_t load = part->_stats.load();
+        // moving the partition has to reduce the difference to the target
+        if(load == 0 || load * 2 >= diff || part->_stats.cooldown || part->_migrating)
+            continue;
+        if(mht.memberTable.flags(id) != MembershipFlags::NONE)
+            continue;
+        // the partitions of kernels and VPEs are bound to this kernel
+        if(id == Platform::kernel_pe() || Coordinator::get().isKPE(id) ||
+            PEManager::get().exists(id) || Platform::pe_by_core(id).type() == m3::PEType::MEM)
+            continue;
+        if(!best || load > best->_stats.load())
+            best = part;
+    }
+    return best;
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+
+#include "ddl/MHTTypes.h"
+#include "ddl/MHTPartition.h"
+#include "KVStore.h"
+
+// the number of accesses to the local partitions after which the load is rebalanced (0 = never)
+#ifndef DDL_REBALANCE_EPOCH
+#   define DDL_REBALANCE_EPOCH      0
+#endif
+// the load in percent of the average load above which partitions are given away
+#ifndef DDL_REBALANCE_THRESHOLD
+#   define DDL_REBALANCE_THRESHOLD  150
+#endif
+// the number of epochs a migrated partition stays at its new owner at least
+#ifndef DDL_REBALANCE_COOLDOWN
+#   define DDL_REBALANCE_COOLDOWN   4
+#endif
+
+namespace kernel {
+
+/**
+ * Balances the DDL load between the kernels by migrating hot partitions to less loaded kernels.
+ *
+ * The kernels count the accesses to their partitions (see MHTPartition::Stats). After every
+ * DDL_REBALANCE_EPOCH accesses, a kernel tells the others about its load in this epoch. If its load
+ * exceeds DDL_REBALANCE_THRESHOLD percent of the average load, it migrates the hottest partition to
+ * the least loaded kernel, but only if that reduces the difference between both. Since the
+ * receiver does not give the partition away for DDL_REBALANCE_COOLDOWN epochs, partitions do not
+ * bounce between kernels.
+ *
+ * Only partitions of PEs without a VPE are moved, because the capabilities of a VPE are stored in
+ * the CapTables of its kernel. Thus, a migration moves a free PE to another kernel.
+ */
+class MHTRebalancer {
+public:
+    static MHTRebalancer &get() {
+        return _inst;
+    }
+
+    explicit MHTRebalancer()
+        : _epochStart(), _running(false), _peerLoads(), _epochs(), _migrations(), _migratedLoad() {
+    }
+    MHTRebalancer(const MHTRebalancer &) = delete;
+    MHTRebalancer &operator=(const MHTRebalancer &) = delete;
+
+    /**
+     * Rebalances the load if the current epoch is over. This is called by the workloop and might
+     * block the current thread during a migration.
+     */
+    void tick() {
+#if DDL_REBALANCE_EPOCH > 0
+        if(_running || MHTPartition::accesses() - _epochStart < DDL_REBALANCE_EPOCH)
+            return;
+        rebalance();
+#endif
+    }
+
+    /**
+     * Stores the load of kernel <krnl> in its last epoch.
+     */
+    void peerLoad(membership_entry::krnl_id_t krnl, size_t load) {
+        _peerLoads.put(krnl, load);
+    }
+
+    ulong epochs() const {
+        return _epochs;
+    }
+    ulong migrations() const {
+        return _migrations;
+    }
+    size_t migratedLoad() const {
+        return _migratedLoad;
+    }
+
+private:
+    void rebalance();
+    size_t localLoad();
+    MHTPartition *selectPartition(size_t maxLoad);
+
+    size_t _epochStart;
+    bool _running;
+    KVStore<size_t, size_t> _peerLoads;
+    ulong _epochs;
+    ulong _migrations;
+    size_t _migratedLoad;
+    static MHTRebalancer _inst;
+};
+
+}
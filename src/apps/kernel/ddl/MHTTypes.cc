@@ -20,6 +20,8 @@
 #include <thread/ThreadManager.h>
 #include <base/util/Util.h>
 
+#include <cstring>
+
 #include "ddl/MHTTypes.h"
 #include "ddl/MHTInstance.h"
 #include "pes/VPE.h"
@@ -28,6 +30,13 @@
 
 namespace kernel {
 
+ServiceEntry *ServiceEntry::create(mht_key_t srvId, const char *name, size_t len) {
+    ServiceEntry *e = static_cast<ServiceEntry*>(m3::Heap::alloc(size(len)));
+    e->srvId = srvId;
+    memcpy(e + 1, name, len);
+    return e;
+}
+
 MHTItem::MHTItem(MHTItem &&m) : data(m.data), _mht_key(m._mht_key), length(m.length),
         lockHandle(m.lockHandle), reservation(m.reservation), _tickets(m3::Util::move(m._tickets)) {
     m.data = nullptr;
@@ -56,6 +65,9 @@ void MHTItem::transferData(MHTItem &src) {
     if(data)
         m3::Heap::free(data);
     data = src.data;
+    length = src.length;
+    // a reservation is a placeholder until it receives data
+    reservation = false;
     src.data = nullptr;
 }
 
@@ -72,6 +84,12 @@ size_t MHTItem::serializedSize() const {
             return size + static_cast<VPECapability*>(data)->serializedSize();
         case MEMCAP:
             return size + static_cast<MemCapability*>(data)->serializedSize();
+        case SRVDIR:
+            // reservations have no data yet
+            if(!data)
+                return size;
+            return size + m3::vostreamsize(m3::ostreamsize<mht_key_t, size_t>(),
+                length - sizeof(ServiceEntry));
         case NOTYPE:
         default:
             return size + m3::vostreamsize(m3::ostreamsize<size_t>() + length);
@@ -100,6 +118,13 @@ void MHTItem::serialize(GateOStream &ser) const {
         case MEMCAP:
             static_cast<MemCapability*>(data)->serialize(ser);
             return;
+        case SRVDIR:
+            if(data) {
+                const ServiceEntry *e = static_cast<const ServiceEntry*>(data);
+                ser << e->srvId;
+                ser.put_str(e->name(), length - sizeof(ServiceEntry));
+            }
+            return;
         case SERVICE:
         case MSGOBJ:
             PANIC("Not implemented");
@@ -135,6 +160,14 @@ void MHTItem::deserialize(T &is) {
         case MEMCAP:
             data = new MemCapability(is, _mht_key);
             return;
+        case SRVDIR:
+            if(length) {
+                mht_key_t srvId;
+                m3::String name;
+                is >> srvId >> name;
+                data = ServiceEntry::create(srvId, name.c_str(), name.length());
+            }
+            return;
         case SERVICE:
         case MSGOBJ:
             PANIC("Not implemented");
@@ -142,6 +175,12 @@ void MHTItem::deserialize(T &is) {
             PANIC("Not implemented");
         case NOTYPE:
         default:
+            // the reply to a get for a non-existing item (see MHTPartition::emptyIndicator)
+            if(isEmpty()) {
+                m3::String empty;
+                is >> empty;
+                return;
+            }
             PANIC("Deserializing item of type notype not implemented");
     }
 }
@@ -170,6 +209,9 @@ size_t MHTItem::defaultSize(ItemType type) {
             return sizeof(MemCapability);
         case SERVICE:
             PANIC("No default size for services");
+        case SRVDIR:
+            // includes service name, hence no static size;
+            PANIC("No default size for service directory entries");
         case MSGOBJ:
             PANIC("Default size of MSGOBJ not defined");
         case MEMOBJ:
@@ -203,6 +245,12 @@ void MHTItem::printState() const {
             case MEMCAP:
                 (static_cast<MemCapability*>(data))->print(m3::Serial::get());
                 break;
+            case SRVDIR:
+                if(data) {
+                    m3::Serial::get() << m3::String(static_cast<ServiceEntry*>(data)->name(),
+                        length - sizeof(ServiceEntry));
+                }
+                break;
             case NOTYPE:
             case MSGOBJ:
             case MEMOBJ:
@@ -67,6 +67,7 @@ using vpe_id_t = uint16_t;
  * 7 bits represent the type
  *  0 - 1 - - - 3 - 4 - - - 6
  * |MCap| OCaps |Srv|  KOs  |
+ * SRVDIR (48) is SERVICE | MSGOBJ, because it is neither a capability nor a kernel object
 */
 enum ItemType : uint8_t {
     NOTYPE = 0,
@@ -80,6 +81,7 @@ enum ItemType : uint8_t {
     SERVICE = 16,
     MSGOBJ = 32,
     MEMOBJ = 64,
+    SRVDIR = 48,
 };
 
 enum MembershipFlags : uint8_t {
@@ -94,6 +96,7 @@ static_assert(HASH_BITS > 0, "DDL ID space too small");
 
 class MHTPartition;
 class MHTInstance;
+class MHTCache;
 class KPE;
 class KernelcallHandler;
 class Capability;
@@ -122,6 +125,30 @@ struct DDLCapRngDesc {
     uint count;
 };
 
+/**
+ * The data of a SRVDIR item, which maps the name of a service to the id of its SERVICE item. The
+ * id determines the kernel that hosts the service. The name follows directly behind the struct.
+ */
+struct ServiceEntry {
+    /**
+     * Allocates the entry on the heap, as required for the data of DDL items.
+     */
+    static ServiceEntry *create(mht_key_t srvId, const char *name, size_t len);
+
+    /**
+     * @return the size of an entry with a name of <len> characters
+     */
+    static size_t size(size_t len) {
+        return sizeof(ServiceEntry) + len;
+    }
+
+    const char *name() const {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+
+    mht_key_t srvId;
+};
+
 /**
  * Provides methods to create and work with hashes.
  * The ID space is structured as follows:
@@ -215,6 +242,7 @@ struct DDLTicket : public m3::SListItem {
 struct MHTItem {
     friend MHTPartition;
     friend MHTInstance;
+    friend MHTCache;
     friend KPE;
     friend KernelcallHandler;
 
@@ -394,5 +422,9 @@ inline bool MHTItem::checkType<Service>() const {
     ItemType type = HashUtil::hashToType(_mht_key);
     return  (type == SERVICE);
 }
+template <>
+inline bool MHTItem::checkType<ServiceEntry>() const {
+    return HashUtil::hashToType(_mht_key) == SRVDIR;
+}
 
 }
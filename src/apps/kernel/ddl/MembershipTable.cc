@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <string.h>
+
+#include "ddl/MembershipTable.h"
+
+namespace kernel {
+
+void MembershipTable::init(size_t pes, membership_entry::krnl_id_t krnl) {
+    assert(pes > 0 && pes <= MAX_PES_DDL);
+    _count = 0;
+    insert(0, {0, krnl, static_cast<membership_entry::capacity_t>(pes), MembershipFlags::NONE});
+    if(pes < MAX_PES_DDL) {
+        insert(1, {static_cast<membership_entry::pe_id_t>(pes), krnl,
+            static_cast<membership_entry::capacity_t>(MAX_PES_DDL - pes), MembershipFlags::UNPOPULATED});
+    }
+}
+
+void MembershipTable::set(membership_entry::pe_id_t start, membership_entry::capacity_t count,
+        membership_entry::krnl_id_t krnl, MembershipFlags flags) {
+    assert(count > 0 && static_cast<size_t>(start) + count <= MAX_PES_DDL);
+    // the ranges behind <first> are shifted by the second split, but <first> stays the same
+    size_t first = split(start);
+    size_t last = split(static_cast<size_t>(start) + count);
+    for(size_t i = first; i < last; ++i) {
+        _ranges[i].krnl_id = krnl;
+        if(flags != MembershipFlags::NOCHANGE)
+            _ranges[i].flags = flags;
+    }
+    merge();
+}
+
+size_t MembershipTable::populated() const {
+    size_t count = 0;
+    for(size_t i = 0; i < _count; ++i) {
+        if(_ranges[i].flags != MembershipFlags::UNPOPULATED)
+            count += _ranges[i].capacity;
+    }
+    return count;
+}
+
+membership_entry::pe_id_t MembershipTable::populated(size_t n) const {
+    for(size_t i = 0; i < _count; ++i) {
+        if(_ranges[i].flags == MembershipFlags::UNPOPULATED)
+            continue;
+        if(n < _ranges[i].capacity)
+            return static_cast<membership_entry::pe_id_t>(_ranges[i].pe_id + n);
+        n -= _ranges[i].capacity;
+    }
+    PANIC("There are not enough populated PEs");
+}
+
+size_t MembershipTable::serializedSize() const {
+    return sizeof(uint64_t) + _count * sizeof(membership_entry);
+}
+
+void MembershipTable::serialize(void *buffer) const {
+    uint64_t count = _count;
+    memcpy(buffer, &count, sizeof(count));
+    memcpy(static_cast<char*>(buffer) + sizeof(count), _ranges, _count * sizeof(membership_entry));
+}
+
+bool MembershipTable::deserialize(const void *buffer, size_t size) {
+    uint64_t count;
+    if(size < sizeof(count))
+        return false;
+    memcpy(&count, buffer, sizeof(count));
+    if(count == 0 || count > MAX_PES_DDL || size < sizeof(count) + count * sizeof(membership_entry))
+        return false;
+
+    membership_entry *ranges = new membership_entry[count];
+    memcpy(ranges, static_cast<const char*>(buffer) + sizeof(count), count * sizeof(membership_entry));
+    // the ranges have to cover the PE ID space without gaps
+    size_t next = 0;
+    for(size_t i = 0; i < count; ++i) {
+        if(ranges[i].pe_id != next || ranges[i].capacity == 0) {
+            delete[] ranges;
+            return false;
+        }
+        next += ranges[i].capacity;
+    }
+    if(next != MAX_PES_DDL) {
+        delete[] ranges;
+        return false;
+    }
+
+    delete[] _ranges;
+    _ranges = ranges;
+    _count = _size = count;
+    return true;
+}
+
+size_t MembershipTable::toRanges(const m3::PEDesc pes[], uint numPEs, membership_entry ranges[]) {
+    bool *used = new bool[MAX_PES_DDL]();
+    for(uint i = 0; i < numPEs; ++i)
+        used[pes[i].core_id()] = true;
+
+    size_t count = 0;
+    for(size_t pe = 0; pe < MAX_PES_DDL; ++pe) {
+        if(!used[pe])
+            continue;
+        if(count > 0 && ranges[count - 1].pe_id + ranges[count - 1].capacity == pe)
+            ranges[count - 1].capacity++;
+        else {
+            ranges[count].pe_id = static_cast<membership_entry::pe_id_t>(pe);
+            ranges[count].krnl_id = 0;
+            ranges[count].capacity = 1;
+            ranges[count].flags = MembershipFlags::NONE;
+            count++;
+        }
+    }
+    delete[] used;
+    return count;
+}
+
+size_t MembershipTable::split(size_t pe) {
+    if(pe >= MAX_PES_DDL)
+        return _count;
+    size_t i = find(static_cast<membership_entry::pe_id_t>(pe));
+    membership_entry &r = _ranges[i];
+    if(r.pe_id == pe)
+        return i;
+
+    membership_entry upper = {static_cast<membership_entry::pe_id_t>(pe), r.krnl_id,
+        static_cast<membership_entry::capacity_t>(r.pe_id + r.capacity - pe), r.flags};
+    r.capacity = static_cast<membership_entry::capacity_t>(pe - r.pe_id);
+    insert(i + 1, upper);
+    return i + 1;
+}
+
+void MembershipTable::insert(size_t idx, const membership_entry &e) {
+    if(_count == _size) {
+        size_t nsize = _size ? _size * 2 : 8;
+        membership_entry *nranges = new membership_entry[nsize];
+        if(_count)
+            memcpy(nranges, _ranges, _count * sizeof(membership_entry));
+        delete[] _ranges;
+        _ranges = nranges;
+        _size = nsize;
+    }
+    memmove(_ranges + idx + 1, _ranges + idx, (_count - idx) * sizeof(membership_entry));
+    _ranges[idx] = e;
+    _count++;
+}
+
+void MembershipTable::merge() {
+    size_t j = 0;
+    for(size_t i = 1; i < _count; ++i) {
+        if(_ranges[i].krnl_id == _ranges[j].krnl_id && _ranges[i].flags == _ranges[j].flags)
+            _ranges[j].capacity += _ranges[i].capacity;
+        else
+            _ranges[++j] = _ranges[i];
+    }
+    _count = j + 1;
+}
+
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include "ddl/MHTTypes.h"
+
+namespace kernel {
+
+/**
+ * The membership table of the DDL, which maps each PE ID to the kernel that is responsible for its
+ * partition. Since kernels own contiguous PE ranges most of the time, the table stores ranges
+ * instead of one entry per PE: each entry covers the PEs pe_id .. pe_id + capacity - 1, the entries
+ * are sorted by pe_id and cover the whole PE ID space without gaps. Adjacent entries with the same
+ * kernel and flags are merged. Thus, a lookup is a binary search over the k ranges.
+ *
+ * The table is transferred to new kernels in this form as well (see serialize/deserialize).
+ */
+class MembershipTable {
+public:
+    explicit MembershipTable() : _ranges(nullptr), _count(0), _size(0) {
+    }
+    MembershipTable(const MembershipTable &) = delete;
+    MembershipTable &operator=(const MembershipTable &) = delete;
+    ~MembershipTable() {
+        delete[] _ranges;
+    }
+
+    /**
+     * Makes <krnl> responsible for the PEs 0 .. <pes> - 1. The remaining PE IDs are marked as
+     * UNPOPULATED.
+     */
+    void init(size_t pes, membership_entry::krnl_id_t krnl);
+
+    membership_entry::krnl_id_t krnl(membership_entry::pe_id_t pe) const {
+        return _ranges[find(pe)].krnl_id;
+    }
+    MembershipFlags flags(membership_entry::pe_id_t pe) const {
+        return _ranges[find(pe)].flags;
+    }
+
+    /**
+     * Makes <krnl> responsible for the PEs <start> .. <start> + <count> - 1.
+     *
+     * @param start     the first PE
+     * @param count     the number of PEs
+     * @param krnl      the kernel
+     * @param flags     the new flags; with NOCHANGE, the PEs keep their flags
+     */
+    void set(membership_entry::pe_id_t start, membership_entry::capacity_t count,
+        membership_entry::krnl_id_t krnl, MembershipFlags flags);
+
+    /**
+     * @return the number of PEs that are not UNPOPULATED
+     */
+    size_t populated() const;
+    /**
+     * @return the <n>-th PE that is not UNPOPULATED; <n> has to be below populated()
+     */
+    membership_entry::pe_id_t populated(size_t n) const;
+
+    /**
+     * @return the number of ranges
+     */
+    size_t ranges() const {
+        return _count;
+    }
+    const membership_entry *begin() const {
+        return _ranges;
+    }
+    const membership_entry *end() const {
+        return _ranges + _count;
+    }
+
+    /**
+     * @return the number of bytes <serialize> writes
+     */
+    size_t serializedSize() const;
+    void serialize(void *buffer) const;
+    /**
+     * Replaces the table with the serialized one in <buffer>.
+     *
+     * @return false if <buffer> does not contain a valid table
+     */
+    bool deserialize(const void *buffer, size_t size);
+
+    /**
+     * Converts the list of PEs into ranges of contiguous PE IDs (pe_id and capacity).
+     *
+     * @param pes       the PEs
+     * @param numPEs    the number of PEs
+     * @param ranges    receives the ranges; needs space for <numPEs> entries
+     * @return the number of ranges
+     */
+    static size_t toRanges(const m3::PEDesc pes[], uint numPEs, membership_entry ranges[]);
+
+private:
+    // returns the index of the range that contains <pe>
+    size_t find(membership_entry::pe_id_t pe) const {
+        assert(pe < MAX_PES_DDL);
+        size_t lo = 0, hi = _count;
+        while(hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if(_ranges[mid].pe_id <= pe)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    // makes sure that a range starts at <pe> and returns its index
+    size_t split(size_t pe);
+    void insert(size_t idx, const membership_entry &e);
+    void merge();
+
+    membership_entry *_ranges;
+    size_t _count;
+    size_t _size;
+};
+
+}
@@ -63,7 +63,14 @@ public:
 
     const MemoryModule &module(size_t id) const;
 
-    Allocation allocate(size_t size);
+    /**
+     * Allocates <size> bytes from the first available memory module that has enough space.
+     *
+     * @param size the size of the area
+     * @param align the alignment of the area (a power of 2)
+     * @return the allocation, which is empty if failed
+     */
+    Allocation allocate(size_t size, size_t align = 1);
     Allocation allocate_at(uintptr_t offset, size_t size);
 
     void free(size_t pe, uintptr_t addr, size_t size);
@@ -24,147 +24,221 @@
 
 namespace kernel {
 
-MemoryMap::MemoryMap(uintptr_t addr, size_t size) : list(new Area()) {
-    list->addr = addr;
-    list->size = size;
-    list->next = nullptr;
+static inline size_t log2_floor(size_t size) {
+    return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(size);
+}
+
+static inline size_t log2_ceil(size_t size) {
+    return size <= 1 ? 0 : log2_floor(size - 1) + 1;
+}
+
+static inline size_t block_size(size_t order) {
+    return static_cast<size_t>(1) << order;
+}
+
+MemoryMap::MemoryMap(uintptr_t addr, size_t size)
+    : _free(), _nonempty(), _lists(), _blocks(new m3::HashTable<uintptr_t, Block>()) {
+    uintptr_t begin = m3::Math::round_up<uintptr_t>(addr, block_size(MIN_ORDER));
+    uintptr_t end = m3::Math::round_dn<uintptr_t>(addr + size, block_size(MIN_ORDER));
+    if(end > begin)
+        release_range(begin, end - begin);
+}
+
+MemoryMap::MemoryMap(MemoryMap &&m)
+    : _free(m._free), _nonempty(m._nonempty), _lists(), _blocks(m._blocks) {
+    for(size_t i = 0; i < ORDERS; ++i) {
+        _lists[i] = m._lists[i];
+        m._lists[i] = nullptr;
+    }
+    m._blocks = nullptr;
+    m._free = 0;
+    m._nonempty = 0;
 }
 
 MemoryMap::~MemoryMap() {
-    for(Area *a = list; a != nullptr;) {
-        Area *n = a->next;
-        delete a;
-        a = n;
+    for(size_t i = 0; i < ORDERS; ++i) {
+        for(Block *b = _lists[i]; b != nullptr;) {
+            Block *n = b->next;
+            delete b;
+            b = n;
+        }
+        _lists[i] = nullptr;
     }
-    list = nullptr;
+    delete _blocks;
 }
 
-uintptr_t MemoryMap::allocate(size_t size) {
-    Area *a;
-    Area *p = nullptr;
-    for(a = list; a != nullptr; p = a, a = a->next) {
-        if(a->size >= size)
-            break;
+void MemoryMap::insert(uintptr_t addr, size_t order) {
+    Block *b = new Block(addr, order);
+    b->next = _lists[order];
+    if(b->next)
+        b->next->prev = b;
+    _lists[order] = b;
+    _nonempty |= static_cast<uint64_t>(1) << order;
+    _blocks->insert(addr, b);
+    _free += block_size(order);
+}
+
+void MemoryMap::remove(Block *b) {
+    if(b->next)
+        b->next->prev = b->prev;
+    if(b->prev)
+        b->prev->next = b->next;
+    else {
+        _lists[b->order] = b->next;
+        if(!b->next)
+            _nonempty &= ~(static_cast<uint64_t>(1) << b->order);
     }
-    if(a == nullptr)
-        return -1;
+    _blocks->remove(b->addr);
+    _free -= block_size(b->order);
+}
 
-    /* take it from the front */
-    uintptr_t res = a->addr;
-    a->size -= size;
-    a->addr += size;
-    /* if the area is empty now, remove it */
-    if(a->size == 0) {
-        if(p)
-            p->next = a->next;
-        else
-            list = a->next;
-        delete a;
+void MemoryMap::release(uintptr_t addr, size_t order) {
+    while(order < ORDERS - 1) {
+        Block *buddy = _blocks->find(addr ^ block_size(order));
+        if(!buddy || buddy->order != order)
+            break;
+        remove(buddy);
+        delete buddy;
+        addr &= ~block_size(order);
+        order++;
     }
-    KLOG(MEM, "Requested " << (size / 1024) << " KiB of memory @ " << m3::fmt(res, "p"));
-    return res;
+    insert(addr, order);
 }
 
-void MemoryMap::free(uintptr_t addr, size_t size) {
-    KLOG(MEM, "Free'd " << (size / 1024) << " KiB of memory @ " << m3::fmt(addr, "p"));
+void MemoryMap::release_range(uintptr_t addr, size_t size) {
+    while(size > 0) {
+        // the largest block that is aligned at <addr> and fits into the range
+        size_t order = log2_floor(size);
+        if(addr)
+            order = m3::Math::min<size_t>(order, __builtin_ctzl(addr));
+        release(addr, order);
+        addr += block_size(order);
+        size -= block_size(order);
+    }
+}
 
-    /* find the area behind ours */
-    Area *n, *p = nullptr;
-    for(n = list; n != nullptr && addr > n->addr; p = n, n = n->next)
-        ;
+uintptr_t MemoryMap::allocate_range(size_t size, size_t align) {
+    // free blocks are never buddies, but they can still be adjacent. thus, start at every free
+    // block and collect its successors until the area is large enough
+    for(size_t i = ORDERS; i-- > MIN_ORDER; ) {
+        for(Block *b = _lists[i]; b != nullptr; b = b->next) {
+            uintptr_t res = m3::Math::round_up<uintptr_t>(b->addr, align);
+            uintptr_t end = b->addr + block_size(b->order);
+            Block *n;
+            while(end < res + size && (n = _blocks->find(end)) != nullptr)
+                end += block_size(n->order);
+            if(end < res + size)
+                continue;
+
+            take(b->addr, end, res, size);
+            return res;
+        }
+    }
+    return -1;
+}
 
-    /* merge with prev and next */
-    if(p && p->addr + p->size == addr && n && addr + size == n->addr) {
-        p->size += size + n->size;
-        p->next = n->next;
-        delete n;
+MemoryMap::Block *MemoryMap::prev_block(uintptr_t addr) const {
+    for(size_t i = MIN_ORDER; i < ORDERS && block_size(i) <= addr; ++i) {
+        Block *b = _blocks->find(addr - block_size(i));
+        if(b && b->order == i)
+            return b;
     }
-    /* merge with prev */
-    else if(p && p->addr + p->size == addr) {
-        p->size += size;
+    return nullptr;
+}
+
+void MemoryMap::take(uintptr_t begin, uintptr_t end, uintptr_t res, size_t size) {
+    // take the blocks out and give the parts before and behind the area back
+    for(uintptr_t addr = begin; addr < end; ) {
+        Block *b = _blocks->find(addr);
+        addr += block_size(b->order);
+        remove(b);
+        delete b;
     }
-    /* merge with next */
-    else if(n && addr + size == n->addr) {
-        n->addr -= size;
-        n->size += size;
+    if(res > begin)
+        release_range(begin, res - begin);
+    if(end > res + size)
+        release_range(res + size, end - (res + size));
+}
+
+uintptr_t MemoryMap::allocate(size_t size, size_t align) {
+    assert(size > 0);
+    size = m3::Math::round_up(size, block_size(MIN_ORDER));
+    align = m3::Math::max(align, block_size(MIN_ORDER));
+    size_t order = m3::Math::max(log2_ceil(size), log2_ceil(align));
+
+    uintptr_t res;
+    uint64_t avail = order < ORDERS ? _nonempty & (~static_cast<uint64_t>(0) << order) : 0;
+    if(avail) {
+        // take the smallest sufficient block and split it until it has the requested order
+        size_t cur = __builtin_ctzll(avail);
+        Block *b = _lists[cur];
+        res = b->addr;
+        remove(b);
+        delete b;
+        while(cur > order) {
+            cur--;
+            insert(res + block_size(cur), cur);
+        }
+        // give the unused part back
+        if(size < block_size(order))
+            release_range(res + size, block_size(order) - size);
     }
-    /* create new area between them */
     else {
-        Area *a = new Area();
-        a->addr = addr;
-        a->size = size;
-        if(p)
-            p->next = a;
-        else
-            list = a;
-        a->next = n;
+        // no block is large enough on its own
+        res = allocate_range(size, align);
+        if(res == static_cast<uintptr_t>(-1))
+            return -1;
     }
+
+    KLOG(MEM, "Requested " << (size / 1024) << " KiB of memory @ " << m3::fmt(res, "p"));
+    return res;
+}
+
+void MemoryMap::free(uintptr_t addr, size_t size) {
+    KLOG(MEM, "Free'd " << (size / 1024) << " KiB of memory @ " << m3::fmt(addr, "p"));
+
+    release_range(addr, m3::Math::round_up(size, block_size(MIN_ORDER)));
 }
 
 uintptr_t MemoryMap::detach(size_t size) {
     /* detached are must be multiple of page size */
     assert(!(size & PAGE_MASK));
-    Area *a;
-    uint count = 0;
-    for(a = list; a != nullptr; a = a->next) {
-        count++;
-    }
-    if(count == 0)
-        return -1;
 
-    /* find the rearmost fitting area */
-    Area *p = a;
-    for(int i = count; i >= 0; i--) {
-        int k;
-        for(a = list, k = 1; k < i; k++, p = a, a = a->next) {
+    // take the chunk from the end of the rearmost sufficient range of adjacent blocks. thus,
+    // repeated detaches leave the rest of the range contiguous
+    uintptr_t res = -1, begin = 0, end = 0;
+    for(size_t i = MIN_ORDER; i < ORDERS; ++i) {
+        for(Block *b = _lists[i]; b != nullptr; b = b->next) {
+            uintptr_t top = b->addr + block_size(b->order);
+            if(top < size || _blocks->find(top))
+                continue;
+            uintptr_t addr = m3::Math::round_dn<uintptr_t>(top - size, PAGE_SIZE);
+            if(res != static_cast<uintptr_t>(-1) && addr <= res)
+                continue;
+
+            uintptr_t bottom = b->addr;
+            Block *p;
+            while(bottom > addr && (p = prev_block(bottom)) != nullptr)
+                bottom = p->addr;
+            if(bottom <= addr) {
+                res = addr;
+                begin = bottom;
+                end = top;
+            }
         }
-        if( (a->size - (m3::Math::round_up<uintptr_t>(a->addr, PAGE_SIZE) - a->addr) ) >= size)
-            break;
-        /* no area with sufficient size */
-        else if(i == 0)
-            return -1;
     }
+    if(res == static_cast<uintptr_t>(-1))
+        return -1;
 
-    /* take it from the end */
-    uintptr_t res;
-    /* the end is not page aligned */
-    if((static_cast<size_t>(a->addr) + a->size) & PAGE_MASK) {
-        res = m3::Math::round_dn<uintptr_t>(a->addr + static_cast<uintptr_t>(a->size), PAGE_SIZE) - size;
-        /* put the remaining tail in a new area */
-        Area *t = new Area();
-        t->addr = res + size;
-        t->size = (a->addr + a->size) - (res + size);
-        t->next = a->next;
-
-        a->next = t;
-        a->size -= (size + t->size);
-    }
-    else {
-        res = a->addr + a->size - size;
-        a->size -= size;
-    }
-    /* if the area is empty now, remove it */
-    if(a->size == 0) {
-        if(p)
-            p->next = a->next;
-        else
-            list = a->next;
-        delete a;
-    }
+    take(begin, end, res, size);
     KLOG(MEM, "Detached " << (size / 1024) << " KiB of memory @ " << m3::fmt(res, "p"));
     return res;
 }
 
 size_t MemoryMap::get_size(size_t *areas) const {
-    size_t total = 0;
     if(areas)
-        *areas = 0;
-    for(Area *a = list; a != nullptr; a = a->next) {
-        total += a->size;
-        if(areas)
-            (*areas)++;
-    }
-    return total;
+        *areas = _blocks->length();
+    return _free;
 }
 
 }
@@ -18,18 +18,38 @@
 #pragma once
 
 #include <base/Common.h>
+#include <base/col/HashTable.h>
 #include <base/stream/OStream.h>
 
 namespace kernel {
 
+/**
+ * Manages the free memory of a memory module with a buddy allocator. The free memory is kept as
+ * naturally aligned blocks of 2^order bytes, with a list of blocks per order and a hash table from
+ * the address to the free block for finding buddies. Allocations take the smallest sufficient
+ * block and split it; the part behind the requested size is given back right away, so that
+ * arbitrary sizes (multiples of 2^MIN_ORDER) don't waste memory. Freed blocks are merged with
+ * their buddies. Both take O(log n) steps, independent of the number of free areas. Only if no
+ * block is large enough, allocations combine adjacent free blocks, which takes linear time.
+ *
+ * Since the memory belongs to other PEs, the blocks are kept on the kernel heap.
+ */
 class MemoryMap {
-    struct Area {
+    struct Block {
+        explicit Block(uintptr_t _addr, size_t _order)
+            : addr(_addr), order(_order), prev(), next() {
+        }
+
         uintptr_t addr;
-        size_t size;
-        Area *next;
+        size_t order;
+        Block *prev;
+        Block *next;
     };
 
 public:
+    static const size_t MIN_ORDER   = 3;
+    static const size_t ORDERS      = sizeof(uintptr_t) * 8;
+
     /**
      * Creates a memory-map of <size> bytes.
      *
@@ -37,6 +57,9 @@ public:
      * @param size the mem size
      */
     explicit MemoryMap(uintptr_t addr, size_t size);
+    MemoryMap(const MemoryMap &) = delete;
+    MemoryMap &operator=(const MemoryMap &) = delete;
+    MemoryMap(MemoryMap &&m);
 
     /**
      * Destroys this map
@@ -46,23 +69,23 @@ public:
     /**
      * Allocates an area in the given map, that is <size> bytes large.
      *
-     * @param map the map
      * @param size the size of the area
+     * @param align the alignment of the area (a power of 2)
      * @return the address of -1 if failed
      */
-    uintptr_t allocate(size_t size);
+    uintptr_t allocate(size_t size, size_t align = 1);
 
     /**
      * Frees the area at <addr> with <size> bytes.
      *
-     * @param map the map
      * @param addr the address of the area
      * @param size the size of the area
      */
     void free(uintptr_t addr, size_t size);
 
     /**
-     * Detaches a chunk of <size> bytes of memory from the end of the map.
+     * Detaches a page-aligned chunk of <size> bytes of memory from the end of the rearmost range of
+     * free memory that is large enough.
      *
      * @param size size of the area
      * @return the address of the detached area, -1 if failed
@@ -72,22 +95,42 @@ public:
     /**
      * Just for debugging/testing: Determines the total number of free bytes in the map
      *
-     * @param map the map
-     * @param areas will be set to the number of areas in the map
+     * @param areas will be set to the number of free blocks in the map
      * @return the free bytes
      */
     size_t get_size(size_t *areas = nullptr) const;
 
     friend m3::OStream &operator<<(m3::OStream &os, const MemoryMap &map) {
         size_t areas;
-        os << "Total: " << (map.get_size(&areas) / 1024) << " KiB:\n";
-        for(Area *a = map.list; a != nullptr; a = a->next)
-            os << "\t@ " << m3::fmt(a->addr, "p") << ", " << (a->size / 1024) << " KiB\n";
+        os << "Total: " << (map.get_size(&areas) / 1024) << " KiB in " << areas << " blocks:\n";
+        for(size_t i = MIN_ORDER; i < ORDERS; ++i) {
+            size_t count = 0;
+            for(Block *b = map._lists[i]; b != nullptr; b = b->next)
+                count++;
+            if(count)
+                os << "\t" << count << " x " << ((static_cast<size_t>(1) << i) / 1024) << " KiB\n";
+        }
         return os;
     }
 
 private:
-    Area *list;
+    void insert(uintptr_t addr, size_t order);
+    void remove(Block *b);
+    // frees the block at <addr> and merges it with its buddies
+    void release(uintptr_t addr, size_t order);
+    // frees the range by splitting it into naturally aligned blocks
+    void release_range(uintptr_t addr, size_t size);
+    // allocates an area that spans multiple adjacent blocks
+    uintptr_t allocate_range(size_t size, size_t align);
+    // the free block that ends at <addr>
+    Block *prev_block(uintptr_t addr) const;
+    // takes [res, res + size) out of the adjacent blocks in [begin, end)
+    void take(uintptr_t begin, uintptr_t end, uintptr_t res, size_t size);
+
+    size_t _free;
+    uint64_t _nonempty;
+    Block *_lists[ORDERS];
+    m3::HashTable<uintptr_t, Block> *_blocks;
 };
 
 }
@@ -15,6 +15,7 @@
  * General Public License version 2 for more details.
  */
 
+#include <base/stream/OStream.h>
 #include <base/Heap.h>
 #include <base/log/Kernel.h>
 
@@ -22,7 +23,7 @@
 
 namespace kernel {
 
-m3::SList<Slab> Slab::_slabs;
+Slab *Slab::_slabs[sizeof(size_t) * 8];
 
 Slab::Pool::Pool(size_t objsize, size_t count)
     : total(count), free(count), mem(m3::Heap::alloc(objsize * count)) {
@@ -35,18 +36,29 @@ Slab::Pool::~Pool() {
 Slab *Slab::get(size_t objsize) {
     assert(objsize >= sizeof(word_t));
 
-    size_t size = 1UL << m3::getnextlog2(objsize + sizeof(word_t));
-    for(auto s = _slabs.begin(); s != _slabs.end(); ++s) {
-        if(s->_objsize == size) {
-            KLOG(SLAB, "Using " << s->_objsize << "B slab for " << objsize << "B objects");
-            return &*s;
-        }
+    size_t order = m3::getnextlog2(objsize + sizeof(word_t));
+    size_t size = 1UL << order;
+    if(_slabs[order]) {
+        KLOG(SLAB, "Using " << size << "B slab for " << objsize << "B objects");
+        return _slabs[order];
     }
 
     KLOG(SLAB, "Creating " << size << "B slab for " << objsize << "B objects");
-    Slab *s = new Slab(size);
-    _slabs.append(s);
-    return s;
+    _slabs[order] = new Slab(size);
+    return _slabs[order];
+}
+
+void Slab::print(m3::OStream &os) {
+    os << "Slabs:\n";
+    for(size_t i = 0; i < ARRAY_SIZE(_slabs); ++i) {
+        Slab *s = _slabs[i];
+        if(!s)
+            continue;
+        os << "  " << s->_objsize << "B: allocated=" << s->_allocated << " free=" << s->_free
+           << " peak=" << s->_peak << " pools=" << s->_pools.length()
+           << " reclaimed=" << s->_reclaimed
+           << " memory=" << (s->_pools.length() * STEP_SIZE * s->_objsize) << "B\n";
+    }
 }
 
 void *Slab::alloc() {
@@ -63,47 +75,53 @@ void *Slab::alloc() {
             mem += _objsize / sizeof(void*);
         }
         _pools.append(p);
+        _free += STEP_SIZE;
     }
 
     void **ptr = _freelist;
     reinterpret_cast<Pool*>(ptr[0])->free--;
     _freelist = reinterpret_cast<void**>(_freelist[1]);
+    _free--;
+    if(++_allocated > _peak)
+        _peak = _allocated;
     return ptr + 1;
 }
 
 void Slab::free(void *addr) {
     void **ptr = reinterpret_cast<void**>(addr) - 1;
 
-    // don't free pools for now. otherwise we shrink and extend back and forth.
-    // TODO maybe we should do that only on memory pressure or so
-#if 0
+    ptr[1] = _freelist;
+    _freelist = ptr;
+    _allocated--;
+    _free++;
+
+    // give the pool back if it's unused and enough free objects are left in other pools
     Pool *p = reinterpret_cast<Pool*>(ptr[0]);
-    if(EXPECT_FALSE(++p->free == p->total)) {
-        KLOG(SLAB, "Shrinking " << _objsize << "B slab by " << (p->total * _objsize) << "B");
-
-        // remove all objects in the pool from the freelist
-        void **obj = _freelist, **prev = nullptr;
-        while(obj != nullptr) {
-            if(obj[0] == p) {
-                if(prev)
-                    prev[1] = obj[1];
-                else
-                    _freelist = reinterpret_cast<void**>(obj[1]);
-            }
+    if(EXPECT_FALSE(++p->free == p->total) && _free - p->total >= RESERVE)
+        reclaim(p);
+}
+
+void Slab::reclaim(Pool *p) {
+    KLOG(SLAB, "Shrinking " << _objsize << "B slab by " << (p->total * _objsize) << "B");
+
+    // remove all objects in the pool from the freelist
+    void **obj = _freelist, **prev = nullptr;
+    while(obj != nullptr) {
+        if(obj[0] == p) {
+            if(prev)
+                prev[1] = obj[1];
             else
-                prev = obj;
-            obj = reinterpret_cast<void**>(obj[1]);
+                _freelist = reinterpret_cast<void**>(obj[1]);
         }
-
-        _pools.remove(p);
-        delete p;
-    }
-    else
-#endif
-    {
-        ptr[1] = _freelist;
-        _freelist = ptr;
+        else
+            prev = obj;
+        obj = reinterpret_cast<void**>(obj[1]);
     }
+
+    _free -= p->total;
+    _reclaimed++;
+    _pools.remove(p);
+    delete p;
 }
 
 }
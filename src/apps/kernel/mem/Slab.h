@@ -18,13 +18,23 @@
 #pragma once
 
 #include <base/Common.h>
-#include <base/col/SList.h>
 #include <base/col/DList.h>
 #include <base/util/Util.h>
 
+namespace m3 {
+class OStream;
+}
+
 namespace kernel {
 
-class Slab : public m3::SListItem {
+/**
+ * A slab allocator for objects of one size class. There is one slab per power of two, which hands
+ * out objects from pools of STEP_SIZE objects each. A pool that is completely free is given back
+ * to the heap, unless the other pools have less than RESERVE free objects left. This keeps
+ * alternating allocations and frees at a pool boundary from shrinking and extending the slab
+ * back and forth.
+ */
+class Slab {
     struct Pool : public m3::DListItem {
         explicit Pool(size_t objsize, size_t count);
         ~Pool();
@@ -36,20 +46,65 @@ class Slab : public m3::SListItem {
 
 public:
     static const size_t STEP_SIZE   = 64;
+    static const size_t RESERVE     = STEP_SIZE;
 
     static Slab *get(size_t objsize);
 
-    explicit Slab(size_t objsize) : _freelist(), _objsize(objsize) {
+    /**
+     * Prints the usage of all slabs to <os>
+     */
+    static void print(m3::OStream &os);
+
+    explicit Slab(size_t objsize)
+        : _freelist(), _objsize(objsize), _allocated(), _free(), _peak(), _reclaimed(), _pools() {
     }
 
     void *alloc();
     void free(void *ptr);
 
+    size_t objsize() const {
+        return _objsize;
+    }
+    /**
+     * @return the number of allocated objects
+     */
+    size_t allocated() const {
+        return _allocated;
+    }
+    /**
+     * @return the number of free objects in all pools
+     */
+    size_t available() const {
+        return _free;
+    }
+    /**
+     * @return the maximum number of objects that have been allocated at the same time
+     */
+    size_t peak() const {
+        return _peak;
+    }
+    /**
+     * @return the number of pools that have been given back to the heap
+     */
+    size_t reclaimed() const {
+        return _reclaimed;
+    }
+    size_t pools() const {
+        return _pools.length();
+    }
+
 private:
+    void reclaim(Pool *p);
+
     void **_freelist;
     size_t _objsize;
+    size_t _allocated;
+    size_t _free;
+    size_t _peak;
+    size_t _reclaimed;
     m3::DList<Pool> _pools;
-    static m3::SList<Slab> _slabs;
+    // the slabs, indexed by the log2 of their object size
+    static Slab *_slabs[sizeof(size_t) * 8];
 };
 
 }
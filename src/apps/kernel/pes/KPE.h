@@ -132,8 +132,12 @@ public:
 //        return _kcrecvgate;
 //    }
 
-    void init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[]);
-    void start(int argc, char** argv, size_t pe_count, m3::PEDesc PEs[]);
+    /**
+     * Loads the kernel onto its PE and hands it <PEs>. The kernel gets the memory for itself and
+     * for <krnls> - 1 kernels that it starts in turn.
+     */
+    void init_memory(int argc, char **argv, size_t pe_count, m3::PEDesc PEs[], size_t krnls);
+    void start(int argc, char** argv, size_t pe_count, m3::PEDesc PEs[], size_t krnls);
 
     void sendTo(const void* data, size_t size);
     void sendRevocationTo(const void* data, size_t size);
@@ -20,12 +20,14 @@
 #include <base/log/Kernel.h>
 #include <base/Panic.h>
 #include <base/col/SList.h>
+#include <thread/ThreadManager.h>
 
 #include <string.h>
 
 #include "pes/PEManager.h"
 #include "Platform.h"
 #include "ddl/MHTInstance.h"
+#include "WorkLoop.h"
 
 namespace kernel {
 
@@ -33,7 +35,7 @@ bool PEManager::_shutdown = false;
 PEManager *PEManager::_inst;
 
 PEManager::PEManager() :
-        _vpes(new VPE*[Platform::MAX_PES]()),
+        _vpes(new VPE*[Platform::MAX_PES]()), _types(new uint8_t[Platform::MAX_PES]), _free(),
         _count(), _daemons(), _pending() {
     // initial kernel acts differently
     if(Platform::kernelId() == Platform::creatorKernelId()) {
@@ -46,9 +48,79 @@ PEManager::PEManager() :
         unsigned int creatorid = Platform::creatorKernelId();
         Coordinator::create(Platform::kernelId(), m3::String("kernel"), creatorid, creatorid + 1);
         // create DDL with the information given by the creator
-        MHTInstance::create(Platform::ddl_member_table(), Platform::ddl_partitions(), Platform::ddl_partitions_size());
+        MHTInstance::create(Platform::ddl_member_table(), Platform::ddl_member_table_size(),
+            Platform::ddl_partitions(), Platform::ddl_partitions_size());
         MHTInstance::getInstance().printMembership();
     }
+    init_free();
+}
+
+void PEManager::init_free() {
+    memset(_types, NO_PE, Platform::MAX_PES);
+    for(size_t i = Platform::first_pe_id(); i < Platform::pe_count(); ++i) {
+        m3::PEDesc pe = Platform::pe_by_index(i);
+        if(pe.core_id() < Platform::MAX_PES)
+            _types[pe.core_id()] = static_cast<uint8_t>(pe.type());
+    }
+    for(size_t i = 0; i < Platform::MAX_PES; ++i) {
+        if(_types[i] != NO_PE)
+            update_free(i);
+    }
+}
+
+void PEManager::update_free(size_t core) {
+    if(_types[core] == NO_PE)
+        return;
+
+    uint64_t &word = _free[_types[core]][core / WORD_BITS];
+    uint64_t bit = static_cast<uint64_t>(1) << (core % WORD_BITS);
+    if(_vpes[core] == nullptr &&
+        MHTInstance::getInstance().responsibleKrnl(core) == Coordinator::get().kid() &&
+        !Coordinator::get().isKPE(core))
+        word |= bit;
+    else
+        word &= ~bit;
+}
+
+size_t PEManager::first_free(uint types) const {
+    for(size_t w = 0; w < FREE_WORDS; ++w) {
+        uint64_t bits = 0;
+        for(size_t t = 0; t < PE_TYPES; ++t) {
+            if(types & (1U << t))
+                bits |= _free[t][w];
+        }
+
+        while(bits) {
+            size_t core = w * WORD_BITS + static_cast<size_t>(__builtin_ctzll(bits));
+            // partitions that are migrated are not tracked in the bitmaps
+            if(!MHTInstance::getInstance().isMigrating(core))
+                return core;
+            bits &= bits - 1;
+        }
+    }
+    return Platform::MAX_PES;
+}
+
+size_t PEManager::last_free(uint types, uint offset) const {
+    for(size_t w = FREE_WORDS; w-- > 0; ) {
+        uint64_t bits = 0;
+        for(size_t t = 0; t < PE_TYPES; ++t) {
+            if(types & (1U << t))
+                bits |= _free[t][w];
+        }
+
+        while(bits) {
+            size_t pos = WORD_BITS - 1 - static_cast<size_t>(__builtin_clzll(bits));
+            size_t core = w * WORD_BITS + pos;
+            if(!MHTInstance::getInstance().isMigrating(core)) {
+                if(offset == 0)
+                    return core;
+                offset--;
+            }
+            bits &= ~(static_cast<uint64_t>(1) << pos);
+        }
+    }
+    return Platform::MAX_PES;
 }
 
 void PEManager::load(int argc, char **argv) {
@@ -81,6 +153,7 @@ void PEManager::load(int argc, char **argv) {
                     ep = m3::DTU::SYSC_EP + DTU::SYSC_GATES - 1;
                 }
                 _vpes[no] = new VPE(m3::String(name.str()), no, no, true, ep);
+                update_free(no);
                 _count++;
             }
 
@@ -133,11 +206,8 @@ void PEManager::load(int argc, char **argv) {
                 // release some PEs for the new kernel; default: just the one the kernel runs on
                 if(pes == -1)
                     pes = 1;
-                // position the kernel at the back of the free cores
-                no = free_compute_core_from_back(pes - 1);
-                if(no == Platform::MAX_PES)
-                    PANIC("No free cores left");
-                Coordinator::get().startKrnl(end - i, &argv[i], m3::String(argv[i]), kids++, no, pes);
+                // the kernels are started all at once below
+                Coordinator::get().addBootKrnl(kids++, pes, end - i, &argv[i]);
             }
             // start it, or register pending item
             else if(strcmp(argv[i], "idle") != 0) {
@@ -166,6 +236,10 @@ void PEManager::load(int argc, char **argv) {
         }
     }
 
+    // start the other kernels before the applications can use their services
+    if(Platform::kernelId() == Platform::creatorKernelId())
+        Coordinator::get().bootKrnls();
+
     // check for pending requirements
     start_pending(ServiceList::get(), RemoteServiceList::get());
 
@@ -284,6 +358,24 @@ bool PEManager::terminate() {
             " revocation= " << KPE::revocationMsgs + KPE::delayedRevocationMsgs
             << "/" << KPE::delayedRevocationMsgs << " replies= " << KPE::replies + KPE::delayedReplies
             << "/" << KPE::delayedReplies);
+        MHTCache &cache = MHTInstance::getInstance().cache();
+        KLOG(INFO, "Kernel # " << Coordinator::get().kid() << " DDL cache (hits/misses): "
+            << cache.hits() << "/" << cache.misses() << " invalidations= " << cache.invalidations()
+            << " evictions= " << cache.evictions() << " size= " << cache.length() << "/" << cache.capacity());
+        KLOG(INFO, "Kernel # " << Coordinator::get().kid() << " DDL migration: items= "
+            << MHTInstance::getInstance().migratedItems() << " cycles= "
+            << MHTInstance::getInstance().migrationCycles());
+        KLOG(INFO, "Kernel # " << Coordinator::get().kid() << " DDL rebalancing: epochs= "
+            << MHTRebalancer::get().epochs() << " migrations= " << MHTRebalancer::get().migrations()
+            << " load= " << MHTRebalancer::get().migratedLoad());
+        KLOG(INFO, "Kernel # " << Coordinator::get().kid() << " workloop: msgs= "
+            << WorkLoop::msgs << " busy= " << WorkLoop::busyCycles << " wakeups= "
+            << WorkLoop::wakeups << " wakeup-to-dispatch= "
+            << (WorkLoop::wakeups ? WorkLoop::wakeupCycles / WorkLoop::wakeups : 0));
+        m3::ThreadManager &tmng = m3::ThreadManager::get();
+        KLOG(INFO, "Kernel # " << Coordinator::get().kid() << " threads: peak-blocked= "
+            << tmng.peak_blocked() << " spawned= " << tmng.spawned() << " total= "
+            << tmng.thread_count());
 #endif
         return true;
     }
@@ -331,6 +423,7 @@ VPE *PEManager::create(m3::String &&name, const m3::PEDesc &pe, int ep, capsel_t
     }
 
     _vpes[i] = new VPE(std::move(name), i, i, false, syscEP, ep, pfgate);
+    update_free(i);
     _count++;
     return _vpes[i];
 }
@@ -339,6 +432,7 @@ void PEManager::remove(int id, bool daemon) {
     assert(_vpes[id]);
     delete _vpes[id];
     _vpes[id] = nullptr;
+    update_free(id);
 
     if(daemon) {
         assert(_daemons > 0);
@@ -74,36 +74,14 @@ public:
      * @return The coreid of a free core, Platform::MAX_PES if no free cores left.
      */
     size_t free_core(const m3::PEDesc &pe) {
-        size_t i;
-        for(i = Platform::first_pe_id(); i <= Platform::pe_count(); ++i) {
-            size_t coreId = Platform::pe_by_index(i).core_id();
-            if(MHTInstance::getInstance().responsibleKrnl(coreId) == Coordinator::get().kid() &&
-                !Coordinator::get().isKPE(coreId) &&
-                _vpes[coreId] == nullptr &&
-                Platform::pe_by_index(i).type() == pe.type())
-            {
-                return coreId;
-            }
-        }
-        return Platform::MAX_PES;
+        return first_free(type_mask(pe.type()));
     }
     /**
      * Get the next free (locally maintained) core that is not a memory PE
      * @return The coreid of a free core, Platform::MAX_PES if no free cores left.
      */
     size_t free_compute_core() {
-        size_t i;
-        for(i = Platform::first_pe_id(); i <= Platform::pe_count(); ++i) {
-            size_t coreId = Platform::pe_by_index(i).core_id();
-            if(MHTInstance::getInstance().responsibleKrnl(coreId) == Coordinator::get().kid() &&
-                !Coordinator::get().isKPE(coreId) &&
-                _vpes[coreId] == nullptr &&
-                Platform::pe_by_index(i).type() != m3::PEType::MEM)
-            {
-                return coreId;
-            }
-        }
-        return Platform::MAX_PES;
+        return first_free(COMPUTE_TYPES);
     }
     /**
      * Get the next free (locally maintained) core that is not a memory PE
@@ -111,26 +89,18 @@ public:
      * @return The coreid of a free core, Platform::MAX_PES if no free cores left.
      */
     size_t free_compute_core_from_back(uint offset = 0) {
-        size_t selectedCore = Platform::MAX_PES;
-        for(size_t i = Platform::pe_count() - 1; i >= Platform::first_pe_id(); --i) {
-            size_t coreId = Platform::pe_by_index(i).core_id();
-
-            if(MHTInstance::getInstance().responsibleKrnl(coreId) ==
-                    Coordinator::get().kid() &&
-                !Coordinator::get().isKPE(coreId) &&
-                _vpes[coreId] == nullptr &&
-                Platform::pe_by_index(i).type() != m3::PEType::MEM)
-            {
-                if(offset == 0) {
-                    selectedCore = coreId;
-                    break;
-                }
-                else {
-                    offset--;
-                }
-            }
+        return last_free(COMPUTE_TYPES, offset);
+    }
+
+    /**
+     * Updates the free cores after the membership of the cores <start>..<start>+<count>-1 has
+     * changed. Does nothing if the PEManager does not exist yet.
+     */
+    static void membership_changed(size_t start, size_t count) {
+        if(_inst) {
+            for(size_t i = start; i < start + count && i < Platform::MAX_PES; ++i)
+                _inst->update_free(i);
         }
-        return selectedCore;
     }
 
     VPE *create(m3::String &&name, const m3::PEDesc &pe, int ep, capsel_t pfgate);
@@ -166,10 +136,36 @@ private:
         }
     }
 
+    static uint type_mask(m3::PEType type) {
+        return 1U << static_cast<uint>(type);
+    }
+    /**
+     * Marks <core> as used by something else than a VPE (e.g., a kernel) or unmarks it again.
+     */
+    void reserve(size_t core, bool reserved) {
+        _vpes[core] = reserved ? reinterpret_cast<VPE*>(1) : nullptr;
+        update_free(core);
+    }
+    void init_free();
+    void update_free(size_t core);
+    size_t first_free(uint types) const;
+    size_t last_free(uint types, uint offset) const;
+
     static m3::String path_to_name(const m3::String &path, const char *suffix);
     static m3::String fork_name(const m3::String &name);
 
+    static const size_t PE_TYPES        = 3;
+    static const uint COMPUTE_TYPES     = (1U << static_cast<uint>(m3::PEType::COMP_IMEM)) |
+                                          (1U << static_cast<uint>(m3::PEType::COMP_EMEM));
+    static const size_t WORD_BITS       = sizeof(uint64_t) * 8;
+    static const size_t FREE_WORDS      = (Platform::MAX_PES + WORD_BITS - 1) / WORD_BITS;
+    static const uint8_t NO_PE          = 0xFF;
+
     VPE **_vpes;
+    // the type of each core or NO_PE if the core is not available for VPEs
+    uint8_t *_types;
+    // per PE type: a bit for every free core that is managed by us
+    uint64_t _free[PE_TYPES][FREE_WORDS];
     size_t _count;
     size_t _daemons;
     m3::SList<Pending> _pending;
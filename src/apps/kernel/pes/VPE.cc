@@ -19,6 +19,7 @@
 #include <base/log/Kernel.h>
 
 #include "com/RecvBufs.h"
+#include "com/SyscallRing.h"
 #include "pes/VPE.h"
 #include "pes/PEManager.h"
 #include "Platform.h"
@@ -41,6 +42,7 @@ VPE::VPE(m3::String &&prog, size_t id, size_t _core, bool bootmod, int syscEP, i
       _eps(),
       _syscgate(SyscallHandler::get().create_gate(this, syscEP)),
       _srvgate(SyscallHandler::get().srvepid(), nullptr),
+      _ring(),
       _as(Platform::pe_by_core(core()).has_virtmem() ? new AddrSpace(ep, pfgate) : nullptr),
       _requires(),
       _exitsubscr(),
@@ -65,6 +67,8 @@ void VPE::unref() {
 void VPE::exit(int exitcode) {
     DTU::get().invalidate_eps(desc(), m3::DTU::FIRST_FREE_EP);
     detach_rbufs();
+    delete _ring;
+    _ring = nullptr;
     _state = DEAD;
     _exitcode = exitcode;
     for(auto it = _exitsubscr.begin(); it != _exitsubscr.end();) {
@@ -29,6 +29,8 @@
 
 namespace kernel {
 
+class SyscallRing;
+
 struct VPEDesc {
     explicit VPEDesc(int _core, int _id) : core(_core), id(_id) {
     }
@@ -81,7 +83,7 @@ public:
         m3::String name;
     };
 
-    static constexpr int SYSC_CREDIT_ORD    = m3::nextlog2<512>::val;
+    static constexpr int SYSC_CREDIT_ORD    = m3::nextlog2<m3::KIF::Syscall::MSG_SIZE>::val;
 
 #if defined(__gem5__)
     // TODO this will move to another place in order to be used by VPE and KPE
@@ -183,6 +185,12 @@ public:
     RecvGate &service_gate() {
         return _srvgate;
     }
+    SyscallRing *syscall_ring() {
+        return _ring;
+    }
+    void syscall_ring(SyscallRing *ring) {
+        _ring = ring;
+    }
     void *eps() {
         return _eps;
     }
@@ -224,6 +232,7 @@ private:
     void *_eps;
     RecvGate _syscgate;
     RecvGate _srvgate;
+    SyscallRing *_ring;
     AddrSpace *_as;
     m3::SList<ServName> _requires;
     m3::Subscriptions<int> _exitsubscr;
@@ -15,10 +15,18 @@
  * General Public License version 2 for more details.
  */
 
-#if defined KTEST_reserve || defined KTEST_hash
+#if defined KTEST_reserve || defined KTEST_hash || defined KTEST_mhtbench || \
+    defined KTEST_mhtcache || defined KTEST_membership
+
+#include <base/util/Profile.h>
+
+#include <cstring>
 
 #include "DDLTest.h"
 #include "ddl/MHTTypes.h"
+#include "ddl/MHTPartition.h"
+#include "ddl/MHTCache.h"
+#include "ddl/MembershipTable.h"
 
 namespace kernel {
 
@@ -39,6 +47,153 @@ void DDLTestSuite::HashUtilTestCase::run() {
 }
 #endif
 
+#ifdef KTEST_mhtbench
+void DDLTestSuite::MHTPartitionBenchCase::bench(uint items) {
+    MHTPartition part(1);
+    cycles_t putTime = 0, getTime = 0, remTime = 0;
+
+    for(uint i = 0; i < items; i++) {
+        MHTItem item(1, 1, MAPCAP, i, nullptr, 0);
+        cycles_t start = m3::Profile::start(0);
+        part.put(m3::Util::move(item));
+        cycles_t end = m3::Profile::stop(0);
+        putTime += end - start;
+    }
+    size_t emptySize = m3::ostreamsize<membership_entry::pe_id_t, size_t>();
+    assert_true(part.serializedSize() > emptySize);
+
+    // look up in a different order than inserted
+    for(uint i = 0; i < items; i++) {
+        mht_key_t key = HashUtil::structured_hash(1, 1, MAPCAP, (i * 7919) % items);
+        cycles_t start = m3::Profile::start(0);
+        const MHTItem &item = part.get(key);
+        cycles_t end = m3::Profile::stop(0);
+        getTime += end - start;
+        assert_true(item.getKey() == key);
+    }
+
+    for(uint i = 0; i < items; i++) {
+        mht_key_t key = HashUtil::structured_hash(1, 1, MAPCAP, i);
+        cycles_t start = m3::Profile::start(0);
+        bool removed = part.remove(key);
+        cycles_t end = m3::Profile::stop(0);
+        remTime += end - start;
+        assert_true(removed);
+    }
+    assert_true(part.get(HashUtil::structured_hash(1, 1, MAPCAP, 0)).isEmpty());
+
+    KLOG(INFO, "MHTPartition with " << items << " items: put " << (putTime / items)
+        << ", get " << (getTime / items) << ", remove " << (remTime / items) << " cycles");
+}
+
+void DDLTestSuite::MHTPartitionBenchCase::run() {
+    bench(1000);
+    bench(10000);
+    bench(100000);
+}
+#endif
+
+#ifdef KTEST_mhtcache
+static void insertEntry(MHTCache &cache, membership_entry::pe_id_t pe, uint id) {
+    ServiceEntry *e = ServiceEntry::create(id, "srv", 3);
+    cache.insert(MHTItem(pe, 1, SRVDIR, id, e, static_cast<uint>(ServiceEntry::size(3))));
+    // the cache has to keep its own copy
+    memset(e, 0, ServiceEntry::size(3));
+    m3::Heap::free(e);
+}
+
+void DDLTestSuite::MHTCacheTestCase::run() {
+    MHTCache cache(4);
+    for(uint i = 0; i < 4; i++)
+        insertEntry(cache, 2, i);
+    // empty items, reservations and capabilities are not cached
+    cache.insert(MHTItem(nullptr, 0, 0));
+    cache.insert(MHTItem(2, 1, SRVDIR, 5, nullptr, 0));
+    cache.insert(MHTItem(2, 1, MAPCAP, 0, nullptr, 1));
+    assert_size(cache.length(), 4);
+
+    // touch 0, so that 1 is the least recently used one
+    const MHTItem *item = cache.find(HashUtil::structured_hash(2, 1, SRVDIR, 0));
+    assert_true(item != nullptr);
+    assert_size(item->getLength(), ServiceEntry::size(3));
+    assert_true(memcmp(item->getData<ServiceEntry>()->name(), "srv", 3) == 0);
+    insertEntry(cache, 2, 4);
+    assert_size(cache.length(), 4);
+    assert_ulong(cache.evictions(), 1);
+    assert_true(cache.find(HashUtil::structured_hash(2, 1, SRVDIR, 1)) == nullptr);
+    assert_true(cache.find(HashUtil::structured_hash(2, 1, SRVDIR, 0)) != nullptr);
+
+    // key ranges and whole partitions
+    cache.invalidate(HashUtil::structured_hash(2, 1, SRVDIR, 2), 2);
+    assert_size(cache.length(), 2);
+    insertEntry(cache, 3, 0);
+    cache.invalidatePartition(2);
+    assert_size(cache.length(), 1);
+    item = cache.find(HashUtil::structured_hash(3, 1, SRVDIR, 0));
+    assert_true(item != nullptr);
+    assert_true(item->getData<ServiceEntry>()->srvId == 0);
+    assert_ulong(cache.invalidations(), 4);
+    assert_ulong(cache.hits(), 3);
+    assert_ulong(cache.misses(), 1);
+}
+#endif
+
+#ifdef KTEST_membership
+void DDLTestSuite::MembershipTableTestCase::run() {
+    MembershipTable tbl;
+    tbl.init(16, 0);
+    assert_size(tbl.ranges(), 2);
+    assert_uint(tbl.krnl(15), 0);
+    assert_int(tbl.flags(16), MembershipFlags::UNPOPULATED);
+
+    // hand out a range in the middle and a single PE
+    tbl.set(4, 8, 1, MembershipFlags::MIGRATING);
+    tbl.set(13, 1, 2, MembershipFlags::NONE);
+    assert_size(tbl.ranges(), 6);
+    assert_uint(tbl.krnl(3), 0);
+    assert_uint(tbl.krnl(4), 1);
+    assert_uint(tbl.krnl(11), 1);
+    assert_uint(tbl.krnl(12), 0);
+    assert_uint(tbl.krnl(13), 2);
+    assert_int(tbl.flags(7), MembershipFlags::MIGRATING);
+    assert_size(tbl.populated(), 16);
+    assert_uint(tbl.populated(5), 5);
+    assert_uint(tbl.populated(13), 13);
+
+    // NOCHANGE keeps the flags; equal neighbors are merged again
+    tbl.set(4, 8, 0, MembershipFlags::NOCHANGE);
+    assert_int(tbl.flags(7), MembershipFlags::MIGRATING);
+    tbl.set(4, 8, 0, MembershipFlags::NONE);
+    tbl.set(13, 1, 0, MembershipFlags::NONE);
+    assert_size(tbl.ranges(), 2);
+
+    // the compact form is transferred to new kernels
+    tbl.set(0, 1, 3, MembershipFlags::NONE);
+    size_t size = tbl.serializedSize();
+    unsigned char *buf = new unsigned char[size];
+    tbl.serialize(buf);
+    MembershipTable copy;
+    assert_true(copy.deserialize(buf, size));
+    assert_size(copy.ranges(), 3);
+    assert_uint(copy.krnl(0), 3);
+    assert_uint(copy.krnl(1), 0);
+    assert_false(copy.deserialize(buf, size - 1));
+    delete[] buf;
+
+    // PE lists are converted into sorted ranges
+    m3::PEDesc pes[5];
+    const size_t cores[] = {9, 3, 4, 5, 8};
+    for(size_t i = 0; i < ARRAY_SIZE(cores); ++i)
+        pes[i] = m3::PEDesc(static_cast<m3::PEDesc::value_t>(cores[i]) << 54);
+    membership_entry ranges[5];
+    assert_size(MembershipTable::toRanges(pes, 5, ranges), 2);
+    assert_uint(ranges[0].pe_id, 3);
+    assert_uint(ranges[0].capacity, 3);
+    assert_uint(ranges[1].pe_id, 8);
+    assert_uint(ranges[1].capacity, 2);
+}
+#endif
+
 }
 
 #endif
\ No newline at end of file
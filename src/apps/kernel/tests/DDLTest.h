@@ -17,7 +17,8 @@
 
 #pragma once
 
-#if defined KTEST_reserve || defined KTEST_hash
+#if defined KTEST_reserve || defined KTEST_hash || defined KTEST_mhtbench || \
+    defined KTEST_mhtcache || defined KTEST_membership
 
 #include "KTestSuite.h"
 #include "KTestCase.h"
@@ -41,6 +42,32 @@ namespace kernel {
             virtual void run() override;
         };
         #endif
+        #ifdef KTEST_mhtbench
+        class MHTPartitionBenchCase : public kernel::KTestCase {
+        public:
+            explicit MHTPartitionBenchCase() : kernel::KTestCase("DDL partition lookup") { }
+            ~MHTPartitionBenchCase() { }
+            virtual void run() override;
+        private:
+            void bench(uint items);
+        };
+        #endif
+        #ifdef KTEST_mhtcache
+        class MHTCacheTestCase : public kernel::KTestCase {
+        public:
+            explicit MHTCacheTestCase() : kernel::KTestCase("DDL cache") { }
+            ~MHTCacheTestCase() { }
+            virtual void run() override;
+        };
+        #endif
+        #ifdef KTEST_membership
+        class MembershipTableTestCase : public kernel::KTestCase {
+        public:
+            explicit MembershipTableTestCase() : kernel::KTestCase("DDL membership table") { }
+            ~MembershipTableTestCase() { }
+            virtual void run() override;
+        };
+        #endif
     public:
         explicit DDLTestSuite() : KTestSuite("DDL") {
             #ifdef KTEST_reserve
@@ -49,6 +76,15 @@ namespace kernel {
             #ifdef KTEST_hash
             add(new HashUtilTestCase());
             #endif
+            #ifdef KTEST_mhtbench
+            add(new MHTPartitionBenchCase());
+            #endif
+            #ifdef KTEST_mhtcache
+            add(new MHTCacheTestCase());
+            #endif
+            #ifdef KTEST_membership
+            add(new MembershipTableTestCase());
+            #endif
         }
     };
 }
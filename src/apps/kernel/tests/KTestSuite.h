@@ -41,6 +41,21 @@ public:
     void add(KTestCase* tc) {
         _cases.append(tc);
     }
+    void run() override {
+        for(auto &t : _cases) {
+            KLOG(INFO, "  Testcase \"" << t.get_name() << "\"...");
+
+            t.run();
+            if(t.get_failed() == 0) {
+                KLOG(INFO, "  \033[0;32mSUCCEEDED!\033[0m");
+                success();
+            }
+            else {
+                KLOG(INFO, "  \033[0;31mFAILED!\033[0m");
+                failed();
+            }
+        }
+    }
 
 private:
     m3::SList<KTestCase> _cases;
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#ifdef KTEST_kvstore
+
+#include <base/util/Profile.h>
+
+#include "KVStoreTest.h"
+#include "KVStore.h"
+
+namespace kernel {
+
+void KVStoreTestSuite::KVStoreBasicTestCase::run() {
+    KVStore<size_t, size_t> store;
+    // mix keys of the dense and the sparse part
+    size_t keys[] = {3, 0, 100000, 17, 1023, 1024, 5000000};
+    for(size_t i = 0; i < ARRAY_SIZE(keys); ++i)
+        store.put(keys[i], i);
+    assert_uint(store.size(), ARRAY_SIZE(keys));
+    for(size_t i = 0; i < ARRAY_SIZE(keys); ++i) {
+        assert_true(store.exists(keys[i]));
+        assert_size(store.get(keys[i]), i);
+    }
+    assert_false(store.exists(4));
+    assert_false(store.exists(100001));
+
+    // overwriting does not add an entry
+    store.put(17, 42);
+    assert_size(store.get(17), 42);
+    assert_uint(store.size(), ARRAY_SIZE(keys));
+
+    // iteration is in insertion order, also after removals
+    assert_true(store.remove(100000));
+    assert_true(store.remove(3));
+    assert_false(store.remove(3));
+    size_t expected[] = {0, 17, 1023, 1024, 5000000};
+    size_t i = 0;
+    for(auto it = store.begin(); it != store.end(); ++it, ++i)
+        assert_size(it->id, expected[i]);
+    assert_size(i, ARRAY_SIZE(expected));
+}
+
+void KVStoreTestSuite::KVStoreBenchCase::bench(size_t kernels, size_t keyStride) {
+    static const size_t ROUNDS = 16;
+    KVStore<size_t, size_t> store;
+    for(size_t i = 0; i < kernels; ++i)
+        store.put(i * keyStride, i);
+
+    cycles_t total = 0;
+    size_t sum = 0;
+    for(size_t r = 0; r < ROUNDS; ++r) {
+        cycles_t start = m3::Profile::start(0);
+        for(size_t i = 0; i < kernels; ++i)
+            sum += store.get(i * keyStride);
+        cycles_t end = m3::Profile::stop(0);
+        total += end - start;
+    }
+    assert_size(sum, ROUNDS * (kernels * (kernels - 1) / 2));
+
+    KLOG(INFO, "KVStore with " << kernels << (keyStride == 1 ? " dense" : " sparse")
+        << " keys: " << (total / (ROUNDS * kernels)) << " cycles per lookup");
+}
+
+void KVStoreTestSuite::KVStoreBenchCase::run() {
+    size_t counts[] = {16, 64, 256, 1024};
+    for(size_t i = 0; i < ARRAY_SIZE(counts); ++i) {
+        // kernel ids
+        bench(counts[i], 1);
+        // keys beyond the dense array
+        bench(counts[i], 4099);
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#ifdef KTEST_kvstore
+
+#include "KTestSuite.h"
+#include "KTestCase.h"
+
+namespace kernel {
+    class KVStoreTestSuite : public kernel::KTestSuite {
+    private:
+        class KVStoreBasicTestCase : public kernel::KTestCase {
+        public:
+            explicit KVStoreBasicTestCase() : kernel::KTestCase("KVStore basics") { }
+            ~KVStoreBasicTestCase() { }
+            virtual void run() override;
+        };
+        class KVStoreBenchCase : public kernel::KTestCase {
+        public:
+            explicit KVStoreBenchCase() : kernel::KTestCase("KVStore lookup") { }
+            ~KVStoreBenchCase() { }
+            virtual void run() override;
+        private:
+            void bench(size_t kernels, size_t keyStride);
+        };
+    public:
+        explicit KVStoreTestSuite() : KTestSuite("KVStore") {
+            add(new KVStoreBasicTestCase());
+            add(new KVStoreBenchCase());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#ifdef KTEST_mem
+
+#include <base/util/Profile.h>
+#include <base/Config.h>
+
+#include "MemTest.h"
+#include "Coordinator.h"
+#include "mem/MemoryMap.h"
+#include "mem/Slab.h"
+
+namespace kernel {
+
+void MemTestSuite::SlabTestCase::run() {
+    // use a slab of our own to not interfere with the kernel objects
+    Slab *slab = new Slab(64);
+    const size_t count = Slab::STEP_SIZE * 3;
+    void **objs = new void*[count];
+    for(size_t i = 0; i < count; ++i)
+        objs[i] = slab->alloc();
+    assert_size(slab->allocated(), count);
+    assert_size(slab->available(), 0);
+    assert_size(slab->pools(), 3);
+    assert_size(slab->peak(), count);
+
+    // the first pool is kept as reserve, the others are given back
+    for(size_t i = 0; i < count; ++i)
+        slab->free(objs[i]);
+    assert_size(slab->allocated(), 0);
+    assert_size(slab->available(), Slab::STEP_SIZE);
+    assert_size(slab->pools(), 1);
+    assert_size(slab->reclaimed(), 2);
+
+    // the reserve is used first
+    for(size_t i = 0; i < Slab::STEP_SIZE; ++i)
+        objs[i] = slab->alloc();
+    assert_size(slab->pools(), 1);
+    assert_size(slab->available(), 0);
+    for(size_t i = 0; i < Slab::STEP_SIZE; ++i)
+        slab->free(objs[i]);
+    assert_size(slab->pools(), 1);
+    assert_size(slab->peak(), count);
+    delete[] objs;
+    delete slab;
+}
+
+void MemTestSuite::MemoryMapTestCase::run() {
+    const uintptr_t base = 0x400000;
+    const size_t size = 0x400000;
+    MemoryMap map(base, size);
+    size_t blocks;
+    assert_size(map.get_size(&blocks), size);
+    assert_size(blocks, 1);
+
+    // arbitrary sizes are split off the smallest sufficient block
+    uintptr_t a = map.allocate(24);
+    uintptr_t b = map.allocate(PAGE_SIZE, PAGE_SIZE);
+    uintptr_t c = map.allocate(0x200000, 0x200000);
+    assert_true(a != static_cast<uintptr_t>(-1));
+    assert_true(b != static_cast<uintptr_t>(-1) && (b & PAGE_MASK) == 0);
+    assert_true(c != static_cast<uintptr_t>(-1) && (c & (0x200000 - 1)) == 0);
+    assert_size(map.get_size(), size - 24 - PAGE_SIZE - 0x200000);
+
+    // there is no second 2 MiB block left
+    assert_true(map.allocate(0x200000) == static_cast<uintptr_t>(-1));
+
+    // freeing everything merges all buddies again
+    map.free(b, PAGE_SIZE);
+    map.free(a, 24);
+    map.free(c, 0x200000);
+    assert_size(map.get_size(&blocks), size);
+    assert_size(blocks, 1);
+
+    uintptr_t d = map.detach(size);
+    assert_true(d == base);
+    assert_size(map.get_size(), 0);
+}
+
+void MemTestSuite::MemoryMapRangeTestCase::run() {
+    // the usable memory of the default gem5 config: [6160 MiB, 8192 MiB), which consists of
+    // aligned blocks of at most 1 GiB
+    const size_t MiB = 1024 * 1024;
+    const uintptr_t base = 6160 * MiB;
+    const size_t size = 2032 * MiB;
+    MemoryMap map(base, size);
+    size_t blocks, initBlocks;
+    assert_size(map.get_size(&initBlocks), size);
+
+    // larger than the largest block, but there is enough contiguous memory
+    uintptr_t a = map.allocate(1536 * MiB, PAGE_SIZE);
+    assert_true(a != static_cast<uintptr_t>(-1) && (a & PAGE_MASK) == 0);
+    assert_true(a >= base && a + 1536 * MiB <= base + size);
+    assert_size(map.get_size(), size - 1536 * MiB);
+
+    // the rest is still available, although it might be split as well
+    uintptr_t b = map.detach(size - 1536 * MiB);
+    assert_true(b != static_cast<uintptr_t>(-1));
+    assert_size(map.get_size(), 0);
+    assert_true(map.allocate(PAGE_SIZE) == static_cast<uintptr_t>(-1));
+
+    map.free(a, 1536 * MiB);
+    map.free(b, size - 1536 * MiB);
+    assert_size(map.get_size(&blocks), size);
+    assert_size(blocks, initBlocks);
+
+    // the alignment only determines the placement within the adjacent blocks
+    uintptr_t c = map.allocate(160 * MiB, 32 * MiB);
+    assert_true(c != static_cast<uintptr_t>(-1) && (c & (32 * MiB - 1)) == 0);
+    map.free(c, 160 * MiB);
+
+    // everything at once, starting at the unaligned base
+    uintptr_t d = map.detach(size);
+    assert_true(d == base);
+    assert_size(map.get_size(), 0);
+}
+
+// boots <total> kernels with the given fan-out in a model of their memory. every kernel has the
+// rest of its own memory and the memory for the kernels below it, which are used for detaching in
+// reverse order like in MainMemory (see KPE::init_memory). returns the number of started kernels.
+static size_t boot_kernel_tree(size_t total, size_t fanout) {
+    const size_t MiB = 1024 * 1024;
+    // the kernel's segments, stack and heap at the beginning of its memory
+    const size_t KRNL_USED = 5 * MiB + 3 * PAGE_SIZE;
+
+    MemoryMap **own = new MemoryMap*[total];
+    MemoryMap **below = new MemoryMap*[total];
+    size_t *krnls = new size_t[total];
+    // the usable memory of the initial kernel in the default gem5 config
+    own[0] = new MemoryMap(6160 * MiB, 2032 * MiB);
+    below[0] = nullptr;
+    for(size_t k = 0; k < total; ++k)
+        krnls[k] = 1;
+    // the parent of a kernel as in Coordinator::bootParent
+    for(size_t k = total - 1; k > 0; --k)
+        krnls[(k - 1) / fanout] += krnls[k];
+
+    // every kernel starts its children in the order of their ids
+    size_t started = 1;
+    for(; started < total; ++started) {
+        size_t parent = (started - 1) / fanout;
+        MemoryMap *mods[] = {below[parent], own[parent]};
+        uintptr_t addrs[2] = {static_cast<uintptr_t>(-1), static_cast<uintptr_t>(-1)};
+        size_t sizes[] = {KRNL_INIT_MEM_SIZE, KRNL_INIT_MEM_SIZE * (krnls[started] - 1)};
+        for(size_t i = 0; i < 2 && sizes[i]; ++i) {
+            for(size_t m = 0; m < ARRAY_SIZE(mods) && addrs[i] == static_cast<uintptr_t>(-1); ++m) {
+                if(mods[m])
+                    addrs[i] = mods[m]->detach(sizes[i]);
+            }
+        }
+        if(addrs[0] == static_cast<uintptr_t>(-1) ||
+           (sizes[1] && addrs[1] == static_cast<uintptr_t>(-1)))
+            break;
+
+        own[started] = new MemoryMap(addrs[0] + KRNL_USED, KRNL_INIT_MEM_SIZE - KRNL_USED);
+        below[started] = sizes[1] ? new MemoryMap(addrs[1], sizes[1]) : nullptr;
+        // some allocations before the kernel starts its children
+        own[started]->allocate(64 * 1024);
+        own[started]->allocate(PAGE_SIZE, PAGE_SIZE);
+    }
+
+    for(size_t k = 0; k < started; ++k) {
+        delete own[k];
+        delete below[k];
+    }
+    delete[] krnls;
+    delete[] below;
+    delete[] own;
+    return started;
+}
+
+void MemTestSuite::KernelTreeTestCase::run() {
+    // the memory suffices for 64 kernels, independent of the shape of the tree
+    static const size_t fanouts[] = {1, 2, 3, 4, 8, KERNEL_BOOT_FANOUT};
+    for(size_t f = 0; f < ARRAY_SIZE(fanouts); ++f) {
+        for(size_t total = 2; total <= 64; ++total)
+            assert_size(boot_kernel_tree(total, fanouts[f]), total);
+        assert_true(boot_kernel_tree(65, fanouts[f]) < 65);
+    }
+}
+
+void MemTestSuite::MemoryMapBenchCase::run() {
+    // sizes as requested via REQMEM: small objects, pages, buffers and VPE memory
+    static const size_t sizes[] = {8, 64, 0x1000, 0x4000, 0x10000, 0x100000};
+    const size_t SLOTS = 128;
+    const size_t ROUNDS = 4096;
+    const size_t size = 0x4000000;
+    MemoryMap map(0, size);
+
+    uintptr_t *addrs = new uintptr_t[SLOTS];
+    size_t *lens = new size_t[SLOTS];
+    for(size_t i = 0; i < SLOTS; ++i)
+        lens[i] = 0;
+
+    uint seed = 1;
+    size_t allocs = 0, frees = 0, failed = 0;
+    cycles_t allocCycles = 0, freeCycles = 0;
+    for(size_t i = 0; i < ROUNDS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        size_t slot = (seed >> 16) % SLOTS;
+        if(lens[slot]) {
+            cycles_t start = m3::Profile::start(0);
+            map.free(addrs[slot], lens[slot]);
+            freeCycles += m3::Profile::stop(0) - start;
+            frees++;
+            lens[slot] = 0;
+        }
+
+        seed = seed * 1103515245 + 12345;
+        size_t len = sizes[(seed >> 16) % ARRAY_SIZE(sizes)] * (1 + (seed >> 8) % 3);
+        cycles_t start = m3::Profile::start(0);
+        uintptr_t addr = map.allocate(len);
+        allocCycles += m3::Profile::stop(0) - start;
+        allocs++;
+        if(addr == static_cast<uintptr_t>(-1))
+            failed++;
+        else {
+            addrs[slot] = addr;
+            lens[slot] = len;
+        }
+    }
+
+    size_t blocks;
+    size_t free = map.get_size(&blocks);
+    KLOG(INFO, "MemoryMap churn: alloc= " << (allocCycles / allocs) << " free= "
+        << (frees ? freeCycles / frees : 0) << " cycles, failed= " << failed
+        << ", free= " << (free / 1024) << " KiB in " << blocks << " blocks");
+
+    for(size_t i = 0; i < SLOTS; ++i) {
+        if(lens[i])
+            map.free(addrs[i], lens[i]);
+    }
+    assert_size(map.get_size(&blocks), size);
+    assert_size(blocks, 1);
+    delete[] lens;
+    delete[] addrs;
+}
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#ifdef KTEST_mem
+
+#include "KTestSuite.h"
+#include "KTestCase.h"
+
+namespace kernel {
+    class MemTestSuite : public kernel::KTestSuite {
+    private:
+        class SlabTestCase : public kernel::KTestCase {
+        public:
+            explicit SlabTestCase() : kernel::KTestCase("Slab reclamation") { }
+            ~SlabTestCase() { }
+            virtual void run() override;
+        };
+        class MemoryMapTestCase : public kernel::KTestCase {
+        public:
+            explicit MemoryMapTestCase() : kernel::KTestCase("MemoryMap buddies") { }
+            ~MemoryMapTestCase() { }
+            virtual void run() override;
+        };
+        class MemoryMapRangeTestCase : public kernel::KTestCase {
+        public:
+            explicit MemoryMapRangeTestCase() : kernel::KTestCase("MemoryMap adjacent blocks") { }
+            ~MemoryMapRangeTestCase() { }
+            virtual void run() override;
+        };
+        class KernelTreeTestCase : public kernel::KTestCase {
+        public:
+            explicit KernelTreeTestCase() : kernel::KTestCase("Memory of a kernel tree") { }
+            ~KernelTreeTestCase() { }
+            virtual void run() override;
+        };
+        class MemoryMapBenchCase : public kernel::KTestCase {
+        public:
+            explicit MemoryMapBenchCase() : kernel::KTestCase("MemoryMap REQMEM churn") { }
+            ~MemoryMapBenchCase() { }
+            virtual void run() override;
+        };
+    public:
+        explicit MemTestSuite() : KTestSuite("Memory") {
+            add(new SlabTestCase());
+            add(new MemoryMapTestCase());
+            add(new MemoryMapRangeTestCase());
+            add(new KernelTreeTestCase());
+            add(new MemoryMapBenchCase());
+        }
+    };
+}
+
+#endif
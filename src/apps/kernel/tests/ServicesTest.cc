@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#ifdef KTEST_services
+
+#include <base/stream/OStringStream.h>
+#include <base/util/Profile.h>
+
+#include "ServicesTest.h"
+#include "com/Services.h"
+
+namespace kernel {
+
+using RemoteService = RemoteServiceList::RemoteService;
+
+static m3::String service_name(size_t i) {
+    m3::OStringStream name;
+    name << "m3fs" << i;
+    return m3::String(name.str());
+}
+
+void ServicesTestSuite::ServiceIndexTestCase::run() {
+    m3::SList<RemoteService> list;
+    ServiceIndex<RemoteService> index;
+    RemoteService *a = new RemoteService(1, m3::String("m3fs"));
+    RemoteService *b = new RemoteService(2, m3::String("pager"));
+    list.append(a);
+    index.add(a);
+    list.append(b);
+    index.add(b);
+    assert_true(index.find(list, a->name(), a->hash()) == a);
+    assert_true(index.find(list, b->name(), b->hash()) == b);
+    assert_true(index.find(list, m3::String("pipe"), Service::name_hash(m3::String("pipe"))) == nullptr);
+
+    // the hash only selects the candidate; the name has to match as well
+    assert_true(index.find(list, m3::String("pipe"), a->hash()) == nullptr);
+
+    // the second service with the same hash is not indexed, but still found
+    RemoteService *c = new RemoteService(3, m3::String("m3fs"));
+    list.append(c);
+    index.add(c);
+    index.remove(a);
+    list.remove(a);
+    assert_true(index.find(list, c->name(), c->hash()) == c);
+    index.remove(c);
+    list.remove(c);
+    assert_true(index.find(list, c->name(), c->hash()) == nullptr);
+
+    index.remove(b);
+    list.remove(b);
+    delete a;
+    delete b;
+    delete c;
+}
+
+void ServicesTestSuite::ServiceIndexBenchCase::bench(size_t services) {
+    m3::SList<RemoteService> list;
+    ServiceIndex<RemoteService> index;
+    m3::String *names = new m3::String[services];
+    for(size_t i = 0; i < services; ++i) {
+        names[i].reset(service_name(i).c_str());
+        RemoteService *s = new RemoteService(i + 1, names[i]);
+        list.append(s);
+        index.add(s);
+    }
+
+    // look up in a different order than inserted; the hash is computed per lookup, as in find()
+    cycles_t idxTime = 0, linTime = 0;
+    for(size_t i = 0; i < services; i++) {
+        const m3::String &name = names[(i * 7919) % services];
+        cycles_t start = m3::Profile::start(0);
+        RemoteService *s = index.find(list, name, Service::name_hash(name));
+        cycles_t end = m3::Profile::stop(0);
+        idxTime += end - start;
+        assert_true(s != nullptr && s->name() == name);
+    }
+
+    // the previous implementation compared the names one by one
+    for(size_t i = 0; i < services; i++) {
+        const m3::String &name = names[(i * 7919) % services];
+        cycles_t start = m3::Profile::start(0);
+        RemoteService *s = nullptr;
+        for(auto &r : list) {
+            if(r.name() == name) {
+                s = &r;
+                break;
+            }
+        }
+        cycles_t end = m3::Profile::stop(0);
+        linTime += end - start;
+        assert_true(s != nullptr);
+    }
+
+    KLOG(INFO, "Service lookup with " << services << " services: hashed " << (idxTime / services)
+        << ", linear " << (linTime / services) << " cycles");
+
+    for(auto it = list.begin(); it != list.end(); ) {
+        auto old = it++;
+        index.remove(&*old);
+        delete &*old;
+    }
+    delete[] names;
+}
+
+void ServicesTestSuite::ServiceIndexBenchCase::run() {
+    bench(32);
+    bench(1000);
+}
+
+}
+
+#endif
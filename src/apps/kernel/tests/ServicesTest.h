@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#ifdef KTEST_services
+
+#include "KTestSuite.h"
+#include "KTestCase.h"
+
+namespace kernel {
+    class ServicesTestSuite : public kernel::KTestSuite {
+    private:
+        class ServiceIndexTestCase : public kernel::KTestCase {
+        public:
+            explicit ServiceIndexTestCase() : kernel::KTestCase("Service index") { }
+            ~ServiceIndexTestCase() { }
+            virtual void run() override;
+        };
+        class ServiceIndexBenchCase : public kernel::KTestCase {
+        public:
+            explicit ServiceIndexBenchCase() : kernel::KTestCase("Service lookup") { }
+            ~ServiceIndexBenchCase() { }
+            virtual void run() override;
+        private:
+            void bench(size_t services);
+        };
+    public:
+        explicit ServicesTestSuite() : KTestSuite("Services") {
+            add(new ServiceIndexTestCase());
+            add(new ServiceIndexBenchCase());
+        }
+    };
+}
+
+#endif
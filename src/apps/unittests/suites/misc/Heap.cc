@@ -17,6 +17,7 @@
 
 #include <base/Common.h>
 #include <base/Config.h>
+#include <base/util/Profile.h>
 
 #include <m3/stream/Standard.h>
 
@@ -25,6 +26,8 @@
 #include "Heap.h"
 
 #define SINGLE_BYTE_COUNT 30
+#define BENCH_SLOTS       64
+#define BENCH_ROUNDS      4096
 
 using namespace m3;
 
@@ -274,3 +277,82 @@ void HeapTestSuite::TestCase9::run() {
 
     check_heap_after();
 }
+
+// a simple linear congruential generator to get the same sequence on every run
+static uint bench_rand(uint *seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+void HeapTestSuite::TestCase10::run() {
+    check_heap_before();
+
+    // keep a number of areas of mixed sizes alive and replace a random one in every round
+    void *ptrs[BENCH_SLOTS] = {nullptr};
+    uint seed = 1;
+    cycles_t allocs = 0, frees = 0;
+    size_t freed = 0;
+    for(int i = 0; i < BENCH_ROUNDS; ++i) {
+        size_t idx = bench_rand(&seed) % BENCH_SLOTS;
+        if(ptrs[idx]) {
+            cycles_t start = Profile::start(0);
+            Heap::free(ptrs[idx]);
+            frees += Profile::stop(0) - start;
+            freed++;
+        }
+
+        size_t size = 8 + bench_rand(&seed) % 512;
+        cycles_t start = Profile::start(1);
+        ptrs[idx] = Heap::alloc(size);
+        allocs += Profile::stop(1) - start;
+        *reinterpret_cast<uint*>(ptrs[idx]) = i;
+    }
+    cout << "Per alloc: " << (allocs / BENCH_ROUNDS) << " cycles, per free: "
+         << (freed ? frees / freed : 0) << " cycles\n";
+
+    // grow areas in steps, as e.g. a String or a vector does
+    cycles_t reallocs = 0;
+    for(size_t i = 0; i < BENCH_SLOTS; ++i) {
+        cycles_t start = Profile::start(2);
+        ptrs[i] = Heap::realloc(ptrs[i], 1024 + i * 16);
+        reallocs += Profile::stop(2) - start;
+    }
+    cout << "Per realloc: " << (reallocs / BENCH_SLOTS) << " cycles\n";
+
+    for(size_t i = 0; i < BENCH_SLOTS; ++i)
+        Heap::free(ptrs[i]);
+
+    check_heap_after();
+}
+
+void HeapTestSuite::TestCase11::run() {
+    check_heap_before();
+
+    // fill the holes between long-living areas with short-living areas of other sizes
+    void *ptrs[BENCH_SLOTS * 2];
+    uint seed = 2;
+    for(size_t i = 0; i < ARRAY_SIZE(ptrs); ++i)
+        ptrs[i] = Heap::alloc(16 + bench_rand(&seed) % 256);
+    for(size_t i = 0; i < ARRAY_SIZE(ptrs); i += 2) {
+        Heap::free(ptrs[i]);
+        ptrs[i] = Heap::alloc(16 + bench_rand(&seed) % 128);
+    }
+    for(size_t i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+        Heap::free(ptrs[i]);
+
+    // the free memory is now split into holes; the larger the largest hole, the better
+    size_t free = Heap::free_memory();
+    size_t contig = Heap::contiguous_mem();
+    cycles_t start = Profile::start(3);
+    void *large = Heap::alloc(contig / 2);
+    cycles_t end = Profile::stop(3);
+    cout << "Free: " << free << " bytes, largest area: " << contig << " bytes, allocating "
+         << (contig / 2) << " bytes: " << (end - start) << " cycles\n";
+    assert_true(contig <= free);
+    Heap::free(large);
+
+    for(size_t i = 1; i < ARRAY_SIZE(ptrs); i += 2)
+        Heap::free(ptrs[i]);
+
+    check_heap_after();
+}
@@ -93,6 +93,18 @@ private:
         }
         virtual void run() override;
     };
+    class TestCase10 : public BaseTestCase {
+    public:
+        explicit TestCase10() : BaseTestCase("Allocation throughput") {
+        }
+        virtual void run() override;
+    };
+    class TestCase11 : public BaseTestCase {
+    public:
+        explicit TestCase11() : BaseTestCase("Fragmentation") {
+        }
+        virtual void run() override;
+    };
 
 public:
     explicit HeapTestSuite()
@@ -106,5 +118,7 @@ public:
         add(new TestCase7());
         add(new TestCase8());
         add(new TestCase9());
+        add(new TestCase10());
+        add(new TestCase11());
     }
 };
@@ -28,8 +28,11 @@ namespace m3 {
 class OStream;
 
 /**
- * The heap implementation of M3. Optimized for a small code size and small memory overhead for
- * management, rather than performance.
+ * The heap implementation of M3. By default, the free areas are kept in segregated lists, indexed
+ * by a two-level bitmap of size classes (TLSF), so that alloc and free take constant time
+ * independent of the number of areas. With HEAP_COMPACT (M3_HEAP=compact), the heap is optimized
+ * for a small code size and small memory overhead for management, rather than performance, and
+ * searches the areas first-fit instead.
  *
  * Note that all methods do NOT return nullptr in case there is not enough memory. The reasoning behind
  * that is, that since the heap has a fixed amount of memory and there is no multithreading, there
@@ -59,6 +62,27 @@ class Heap {
     static const word_t USED_BIT    = 0x5UL << (sizeof(word_t) * 8 - 3);
     static const size_t ALIGN       = sizeof(Area);
 
+#if !defined(HEAP_COMPACT)
+    // the links of a free area, which are stored behind its Area
+    struct FreeLinks {
+        Area *next;
+        Area *prev;
+    };
+
+    static const size_t ALIGN_BITS  = sizeof(word_t) == 8 ? 4 : 3;
+    // every power of two is split into SL_COUNT size classes
+    static const size_t SL_BITS     = 3;
+    static const size_t SL_COUNT    = 1 << SL_BITS;
+    // areas below that size have a class per ALIGN bytes
+    static const size_t SMALL_SIZE  = 1 << (SL_BITS + ALIGN_BITS);
+    // larger areas are put into the last class
+    static const size_t MAX_BITS    = sizeof(word_t) == 8 ? 36 : 30;
+    static const size_t FL_COUNT    = MAX_BITS - (SL_BITS + ALIGN_BITS) + 1;
+    static const size_t MIN_AREA    = sizeof(Area) + sizeof(FreeLinks);
+#else
+    static const size_t MIN_AREA    = ALIGN;
+#endif
+
 public:
     /**
      * Tries to allocate <size> bytes.
@@ -86,8 +110,9 @@ public:
     static void *calloc(size_t n, size_t size);
 
     /**
-     * Tries to increase the area, pointed at by <p>, to <size> bytes. If this is not possible, it
-     * will relocate the area to a place where <size> bytes are available.
+     * Tries to increase the area, pointed at by <p>, to <size> bytes, by growing it into the free
+     * area behind it. If this is not possible, it will relocate the area to a place where <size>
+     * bytes are available.
      *
      * @param p the current area (might be nullptr)
      * @param size the new size of the area
@@ -154,6 +179,34 @@ public:
 
 private:
     static void init();
+    /**
+     * Appends the memory between the current end area and <end> to the heap. The memory has to be
+     * accessible already.
+     */
+    static void extend(uintptr_t end);
+
+    static size_t area_size(size_t size) {
+        // align it to at least word-size (the fortran-runtime seems to expect that). 8 is even
+        // better because the DTU requires that.
+        size = (size + sizeof(Area) + ALIGN - 1) & ~(ALIGN - 1);
+        return size < MIN_AREA ? MIN_AREA : size;
+    }
+    static Area *find_free(size_t size);
+    static void split(Area *a, size_t size);
+#if !defined(HEAP_COMPACT)
+    static FreeLinks *links(Area *a) {
+        return reinterpret_cast<FreeLinks*>(a + 1);
+    }
+    static void size_class(size_t size, size_t *fl, size_t *sl);
+    static void insert_free(Area *a);
+    static void remove_free(Area *a);
+#else
+    static void insert_free(Area *) {
+    }
+    static void remove_free(Area *) {
+    }
+#endif
+
     static bool is_used(Area *a) {
         return a->next & USED_BIT;
     }
@@ -167,6 +220,12 @@ private:
     static bool _ready;
     static Area *_begin;
     static Area *_end;
+#if !defined(HEAP_COMPACT)
+    static word_t _fl_bitmap;
+    static uint32_t _sl_bitmap[FL_COUNT];
+    static Area *_free[FL_COUNT][SL_COUNT];
+    static size_t _free_bytes;
+#endif
 };
 
 }
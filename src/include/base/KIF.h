@@ -72,9 +72,62 @@ struct KIF {
             REVOKE,
             EXIT,
             NOOP,
+            REVOKEASYNC,
+            BATCH,
+            SETUPRING,
+            DOORBELL,
             COUNT
         };
 
+        // the max. size of a syscall message, including the DTU header
+        static const size_t MSG_SIZE    = 512;
+        // the max. number of operations in a BATCH syscall. the results have to fit into the reply
+        static const size_t MAX_BATCH   = 8;
+
+        /**
+         * The layout of the memory that a VPE shares with the kernel for a syscall ring (see
+         * SETUPRING). It starts with the header, followed by the submission queue and the
+         * completion queue, which have the same number of slots. The counters in the header only
+         * increase; an entry is stored at its counter modulo the number of slots. The VPE writes
+         * the syscalls to the submission queue and rings the doorbell (DOORBELL), whereupon the
+         * kernel executes them and puts the results into the completion queue.
+         */
+        struct Ring {
+            static const size_t MAX_SLOTS   = 256;
+            static const size_t SQE_SIZE    = 128;
+
+            struct Header {
+                // written by the VPE
+                uint64_t sq_tail;
+                uint64_t cq_head;
+                // written by the kernel
+                uint64_t sq_head;
+                uint64_t cq_tail;
+            };
+
+            struct SQE {
+                uint64_t tag;
+                // the length of the marshalled syscall in <data>
+                uint64_t length;
+                uint8_t data[SQE_SIZE - 2 * sizeof(uint64_t)];
+            };
+
+            struct CQE {
+                uint64_t tag;
+                uint64_t error;
+            };
+
+            static size_t size(size_t slots) {
+                return sizeof(Header) + slots * (sizeof(SQE) + sizeof(CQE));
+            }
+            static size_t sqe_offset(size_t slots, uint64_t idx) {
+                return sizeof(Header) + (idx & (slots - 1)) * sizeof(SQE);
+            }
+            static size_t cqe_offset(size_t slots, uint64_t idx) {
+                return sizeof(Header) + slots * sizeof(SQE) + (idx & (slots - 1)) * sizeof(CQE);
+            }
+        };
+
         enum VPECtrl {
             VCTRL_START,
             VCTRL_WAIT,
@@ -59,3 +59,7 @@
 #define SYNC_APP_START      1
 #define CASCADING_APP_START 0
 #define KERNEL_STATISTICS   1
+// DDL load balancing (see kernel/ddl/MHTRebalancer.h); can be set with M3_DDL_REBALANCE as well
+#ifndef DDL_REBALANCE_EPOCH
+#   define DDL_REBALANCE_EPOCH      0
+#endif
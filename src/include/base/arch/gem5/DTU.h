@@ -221,6 +221,26 @@ public:
         return reinterpret_cast<Message*>(read_reg(CmdRegs::OFFSET));
     }
 
+    /**
+     * Determines the receive EPs with unread messages by reading their registers. In contrast to
+     * fetch_msg, no command is issued to the DTU.
+     *
+     * @return a bitmask with bit i set if EP i has unread messages
+     */
+    uint64_t pending_msgs() const {
+        // the DTU counts the unread messages of all EPs
+        if(read_reg(DtuRegs::MSGCNT) == 0)
+            return 0;
+        uint64_t mask = 0;
+        for(int ep = 0; ep < EP_COUNT; ++ep) {
+            // the lower 16 bits of receive EPs hold the number of unread messages
+            reg_t r0 = read_reg(ep, 0);
+            if(static_cast<EpType>(r0 >> 61) == EpType::RECEIVE && (r0 & 0xFFFF) != 0)
+                mask |= static_cast<uint64_t>(1) << ep;
+        }
+        return mask;
+    }
+
     size_t get_msgoff(int, const Message *msg) const {
         return reinterpret_cast<uintptr_t>(msg);
     }
@@ -234,6 +234,18 @@ public:
         return get_ep(ep, EP_BUF_MSGCNT) - _unack[ep] > 0;
     }
 
+    /**
+     * @return a bitmask with bit i set if EP i has unread messages
+     */
+    uint64_t pending_msgs() const {
+        uint64_t mask = 0;
+        for(int ep = 0; ep < EP_COUNT; ++ep) {
+            if(fetch_msg(ep))
+                mask |= static_cast<uint64_t>(1) << ep;
+        }
+        return mask;
+    }
+
     DTU::Message *message(int ep) const {
         size_t off = get_ep(ep, EP_BUF_ROFF);
         word_t addr = get_ep(ep, EP_BUF_ADDR);
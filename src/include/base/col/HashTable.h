@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/util/Util.h>
+#include <assert.h>
+
+namespace m3 {
+
+/**
+ * The default hash function for integral keys. The keys we use (e.g., DDL keys) carry most of
+ * their entropy in a few bit fields, so they are scrambled with the 64-bit finalizer of
+ * MurmurHash3 before they are used as an index.
+ */
+template<typename K>
+struct Hash {
+    static size_t hash(K key) {
+        uint64_t x = static_cast<uint64_t>(key);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+};
+
+/**
+ * An open-addressing hash table with linear probing that maps keys to pointers. The table does not
+ * own the objects it points to. Since nullptr marks empty slots, it can't be stored as a value.
+ *
+ * The table grows incrementally: if the load factor exceeds 3/4, a table of twice the size is
+ * allocated and every following insert or remove migrates MIGRATE_STEP slots of the old table.
+ * Lookups consult both tables while a migration is in progress. This way, no single operation pays
+ * for rehashing all entries.
+ *
+ * Note that the table must not be changed while iterating over it.
+ */
+template<typename K, class T, class H = Hash<K>>
+class HashTable {
+    static const size_t MIN_SIZE        = 16;
+    static const size_t MIGRATE_STEP    = 8;
+
+    struct Slot {
+        K key;
+        T *val;
+    };
+
+    struct Table {
+        explicit Table() : slots(nullptr), size(0), count(0) {
+        }
+
+        Slot *slots;
+        size_t size;
+        size_t count;
+    };
+
+    // marks slots of the old table that have been migrated already. we can't just clear them,
+    // because that would break the probe sequence for the entries behind them.
+    static T *moved() {
+        return reinterpret_cast<T*>(static_cast<uintptr_t>(1));
+    }
+    static bool occupied(const Slot &s) {
+        return s.val != nullptr && s.val != moved();
+    }
+
+public:
+    /**
+     * Iterates over all entries, i.e., first over the remaining ones in the old table (if there
+     * is a migration going on) and afterwards over the current table.
+     */
+    template<class TBL, typename V>
+    class Iterator {
+        friend class HashTable;
+
+        explicit Iterator(TBL *tbl, int table, size_t idx) : _tbl(tbl), _table(table), _idx(idx) {
+            skip();
+        }
+
+    public:
+        explicit Iterator() : _tbl(nullptr), _table(2), _idx(0) {
+        }
+
+        K key() const {
+            return slot().key;
+        }
+        V &operator*() const {
+            return *slot().val;
+        }
+        V *operator->() const {
+            return slot().val;
+        }
+        Iterator &operator++() {
+            _idx++;
+            skip();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator tmp(*this);
+            operator++();
+            return tmp;
+        }
+        bool operator==(const Iterator &rhs) const {
+            return _table == rhs._table && (_table == 2 || _idx == rhs._idx);
+        }
+        bool operator!=(const Iterator &rhs) const {
+            return !operator==(rhs);
+        }
+
+    private:
+        const Slot &slot() const {
+            return (_table == 0 ? _tbl->_old : _tbl->_cur).slots[_idx];
+        }
+        void skip() {
+            for(; _table < 2; _table++, _idx = 0) {
+                const Table &t = _table == 0 ? _tbl->_old : _tbl->_cur;
+                for(; _idx < t.size; ++_idx) {
+                    if(occupied(t.slots[_idx]))
+                        return;
+                }
+            }
+        }
+
+        TBL *_tbl;
+        int _table;
+        size_t _idx;
+    };
+
+    using iterator          = Iterator<HashTable, T>;
+    using const_iterator    = Iterator<const HashTable, const T>;
+
+    /**
+     * Creates an empty table. Memory is allocated with the first insert.
+     *
+     * @param initial the initial number of slots (rounded up to a power of 2)
+     */
+    explicit HashTable(size_t initial = MIN_SIZE)
+        : _initial(initial < MIN_SIZE ? MIN_SIZE : 1UL << getnextlog2(initial)), _cur(), _old(),
+          _migrated(0) {
+    }
+    HashTable(const HashTable &) = delete;
+    HashTable &operator=(const HashTable &) = delete;
+    ~HashTable() {
+        delete[] _cur.slots;
+        delete[] _old.slots;
+    }
+
+    /**
+     * @return the number of entries
+     */
+    size_t length() const {
+        return _cur.count + _old.count;
+    }
+    /**
+     * @return the number of slots (of both tables, if a migration is in progress)
+     */
+    size_t capacity() const {
+        return _cur.size + _old.size;
+    }
+    /**
+     * @return true if a migration to a larger table is in progress
+     */
+    bool migrating() const {
+        return _old.slots != nullptr;
+    }
+
+    iterator begin() {
+        return iterator(this, 0, 0);
+    }
+    iterator end() {
+        return iterator();
+    }
+    const_iterator begin() const {
+        return const_iterator(this, 0, 0);
+    }
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    /**
+     * @param key the key
+     * @return the value for <key> or nullptr if there is none
+     */
+    T *find(K key) const {
+        Slot *s = lookup(_cur, key);
+        if(!s && _old.count)
+            s = lookup(_old, key);
+        return s ? s->val : nullptr;
+    }
+
+    /**
+     * Inserts <val> for <key>. If there is already a value for <key>, it is replaced.
+     *
+     * @param key the key
+     * @param val the value (not nullptr)
+     * @return the replaced value or nullptr
+     */
+    T *insert(K key, T *val) {
+        assert(val != nullptr && val != moved());
+        migrate_step();
+
+        Slot *s = lookup(_cur, key);
+        if(s) {
+            T *old = s->val;
+            s->val = val;
+            return old;
+        }
+
+        T *old = nullptr;
+        if(_old.count && (s = lookup(_old, key))) {
+            old = s->val;
+            s->val = moved();
+            _old.count--;
+        }
+
+        if((_cur.count + 1) * 4 > _cur.size * 3)
+            grow();
+        put(_cur, key, val);
+        return old;
+    }
+
+    /**
+     * Removes the value for <key>.
+     *
+     * @param key the key
+     * @return the removed value or nullptr if there was none
+     */
+    T *remove(K key) {
+        migrate_step();
+
+        Slot *s = lookup(_cur, key);
+        if(s) {
+            T *val = s->val;
+            erase(_cur, static_cast<size_t>(s - _cur.slots));
+            return val;
+        }
+        if(_old.count && (s = lookup(_old, key))) {
+            T *val = s->val;
+            s->val = moved();
+            _old.count--;
+            return val;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Removes all entries (does not free the values) and releases the memory of the table.
+     */
+    void clear() {
+        delete[] _cur.slots;
+        delete[] _old.slots;
+        _cur = Table();
+        _old = Table();
+        _migrated = 0;
+    }
+
+private:
+    size_t index(const Table &t, K key) const {
+        return H::hash(key) & (t.size - 1);
+    }
+
+    Slot *lookup(const Table &t, K key) const {
+        if(!t.count)
+            return nullptr;
+        for(size_t i = index(t, key); ; i = (i + 1) & (t.size - 1)) {
+            Slot *s = t.slots + i;
+            if(s->val == nullptr)
+                return nullptr;
+            if(s->val != moved() && s->key == key)
+                return s;
+        }
+    }
+
+    void put(Table &t, K key, T *val) {
+        size_t i = index(t, key);
+        while(t.slots[i].val != nullptr)
+            i = (i + 1) & (t.size - 1);
+        t.slots[i].key = key;
+        t.slots[i].val = val;
+        t.count++;
+    }
+
+    // removes slot <i> and shifts the following entries of the cluster back, so that no entry
+    // becomes unreachable. This is only done for the current table, which contains no moved-markers.
+    void erase(Table &t, size_t i) {
+        size_t mask = t.size - 1;
+        t.slots[i].val = nullptr;
+        t.count--;
+        for(size_t j = (i + 1) & mask; t.slots[j].val != nullptr; j = (j + 1) & mask) {
+            size_t home = index(t, t.slots[j].key);
+            // can the entry at j be moved to the hole at i? only if its home is not in (i, j]
+            if(((j - home) & mask) >= ((j - i) & mask)) {
+                t.slots[i] = t.slots[j];
+                t.slots[j].val = nullptr;
+                i = j;
+            }
+        }
+    }
+
+    void grow() {
+        // finish a migration that is still in progress first
+        while(migrating())
+            migrate_step();
+
+        if(_cur.slots) {
+            _old = _cur;
+            _migrated = 0;
+        }
+        _cur = Table();
+        _cur.size = _old.size ? _old.size * 2 : _initial;
+        _cur.slots = new Slot[_cur.size];
+        for(size_t i = 0; i < _cur.size; ++i)
+            _cur.slots[i].val = nullptr;
+    }
+
+    void migrate_step() {
+        if(!migrating())
+            return;
+        for(size_t n = 0; n < MIGRATE_STEP && _migrated < _old.size; ++n, ++_migrated) {
+            Slot &s = _old.slots[_migrated];
+            if(occupied(s)) {
+                put(_cur, s.key, s.val);
+                s.val = moved();
+                _old.count--;
+            }
+        }
+        if(_migrated == _old.size || _old.count == 0) {
+            delete[] _old.slots;
+            _old = Table();
+            _migrated = 0;
+        }
+    }
+
+    size_t _initial;
+    Table _cur;
+    Table _old;
+    size_t _migrated;
+};
+
+}
@@ -171,7 +171,7 @@ public:
      * @param err the error code
      */
     explicit BaseGateIStream(RGATE &gate, const DTU::Message *msg, Errors::Code err)
-        : _err(err), _ack(true), _pos(0), _gate(&gate), _msg(msg) {
+        : _err(err), _ack(true), _pos(0), _gate(&gate), _msg(msg), _capture() {
     }
 
     /**
@@ -181,12 +181,13 @@ public:
      * @param msg the message
      */
     explicit BaseGateIStream(RGATE &gate, const DTU::Message *msg)
-        : _err(Errors::NO_ERROR), _ack(true), _pos(0), _gate(&gate), _msg(msg) {
+        : _err(Errors::NO_ERROR), _ack(true), _pos(0), _gate(&gate), _msg(msg), _capture() {
     }
 
     // don't do the ack twice. thus, copies never ack.
     BaseGateIStream(const BaseGateIStream &is)
-        : _err(is._err), _ack(), _pos(is._pos), _gate(is._gate), _msg(is._msg) {
+        : _err(is._err), _ack(), _pos(is._pos), _gate(is._gate), _msg(is._msg),
+          _capture(is._capture) {
     }
     BaseGateIStream &operator=(const BaseGateIStream &is) {
         if(this != &is) {
@@ -195,6 +196,7 @@ public:
             _pos = is._pos;
             _gate = is._gate;
             _msg = is._msg;
+            _capture = is._capture;
         }
         return *this;
     }
@@ -205,12 +207,14 @@ public:
             _pos = is._pos;
             _gate = is._gate;
             _msg = is._msg;
+            _capture = is._capture;
             is._ack = 0;
         }
         return *this;
     }
     BaseGateIStream(BaseGateIStream &&is)
-        : _err(is._err), _ack(is._ack), _pos(is._pos), _gate(is._gate), _msg(is._msg) {
+        : _err(is._err), _ack(is._ack), _pos(is._pos), _gate(is._gate), _msg(is._msg),
+          _capture(is._capture) {
         is._ack = 0;
     }
     ~BaseGateIStream() {
@@ -270,6 +274,22 @@ public:
         return _msg->data;
     }
 
+    /**
+     * Lets the reply to this message store its error code in <res> instead of sending it. This is
+     * used to execute several messages with a single reply.
+     *
+     * @param res the location for the error code
+     */
+    void capture_reply(Errors::Code *res) {
+        _capture = res;
+    }
+    /**
+     * @return true if the reply will be captured, i.e., if it has not been done yet
+     */
+    bool capturing() const {
+        return _capture != nullptr;
+    }
+
     /**
      * Replies the message constructed by <os> to this message
      *
@@ -287,6 +307,14 @@ public:
      * @return the error code or Errors::NO_ERROR
      */
     Errors::Code reply(const void *data, size_t len) {
+        if(_capture) {
+            // all replies start with the error code
+            *_capture = *static_cast<const Errors::Code*>(data);
+            _capture = nullptr;
+            _ack = false;
+            return Errors::NO_ERROR;
+        }
+
         Errors::Code res = _gate->reply_sync(data, len, DTU::get().get_msgoff(_gate->epid(), _msg));
         // it's already acked
         _ack = false;
@@ -318,6 +346,16 @@ public:
         _pos += Math::round_up(sizeof(T), sizeof(ulong));
         return *this;
     }
+    /**
+     * Skips <len> bytes, e.g., a nested message that has been accessed via buffer() and pos().
+     *
+     * @param len the number of bytes
+     */
+    void skip(size_t len) {
+        assert(_pos + len <= length());
+        _pos += Math::round_up(len, sizeof(ulong));
+    }
+
     BaseGateIStream & operator>>(String &value) {
         assert(_pos + sizeof(size_t) <= length());
         size_t len = *reinterpret_cast<const size_t*>(_msg->data + _pos);
@@ -357,6 +395,7 @@ private:
     size_t _pos;
     RGATE *_gate;
     const DTU::Message *_msg;
+    Errors::Code *_capture;
 };
 
 template<class RGATE, class SGATE>
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>, 
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/util/CapRngDesc.h>
+#include <base/Errors.h>
+
+#include <m3/com/RecvBuf.h>
+#include <m3/com/RecvGate.h>
+
+namespace m3 {
+
+/**
+ * Issues asynchronous revokes and waits for their completion. A synchronous revoke blocks until
+ * the kernels of all children have confirmed their part, so that revoking many capabilities one
+ * by one costs a round trip to the other kernels each. The Revoker only waits for the local part
+ * of each revoke and lets the kernel notify it about the remaining ones via its own receive
+ * buffer. That is, the remote revocations of all revokes proceed in parallel.
+ *
+ * Usage:
+ *   Revoker rev;
+ *   for(...)
+ *       rev.revoke(CapRngDesc(CapRngDesc::OBJ, sel));
+ *   rev.wait();
+ */
+class Revoker {
+public:
+    static const size_t MSG_SIZE    = 64;
+    // the number of revokes that can be outstanding at the same time
+    static const size_t SLOTS       = 32;
+
+    explicit Revoker();
+    Revoker(const Revoker&) = delete;
+    Revoker &operator=(const Revoker&) = delete;
+    ~Revoker();
+
+    /**
+     * @return the number of revokes that have not finished yet
+     */
+    size_t pending() const {
+        return _pending;
+    }
+
+    /**
+     * Revokes <crd>. Returns as soon as the capabilities have been removed locally. If SLOTS
+     * revokes are outstanding already, it waits until one of them has finished.
+     *
+     * @param crd the capabilities
+     * @param own whether to revoke the capabilities themselves or only their children
+     * @return the error code
+     */
+    Errors::Code revoke(const CapRngDesc &crd, bool own = true);
+
+    /**
+     * Waits until all revokes have finished.
+     */
+    void wait();
+
+private:
+    void wait_one();
+
+    RecvBuf _rbuf;
+    RecvGate _rgate;
+    word_t _next;
+    size_t _pending;
+};
+
+}
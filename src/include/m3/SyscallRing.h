@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/com/Marshalling.h>
+#include <base/util/CapRngDesc.h>
+#include <base/Errors.h>
+#include <base/KIF.h>
+
+#include <m3/com/MemGate.h>
+
+namespace m3 {
+
+/**
+ * A syscall ring, which is an alternative to issuing every syscall with a message of its own.
+ * The submission and completion queues live in memory that is shared with the kernel (see
+ * KIF::Syscall::Ring). The syscalls are collected locally and enter() writes them to the ring and
+ * rings the doorbell. The kernel executes them in order and enter() fetches the results afterwards.
+ * Thus, a whole ring of syscalls costs a single message to the kernel. Like with Syscalls::Batch,
+ * only the syscalls that reply with nothing but an error code are supported. Additionally,
+ * EXCHANGE, ACTIVATE and REVOKE are not supported, because they might block the kernel.
+ *
+ * A VPE can have at most one ring, which it has to set up explicitly.
+ *
+ * Usage:
+ *   SyscallRing ring;
+ *   ring.submit(0, KIF::Syscall::NOOP);
+ *   ring.enter();
+ *   word_t tag;
+ *   Errors::Code res;
+ *   while(ring.fetch(&tag, &res))
+ *       ...
+ */
+class SyscallRing {
+    using Ring = KIF::Syscall::Ring;
+
+public:
+    static const size_t DEF_SLOTS   = 64;
+
+    /**
+     * Creates the ring in global memory and registers it at the kernel. Check
+     * Errors::last afterwards.
+     *
+     * @param slots the number of entries (a power of 2 up to Ring::MAX_SLOTS)
+     */
+    explicit SyscallRing(size_t slots = DEF_SLOTS);
+    SyscallRing(const SyscallRing&) = delete;
+    SyscallRing &operator=(const SyscallRing&) = delete;
+    ~SyscallRing();
+
+    size_t slots() const {
+        return _slots;
+    }
+    /**
+     * @return the number of syscalls that have been submitted, but not entered yet
+     */
+    size_t submitted() const {
+        return _staged;
+    }
+
+    /**
+     * Submits the syscall <op> with given arguments and <tag>, which identifies the completion.
+     * If the ring is full, it is entered first.
+     *
+     * @return the error code of enter()
+     */
+    template<typename... Args>
+    Errors::Code submit(word_t tag, KIF::Syscall::Operation op, const Args &... args) {
+        static_assert(ostreamsize<KIF::Syscall::Operation, Args...>() <= sizeof(Ring::SQE::data),
+            "Syscall too large");
+        Errors::Code res = Errors::NO_ERROR;
+        if(_sq_tail + _staged - _sq_head == _slots)
+            res = enter();
+        if(_sq_tail + _staged - _sq_head == _slots)
+            return res;
+
+        Ring::SQE &sqe = _sqes[(_sq_tail + _staged) & (_slots - 1)];
+        Marshaller m(sqe.data, sizeof(sqe.data));
+        m.vput(op, args...);
+        sqe.tag = tag;
+        sqe.length = m.total();
+        _staged++;
+        return res;
+    }
+
+    SyscallRing &noop(word_t tag) {
+        submit(tag, KIF::Syscall::NOOP);
+        return *this;
+    }
+    SyscallRing &reqmem(word_t tag, capsel_t cap, size_t size, int perms) {
+        submit(tag, KIF::Syscall::REQMEM, cap, static_cast<uintptr_t>(-1), size, perms);
+        return *this;
+    }
+    SyscallRing &derivemem(word_t tag, capsel_t src, capsel_t dst, size_t offset, size_t size,
+            int perms) {
+        submit(tag, KIF::Syscall::DERIVEMEM, src, dst, offset, size, perms);
+        return *this;
+    }
+
+    /**
+     * Writes the submitted syscalls to the ring, rings the doorbell and fetches the results.
+     * The results of previous calls that have not been fetched are dropped.
+     *
+     * @return the error code, if the ring could not be processed
+     */
+    Errors::Code enter();
+
+    /**
+     * Fetches the next result of the last enter().
+     *
+     * @param tag will be set to the tag of the syscall
+     * @param res will be set to its result
+     * @return true if there was a result
+     */
+    bool fetch(word_t *tag, Errors::Code *res) {
+        if(_cqpos == _cqcount)
+            return false;
+        *tag = _cqes[_cqpos].tag;
+        *res = static_cast<Errors::Code>(_cqes[_cqpos].error);
+        _cqpos++;
+        return true;
+    }
+
+private:
+    Errors::Code transfer(uint64_t first, size_t count, bool sq);
+
+    size_t _slots;
+    MemGate _mem;
+    uint64_t _sq_head;
+    uint64_t _sq_tail;
+    uint64_t _cq_head;
+    size_t _staged;
+    size_t _cqpos;
+    size_t _cqcount;
+    Ring::SQE *_sqes;
+    Ring::CQE *_cqes;
+};
+
+}
@@ -38,6 +38,121 @@ class Syscalls {
     static constexpr size_t MSGSIZE     = 256;
 
 public:
+    /**
+     * Collects several syscalls to execute them with a single message to the kernel (BATCH), which
+     * performs them in order. Only the syscalls that reply with nothing but an error code can be
+     * batched. Note that the results are only known after run().
+     *
+     * Usage:
+     *   Syscalls::Batch batch;
+     *   batch.reqmem(mem, size, perms).creategate(vpe, gate, label, ep, credits);
+     *   if(batch.run() != Errors::NO_ERROR)
+     *       ...
+     */
+    class Batch {
+        static constexpr size_t HEADER_SIZE =
+            ostreamsize<KIF::Syscall::Operation, size_t, bool>();
+        static constexpr size_t MSG_SIZE    = KIF::Syscall::MSG_SIZE - DTU::HEADER_SIZE;
+
+    public:
+        /**
+         * Creates an empty batch.
+         *
+         * @param stop_on_error whether the remaining operations should be skipped after a failure
+         */
+        explicit Batch(bool stop_on_error = true);
+        Batch(const Batch&) = delete;
+        Batch &operator=(const Batch&) = delete;
+        ~Batch();
+
+        Batch &creategate(capsel_t vpe, capsel_t dst, label_t label, size_t ep, word_t credits) {
+            return add(KIF::Syscall::CREATEGATE, vpe, dst, label, ep, credits);
+        }
+        Batch &activate(size_t ep, capsel_t oldcap, capsel_t newcap) {
+            return add(KIF::Syscall::ACTIVATE, ep, oldcap, newcap);
+        }
+        Batch &attachrb(capsel_t vpe, size_t ep, uintptr_t addr, int order, int msgorder, uint flags) {
+            return add(KIF::Syscall::ATTACHRB, vpe, ep, addr, order, msgorder, flags);
+        }
+        Batch &detachrb(capsel_t vpe, size_t ep) {
+            return add(KIF::Syscall::DETACHRB, vpe, ep);
+        }
+        Batch &exchange(capsel_t vpe, const CapRngDesc &own, const CapRngDesc &other, bool obtain) {
+            return add(KIF::Syscall::EXCHANGE, vpe, own, other, obtain);
+        }
+        Batch &reqmem(capsel_t cap, size_t size, int perms) {
+            return reqmemat(cap, -1, size, perms);
+        }
+        Batch &reqmemat(capsel_t cap, uintptr_t addr, size_t size, int perms) {
+            return add(KIF::Syscall::REQMEM, cap, addr, size, perms);
+        }
+        Batch &derivemem(capsel_t src, capsel_t dst, size_t offset, size_t size, int perms) {
+            return add(KIF::Syscall::DERIVEMEM, src, dst, offset, size, perms);
+        }
+        Batch &revoke(const CapRngDesc &crd, bool own = true) {
+            return add(KIF::Syscall::REVOKE, crd, own);
+        }
+
+        /**
+         * @return the number of operations that have been added
+         */
+        size_t count() const {
+            return _count;
+        }
+        /**
+         * @return the number of operations that have been executed so far
+         */
+        size_t executed() const {
+            return _executed;
+        }
+        /**
+         * @param i the index of the operation (< executed())
+         * @return the result of the operation
+         */
+        Errors::Code result(size_t i) const {
+            assert(i < _executed);
+            return _results[i];
+        }
+
+        /**
+         * Executes the operations that have not been executed yet. If the message is full, this
+         * happens while adding operations already.
+         *
+         * @return the first error that occurred in this batch (or Errors::NO_ERROR)
+         */
+        Errors::Code run();
+
+    private:
+        template<typename... Args>
+        Batch &add(KIF::Syscall::Operation op, const Args &... args) {
+            static_assert(ostreamsize<size_t, KIF::Syscall::Operation, Args...>() <=
+                MSG_SIZE - HEADER_SIZE, "Operation too large");
+            if(_ops == KIF::Syscall::MAX_BATCH ||
+               _pos + ostreamsize<size_t, KIF::Syscall::Operation, Args...>() > MSG_SIZE)
+                run();
+            _count++;
+            // after a failure, all following operations are skipped
+            if(_stop && _error != Errors::NO_ERROR)
+                return *this;
+
+            Marshaller m(_msg + _pos + sizeof(size_t), MSG_SIZE - _pos - sizeof(size_t));
+            m.vput(op, args...);
+            *reinterpret_cast<size_t*>(_msg + _pos) = m.total();
+            _pos += sizeof(size_t) + m.total();
+            _ops++;
+            return *this;
+        }
+
+        bool _stop;
+        Errors::Code _error;
+        size_t _count;
+        size_t _executed;
+        size_t _ops;
+        size_t _pos;
+        Errors::Code *_results;
+        alignas(DTU_PKG_SIZE) unsigned char _msg[MSG_SIZE];
+    };
+
     static Syscalls &get() {
         return _inst;
     }
@@ -69,6 +184,16 @@ public:
     Errors::Code reqmemat(capsel_t cap, uintptr_t addr, size_t size, int perms);
     Errors::Code derivemem(capsel_t src, capsel_t dst, size_t offset, size_t size, int perms);
     Errors::Code revoke(const CapRngDesc &crd, bool own = true);
+    // returns as soon as the local part is done. if <pending> is set to true, the kernel sends
+    // <event> with <label> to the receive buffer at <ep> once the revocation has finished
+    // (see Revoker)
+    Errors::Code revokeasync(const CapRngDesc &crd, size_t ep, label_t label, word_t event,
+        bool *pending, bool own = true);
+    // registers the memory at <mem> as the syscall ring with <slots> entries (see SyscallRing).
+    // KIF::INV_SEL as <mem> removes the ring.
+    Errors::Code setupring(capsel_t mem, size_t slots);
+    // lets the kernel execute the syscalls in the ring and returns the number of completed ones
+    Errors::Code doorbell(size_t *completed);
     void exit(int exitcode);
     void noop();
 
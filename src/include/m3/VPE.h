@@ -26,6 +26,7 @@
 
 #include <m3/com/MemGate.h>
 #include <m3/ObjCap.h>
+#include <m3/Syscalls.h>
 
 #include <functional>
 
@@ -119,6 +120,7 @@ public:
 
     /**
      * Lets this VPE obtain all capabilities that are necessary for the current mountspace.
+     * The capabilities are delegated in batches (see Syscalls::Batch).
      */
     void obtain_mountspace();
 
@@ -139,6 +141,7 @@ public:
 
     /**
      * Lets this VPE obtain all capabilities that are necessary for the current file descriptors.
+     * The capabilities are delegated in batches (see Syscalls::Batch).
      */
     void obtain_fds();
 
@@ -280,6 +283,8 @@ private:
     void init();
     void init_state();
     void init_fs();
+    // collects the delegations of <func> in one batch syscall
+    void delegate_batched(const std::function<void()> &func);
     Errors::Code run(void *lambda);
     Errors::Code load_segment(Executable &exec, ElfPh &pheader, char *buffer);
     Errors::Code load(Executable &exec, uintptr_t *entry, char *buffer, size_t *size);
@@ -298,6 +303,7 @@ private:
     Pager *_pager;
     MountSpace *_ms;
     FileTable *_fds;
+    Syscalls::Batch *_batch;
     static VPE _self;
 };
 
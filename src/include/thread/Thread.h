@@ -38,18 +38,38 @@ class Thread : public SListItem {
     static constexpr size_t T_STACK_WORDS   = m3::T_STACK_WORDS;
     static constexpr size_t T_STACK_SZ      = T_STACK_WORDS * sizeof(word_t);
     static constexpr size_t MAX_MSG_SIZE    = 1024;
+    // the number of stacks that are allocated at once
+    static constexpr size_t STACK_SLAB      = 8;
+
+    /**
+     * The subscription of a blocked thread for one event. The ThreadManager chains all waiters for
+     * the same event, so that a thread can leave a chain in constant time.
+     */
+    struct Waiter {
+        Thread *thread;
+        void *event;
+        Waiter *prev;
+        Waiter *next;
+    };
 
 public:
     typedef _thread_func thread_func;
 
+    // the maximum number of events a thread can wait for at once
+    static constexpr size_t MAX_EVENTS      = 4;
+
     explicit Thread(thread_func func, void *arg);
     ~Thread();
 
 private:
     explicit Thread()
-        : _id(_next_id++), _regs(), _stack(), _event(nullptr), _content(false) {
+        : _id(_next_id++), _regs(), _stack(), _event(nullptr), _waiters(), _wait_count(0),
+          _pooled(false), _content(false) {
     }
 
+    static word_t *alloc_stack();
+    static void free_stack(word_t *stack);
+
     bool save() {
         return thread_save(&_regs);
     }
@@ -57,13 +77,6 @@ private:
         return thread_resume(&_regs);
     }
 
-    void subscribe(void *event) {
-        _event = event;
-    }
-    void unsubscribe(void *event) {
-        if(_event == event)
-            _event = nullptr;
-    }
     void set_msg(void *msg, size_t size) {
         _content = msg != nullptr;
         if(msg)
@@ -77,8 +90,11 @@ public:
     const Regs &regs() const {
         return _regs;
     }
-    inline bool trigger_event(void* event) const {
-        return _event == event;
+    /**
+     * @return true if the thread waits for an event
+     */
+    bool blocked() const {
+        return _wait_count > 0;
     }
     const unsigned char *get_msg() const {
         return _content ? _msg : nullptr;
@@ -88,10 +104,17 @@ private:
     int _id;
     Regs _regs;
     word_t *_stack;
+    // the event that woke the thread up
     void* _event;
+    Waiter _waiters[MAX_EVENTS];
+    size_t _wait_count;
+    // whether the thread has been created by the pool and can be destroyed when idle
+    bool _pooled;
     bool _content;
     unsigned char _msg[MAX_MSG_SIZE];
     static int _next_id;
+    // stacks of destroyed threads; the first word links them
+    static word_t *_free_stacks;
 };
 
 }
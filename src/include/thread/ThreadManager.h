@@ -21,10 +21,19 @@
 
 #include <thread/Thread.h>
 
+#include <base/col/HashTable.h>
 #include <base/log/Lib.h>
 
 namespace m3 {
 
+/**
+ * Schedules the threads cooperatively. Blocked threads wait for events, which are arbitrary
+ * pointers. The waiting threads are kept in a hash table, indexed by the event, so that notify
+ * does not depend on the total number of blocked threads.
+ *
+ * Optionally, the ThreadManager maintains a pool of threads that grows on demand: if a thread
+ * blocks and no other thread can run, a new one is created (see set_pool).
+ */
 class ThreadManager {
     friend class Thread;
 
@@ -37,29 +46,67 @@ public:
         return _current;
     }
     size_t thread_count() const {
-        return _ready.length() + _blocked.length() + _sleep.length();
+        return _ready.length() + _blocked + _sleep.length();
     }
     size_t ready_count() const {
         return _ready.length();
     }
+    size_t blocked_count() const {
+        return _blocked;
+    }
     size_t sleeping_count() const {
         return _sleep.length();
     }
+    size_t pooled_count() const {
+        return _pooled;
+    }
+    /**
+     * @return the maximum number of threads that have been blocked at the same time
+     */
+    size_t peak_blocked() const {
+        return _peak_blocked;
+    }
+    /**
+     * @return the number of threads that the pool has created so far
+     */
+    size_t spawned() const {
+        return _spawned;
+    }
+
+    /**
+     * Lets the pool create threads that execute <func>(<arg>) whenever the current thread blocks
+     * and no other thread is ready or sleeping, as long as there are less than <max> threads. The
+     * function may only yield at points at which the thread can be destroyed (see shrink).
+     */
+    void set_pool(Thread::thread_func func, void *arg, size_t max) {
+        _pool_func = func;
+        _pool_arg = arg;
+        _pool_max = max;
+    }
+    /**
+     * Destroys the sleeping threads that have been created by the pool. Their stacks are kept for
+     * later threads.
+     *
+     * @return the number of destroyed threads
+     */
+    size_t shrink();
     const unsigned char *get_current_msg() const {
         return _current->get_msg();
     }
 
     void wait_for(void *event) {
-        assert(_sleep.length() > 0);
-        _current->subscribe(event);
-        _blocked.append(_current);
-        LLOG(THREAD, "Thread " << _current->id() << " waits for " << event);
-        if(_ready.length())
-            switch_to(_ready.remove_first());
-        else
-            switch_to(_sleep.remove_first());
+        wait_for_any(&event, 1);
     }
 
+    /**
+     * Blocks the current thread until one of the given events is notified.
+     *
+     * @param events the events (at most Thread::MAX_EVENTS)
+     * @param count the number of events
+     * @return the event that has been notified
+     */
+    void *wait_for_any(void *const *events, size_t count);
+
     void yield() {
         if(_ready.length()) {
             _sleep.insert(nullptr, _current);
@@ -67,43 +114,43 @@ public:
         }
     }
 
-    void notify(void *event, void *msg = nullptr, size_t size = 0) {
-        assert(size <= Thread::MAX_MSG_SIZE);
-        for(auto it = _blocked.begin(); it != _blocked.end(); ) {
-            auto old = it++;
-            if(old->trigger_event(event)) {
-                Thread* t = &(*old);
-                t->set_msg(msg, size);
-                LLOG(THREAD, "Waking up thread " << t->id() << " for event " << event);
-                _blocked.remove(t);
-                _ready.append(t);
-            }
-        }
-    }
+    /**
+     * Wakes up all threads that wait for <event> in the order they started to wait. They receive a
+     * copy of <msg>.
+     */
+    void notify(void *event, void *msg = nullptr, size_t size = 0);
 
     void stop() {
-        assert(_sleep.length() > 0 || _ready.length() > 0);
         LLOG(THREAD, "Stopping thread " << _current->id());
-        if(_ready.length())
-            switch_to(_ready.remove_first());
-        else
-            switch_to(_sleep.remove_first());
+        switch_next();
     }
 
 private:
-    explicit ThreadManager() : _current(), _ready(), _blocked(), _sleep() {
+    explicit ThreadManager()
+        : _current(), _ready(), _waiting(), _blocked(), _sleep(), _pool_func(), _pool_arg(),
+          _pool_max(), _pooled(), _peak_blocked(), _spawned() {
         _current = new Thread();
     }
 
+    static uintptr_t key(void *event) {
+        return reinterpret_cast<uintptr_t>(event);
+    }
+
     void add(Thread *t) {
         _sleep.append(t);
     }
     void remove(Thread *t) {
         _ready.remove(t);
-        _blocked.remove(t);
+        if(t->blocked())
+            unblock(t, nullptr);
         _sleep.remove(t);
     }
 
+    // removes all subscriptions of <t>, except <skip>, from the wait table
+    void unblock(Thread *t, Thread::Waiter *skip);
+    // switches to the next ready or sleeping thread, which is created if necessary
+    void switch_next();
+
     void switch_to(Thread *t) {
         LLOG(THREAD, "Switching from " << _current->id() << " to " << t->id());
         if(!_current->save()) {
@@ -114,8 +161,16 @@ private:
 
     Thread *_current;
     m3::SList<Thread> _ready;
-    m3::SList<Thread> _blocked;
+    // the first waiter for every event
+    m3::HashTable<uintptr_t, Thread::Waiter> _waiting;
+    size_t _blocked;
     m3::SList<Thread> _sleep;
+    Thread::thread_func _pool_func;
+    void *_pool_arg;
+    size_t _pool_max;
+    size_t _pooled;
+    size_t _peak_blocked;
+    size_t _spawned;
     static ThreadManager inst;
 };
 
@@ -34,11 +34,160 @@ namespace m3 {
  * followed by the data. If the area is used, i.e. not free, the MSB in the next field is set.
  * If there is no previous, prev is 0 and if there is is no next, a + a->next will point beyond
  * HEAP_END.
+ *
+ * Unless HEAP_COMPACT is defined, the free areas are additionally kept in segregated lists (TLSF).
+ * Every list holds the free areas of one size class; the classes split every power of two into
+ * SL_COUNT parts. The links are stored in the data part of the free areas. Two levels of bitmaps
+ * tell which lists are non-empty, so that a suitable area is found with two bit scans. To that
+ * end, the requested size is rounded up to the next class, so that every area in the found list
+ * is large enough.
  */
 
 bool Heap::_ready = false;
 Heap::Area *Heap::_begin;
 Heap::Area *Heap::_end;
+#if !defined(HEAP_COMPACT)
+word_t Heap::_fl_bitmap;
+uint32_t Heap::_sl_bitmap[FL_COUNT];
+Heap::Area *Heap::_free[FL_COUNT][SL_COUNT];
+size_t Heap::_free_bytes;
+
+static inline size_t log2_floor(size_t size) {
+    return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(size);
+}
+
+void Heap::size_class(size_t size, size_t *fl, size_t *sl) {
+    if(size < SMALL_SIZE) {
+        *fl = 0;
+        *sl = size >> ALIGN_BITS;
+    }
+    else {
+        size_t log = log2_floor(size);
+        *fl = log - (SL_BITS + ALIGN_BITS) + 1;
+        *sl = (size >> (log - SL_BITS)) - SL_COUNT;
+        if(*fl >= FL_COUNT) {
+            *fl = FL_COUNT - 1;
+            *sl = SL_COUNT - 1;
+        }
+    }
+}
+
+void Heap::insert_free(Area *a) {
+    size_t fl, sl;
+    size_class(a->next, &fl, &sl);
+    FreeLinks *l = links(a);
+    l->prev = nullptr;
+    l->next = _free[fl][sl];
+    if(l->next)
+        links(l->next)->prev = a;
+    _free[fl][sl] = a;
+    _fl_bitmap |= static_cast<word_t>(1) << fl;
+    _sl_bitmap[fl] |= 1U << sl;
+    _free_bytes += a->next;
+}
+
+void Heap::remove_free(Area *a) {
+    size_t fl, sl;
+    size_class(a->next, &fl, &sl);
+    FreeLinks *l = links(a);
+    if(l->next)
+        links(l->next)->prev = l->prev;
+    if(l->prev)
+        links(l->prev)->next = l->next;
+    else {
+        _free[fl][sl] = l->next;
+        if(!l->next) {
+            _sl_bitmap[fl] &= ~(1U << sl);
+            if(!_sl_bitmap[fl])
+                _fl_bitmap &= ~(static_cast<word_t>(1) << fl);
+        }
+    }
+    _free_bytes -= a->next;
+}
+
+Heap::Area *Heap::find_free(size_t size) {
+    // round up to the next class; all areas in that class and above are large enough
+    size_t fl, sl;
+    size_t rsize = size;
+    if(size >= SMALL_SIZE)
+        rsize += (static_cast<size_t>(1) << (log2_floor(size) - SL_BITS)) - 1;
+    size_class(rsize, &fl, &sl);
+
+    uint32_t slmap = _sl_bitmap[fl] & (~0U << sl);
+    if(!slmap) {
+        word_t flmap = _fl_bitmap & (~static_cast<word_t>(0) << (fl + 1));
+        if(flmap) {
+            fl = __builtin_ctzl(flmap);
+            slmap = _sl_bitmap[fl];
+        }
+    }
+    if(slmap) {
+        Area *a = _free[fl][__builtin_ctzl(slmap)];
+        // only the last class contains areas of different powers of two
+        while(a && a->next < size)
+            a = links(a)->next;
+        if(a)
+            return a;
+    }
+
+    // as a last resort, look for a fitting area in the class of <size> itself
+    size_class(size, &fl, &sl);
+    for(Area *a = _free[fl][sl]; a; a = links(a)->next) {
+        if(a->next >= size)
+            return a;
+    }
+    return nullptr;
+}
+#else
+Heap::Area *Heap::find_free(size_t size) {
+    // find free area with enough space; start at the end, i.e. the large chunk of free memory
+    Area *a = backwards(_end, _end->prev);
+    do {
+        if(!is_used(a) && a->next >= size)
+            return a;
+        a = backwards(a, a->prev);
+    }
+    while(a->prev > 0);
+    return !is_used(a) && a->next >= size ? a : nullptr;
+}
+#endif
+
+void Heap::split(Area *a, size_t size) {
+    // is there space left? (take care that we need space for an area behind it and that it actually
+    // makes sense to have this free, i.e. that it's >= the minimum size)
+    if(a->next >= size + MIN_AREA) {
+        // put a new area behind us
+        Area *n = forward(a, size);
+        n->next = a->next - size;
+        n->prev = (n - a) * sizeof(Area);
+        // adjust prev of next area, if there is any
+        Area *nn = forward(n, n->next);
+        nn->prev = (nn - n) * sizeof(Area);
+        a->next = size;
+        insert_free(n);
+    }
+}
+
+void Heap::extend(uintptr_t end_addr) {
+    Area *end = reinterpret_cast<Area*>(end_addr) - 1;
+    size_t size = (end - _end) * sizeof(Area);
+    end->next = 0;
+    Area *prev = backwards(_end, _end->prev);
+    // if the last area is used, the old end area becomes a free area in front of us
+    if(is_used(prev)) {
+        end->prev = size;
+        _end->next = size;
+        insert_free(_end);
+    }
+    // otherwise, merge it into the last area
+    else {
+        remove_free(prev);
+        end->prev = _end->prev + size;
+        prev->next += size;
+        insert_free(prev);
+    }
+    _end = end;
+}
 
 void *Heap::alloc(size_t size) {
     void *res = try_alloc(size);
@@ -55,42 +204,17 @@ USED void *Heap::try_alloc(size_t size) {
     if(!_ready)
         init();
 
-    // align it to at least word-size (the fortran-runtime seems to expect that). 8 is even better
-    // because the DTU requires that.
-    size = (size + sizeof(Area) + ALIGN - 1) & ~(ALIGN - 1);
-
-    // find free area with enough space; start at the end, i.e. the large chunk of free memory
-    Area *a = nullptr;
-    while(1) {
-        a = backwards(_end, _end->prev);
-        do {
-            if(!is_used(a) && a->next >= size)
-                break;
-            a = backwards(a, a->prev);
-        }
-        while(a->prev > 0);
-
-        // have we found a suitable area?
-        if(!is_used(a) && a->next >= size)
-            break;
+    size = area_size(size);
 
+    Area *a;
+    while((a = find_free(size)) == nullptr) {
         // ok, try to extend the heap
         if(!env()->backend->extend_heap(size))
             return nullptr;
     }
 
-    // is there space left? (take care that we need space for an area behind it and that it actually
-    // makes sense to have this free, i.e. that it's >= the minimum size)
-    if(a->next >= size + ALIGN) {
-        // put a new area behind us
-        Area *n = forward(a, size);
-        n->next = a->next - size;
-        n->prev = (n - a) * sizeof(Area);
-        // adjust prev of next area, if there is any
-        Area *nn = forward(n, n->next);
-        nn->prev = (nn - n) * sizeof(Area);
-        a->next = size;
-    }
+    remove_free(a);
+    split(a, size);
     // mark used
     a->next |= USED_BIT;
 
@@ -116,12 +240,29 @@ USED void *Heap::realloc(void *p, size_t size) {
     if(!p)
         return alloc(size);
 
+    Area *a = backwards(reinterpret_cast<Area*>(p), sizeof(Area));
+    size_t cur = a->next & ~USED_BIT;
+    size_t need = area_size(size);
+    if(need <= cur)
+        return p;
+
+    /* grow into the next area, if it is free and large enough */
+    Area *n = forward(a, cur);
+    if(n < _end && !is_used(n) && cur + n->next >= need) {
+        remove_free(n);
+        Area *nn = forward(n, n->next);
+        a->next = cur + n->next;
+        nn->prev = a->next;
+        split(a, need);
+        a->next |= USED_BIT;
+        return p;
+    }
+
     /* allocate new area with requested size */
     void *newp = alloc(size);
 
     /* copy old content over and free old area */
-    Area *a = backwards(reinterpret_cast<Area*>(p), sizeof(Area));
-    memcpy(newp, p, (a->next & ~USED_BIT) - sizeof(Area));
+    memcpy(newp, p, cur - sizeof(Area));
     free(p);
     return newp;
 }
@@ -151,6 +292,7 @@ USED void Heap::free(void *p) {
         Area *p = backwards(a, a->prev);
         // is prev already free? then merge it
         if(!is_used(p)) {
+            remove_free(p);
             p->next += a->next;
             // adjust prev of next area
             n->prev = p->next;
@@ -162,11 +304,13 @@ USED void Heap::free(void *p) {
     // is there a next one and is it free?
     if(n < _end && !is_used(n)) {
         Area *nn = forward(n, n->next);
+        remove_free(n);
         // so merge it
         a->next += n->next;
         // adjust prev of next area
         nn->prev = a->next;
     }
+    insert_free(a);
 }
 
 void Heap::print(OStream &os) {
@@ -184,19 +328,34 @@ size_t Heap::contiguous_mem() {
     size_t max = 0;
     if(!_ready)
         init();
+#if !defined(HEAP_COMPACT)
+    // the largest area is in the highest non-empty class
+    if(_fl_bitmap) {
+        size_t fl = sizeof(unsigned long) * 8 - 1 - __builtin_clzl(_fl_bitmap);
+        size_t sl = 31 - __builtin_clz(_sl_bitmap[fl]);
+        for(Area *a = _free[fl][sl]; a; a = links(a)->next) {
+            if(a->next - sizeof(Area) > max)
+                max = a->next - sizeof(Area);
+        }
+    }
+#else
     Area *a = _begin;
     while(a < _end) {
         if(!is_used(a) && a->next - sizeof(Area) > max)
             max = a->next - sizeof(Area);
         a = forward(a, a->next & ~USED_BIT);
     }
+#endif
     return max;
 }
 
 size_t Heap::free_memory() {
-    size_t total = 0;
     if(!_ready)
         init();
+#if !defined(HEAP_COMPACT)
+    return _free_bytes;
+#else
+    size_t total = 0;
     Area *a = _begin;
     while(a < _end) {
         if(!is_used(a))
@@ -204,6 +363,7 @@ size_t Heap::free_memory() {
         a = forward(a, a->next & ~USED_BIT);
     }
     return total;
+#endif
 }
 
 uintptr_t Heap::end() {
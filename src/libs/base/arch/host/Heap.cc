@@ -51,6 +51,7 @@ void Heap::init() {
     Area *a = _begin;
     a->next = (_end - _begin) * sizeof(Area);
     a->prev = 0;
+    insert_free(a);
     _ready = true;
 }
 
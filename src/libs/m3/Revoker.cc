@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>, 
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Lib.h>
+
+#include <m3/com/GateStream.h>
+#include <m3/Revoker.h>
+#include <m3/Syscalls.h>
+#include <m3/VPE.h>
+
+namespace m3 {
+
+Revoker::Revoker()
+    : _rbuf(RecvBuf::create(VPE::self().alloc_ep(), nextlog2<MSG_SIZE * SLOTS>::val,
+                            nextlog2<MSG_SIZE>::val, 0)),
+      _rgate(RecvGate::create(&_rbuf)),
+      _next(),
+      _pending() {
+    // we fetch the completions ourselves
+    _rbuf.disable();
+}
+
+Revoker::~Revoker() {
+    // the kernel must not send completions to a buffer that is gone
+    wait();
+    VPE::self().free_ep(_rbuf.epid());
+}
+
+Errors::Code Revoker::revoke(const CapRngDesc &crd, bool own) {
+    if(_pending == SLOTS)
+        wait_one();
+
+    bool pending;
+    Errors::Code res = Syscalls::get().revokeasync(crd, _rbuf.epid(),
+        reinterpret_cast<label_t>(&_rgate), _next, &pending, own);
+    if(res != Errors::NO_ERROR)
+        return res;
+    if(pending) {
+        LLOG(SYSC, "revoke " << _next << " is in progress");
+        _pending++;
+    }
+    _next++;
+    return Errors::NO_ERROR;
+}
+
+void Revoker::wait() {
+    while(_pending > 0)
+        wait_one();
+}
+
+void Revoker::wait_one() {
+    word_t event;
+    Errors::Code res;
+    receive_vmsg(_rgate, event, res);
+    LLOG(SYSC, "revoke " << event << " finished (" << res << ")");
+    _pending--;
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019, Matthias Hille <matthias.hille@tu-dresden.de>,
+ * Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of SemperOS.
+ *
+ * SemperOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * SemperOS is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Lib.h>
+#include <base/util/Math.h>
+
+#include <m3/Syscalls.h>
+#include <m3/SyscallRing.h>
+
+#include <string.h>
+
+namespace m3 {
+
+SyscallRing::SyscallRing(size_t slots)
+    : _slots(slots),
+      _mem(MemGate::create_global(Ring::size(slots), MemGate::RW)),
+      _sq_head(), _sq_tail(), _cq_head(), _staged(), _cqpos(), _cqcount(),
+      _sqes(new Ring::SQE[slots]),
+      _cqes(new Ring::CQE[slots]) {
+    Ring::Header hd;
+    memset(&hd, 0, sizeof(hd));
+    if(_mem.write_sync(&hd, sizeof(hd), 0) == Errors::NO_ERROR)
+        Syscalls::get().setupring(_mem.sel(), _slots);
+}
+
+SyscallRing::~SyscallRing() {
+    Syscalls::get().setupring(KIF::INV_SEL, 0);
+    delete[] _cqes;
+    delete[] _sqes;
+}
+
+Errors::Code SyscallRing::transfer(uint64_t first, size_t count, bool sq) {
+    // the entries might wrap around at the end of the queue
+    size_t done = 0;
+    while(done < count) {
+        uint64_t idx = first + done;
+        size_t off = idx & (_slots - 1);
+        size_t amount = Math::min(count - done, _slots - off);
+        Errors::Code res;
+        if(sq) {
+            res = _mem.write_sync(_sqes + off, amount * sizeof(Ring::SQE),
+                Ring::sqe_offset(_slots, idx));
+        }
+        else {
+            res = _mem.read_sync(_cqes + done, amount * sizeof(Ring::CQE),
+                Ring::cqe_offset(_slots, idx));
+        }
+        if(res != Errors::NO_ERROR)
+            return res;
+        done += amount;
+    }
+    return Errors::NO_ERROR;
+}
+
+Errors::Code SyscallRing::enter() {
+    _cqpos = _cqcount = 0;
+    if(_sq_tail + _staged == _sq_head)
+        return Errors::NO_ERROR;
+
+    Errors::Code res = transfer(_sq_tail, _staged, true);
+    if(res != Errors::NO_ERROR)
+        return res;
+    _sq_tail += _staged;
+    _staged = 0;
+
+    // publish the new entries and the consumed completions at once
+    uint64_t hd[] = {_sq_tail, _cq_head};
+    res = _mem.write_sync(hd, sizeof(hd), 0);
+    if(res != Errors::NO_ERROR)
+        return res;
+
+    size_t completed;
+    res = Syscalls::get().doorbell(&completed);
+    LLOG(SYSC, "ring: " << completed << " of " << (_sq_tail - _sq_head) << " syscalls completed");
+
+    // the kernel completes the entries in order and we have always room for all of them
+    Errors::Code cqres = transfer(_cq_head, completed, false);
+    _sq_head += completed;
+    _cq_head += completed;
+    _cqcount = completed;
+    return res != Errors::NO_ERROR ? res : cqres;
+}
+
+}
@@ -163,6 +163,78 @@ Errors::Code Syscalls::revoke(const CapRngDesc &crd, bool own) {
     return finish(send_receive_vmsg(_gate, KIF::Syscall::REVOKE, crd, own));
 }
 
+Errors::Code Syscalls::revokeasync(const CapRngDesc &crd, size_t ep, label_t label, word_t event,
+        bool *pending, bool own) {
+    LLOG(SYSC, "revokeasync(crd=" << crd << ", ep=" << ep << ", label=" << fmt(label, "#x")
+        << ", event=" << fmt(event, "#x") << ", own=" << own << ")");
+    GateIStream &&reply = send_receive_vmsg(_gate, KIF::Syscall::REVOKEASYNC,
+        crd, own, ep, label, event);
+    if(reply.error())
+        return reply.error();
+    reply >> Errors::last;
+    if(Errors::last == Errors::NO_ERROR)
+        reply >> *pending;
+    return Errors::last;
+}
+
+Errors::Code Syscalls::setupring(capsel_t mem, size_t slots) {
+    LLOG(SYSC, "setupring(mem=" << mem << ", slots=" << slots << ")");
+    return finish(send_receive_vmsg(_gate, KIF::Syscall::SETUPRING, mem, slots));
+}
+
+Errors::Code Syscalls::doorbell(size_t *completed) {
+    LLOG(SYSC, "doorbell()");
+    GateIStream &&reply = send_receive_vmsg(_gate, KIF::Syscall::DOORBELL);
+    if(reply.error())
+        return reply.error();
+    reply >> Errors::last;
+    // if the ring failed, some syscalls might have been completed nevertheless
+    *completed = 0;
+    if(reply.remaining() > 0)
+        reply >> *completed;
+    return Errors::last;
+}
+
+Syscalls::Batch::Batch(bool stop_on_error)
+    : _stop(stop_on_error), _error(Errors::NO_ERROR), _count(), _executed(), _ops(),
+      _pos(HEADER_SIZE), _results() {
+}
+
+Syscalls::Batch::~Batch() {
+    delete[] _results;
+}
+
+Errors::Code Syscalls::Batch::run() {
+    if(_ops == 0)
+        return Errors::last = _error;
+
+    LLOG(SYSC, "batch(count=" << _ops << ", stop=" << _stop << ")");
+    Marshaller hd(_msg, HEADER_SIZE);
+    hd << KIF::Syscall::BATCH << _ops << _stop;
+    GateIStream &&reply = send_receive_msg(Syscalls::get()._gate, _msg, _pos);
+
+    Errors::Code res = reply.error();
+    size_t done = 0;
+    if(res == Errors::NO_ERROR)
+        reply >> res >> done;
+
+    // keep the results of the previous messages of this batch
+    Errors::Code *nresults = new Errors::Code[_executed + done];
+    for(size_t i = 0; i < _executed; ++i)
+        nresults[i] = _results[i];
+    for(size_t i = 0; i < done; ++i)
+        reply >> nresults[_executed + i];
+    delete[] _results;
+    _results = nresults;
+    _executed += done;
+
+    if(_error == Errors::NO_ERROR)
+        _error = res;
+    _ops = 0;
+    _pos = HEADER_SIZE;
+    return Errors::last = _error;
+}
+
 // the USED seems to be necessary, because the libc calls it and LTO removes it otherwise
 USED void Syscalls::exit(int exitcode) {
     LLOG(SYSC, "exit(code=" << exitcode << ")");
@@ -36,7 +36,7 @@ INIT_PRIO_VPE VPE VPE::_self;
 // don't revoke these. they kernel does so on exit
 VPE::VPE()
     : ObjCap(VIRTPE, 0, KEEP_SEL | KEEP_CAP), _pe(env()->pe),
-      _mem(MemGate::bind(1)), _caps(), _eps(), _pager(), _ms(), _fds() {
+      _mem(MemGate::bind(1)), _caps(), _eps(), _pager(), _ms(), _fds(), _batch() {
     init_state();
     init();
     init_fs();
@@ -59,7 +59,7 @@ VPE::VPE(const String &name, const PEDesc &pe, const char *pager)
         : ObjCap(VIRTPE, VPE::self().alloc_caps(2)),
           _pe(pe), _mem(MemGate::bind(sel() + 1, 0)),
           _caps(new BitField<SEL_TOTAL>()), _eps(new BitField<EP_COUNT>()),
-          _pager(), _ms(new MountSpace()), _fds(new FileTable()) {
+          _pager(), _ms(new MountSpace()), _fds(new FileTable()), _batch() {
     init();
 
     // create pager first, to create session and obtain gate cap
@@ -150,7 +150,9 @@ void VPE::mountspace(const MountSpace &ms) {
 }
 
 void VPE::obtain_mountspace() {
-    _ms->delegate(*this);
+    delegate_batched([this] {
+        _ms->delegate(*this);
+    });
 }
 
 void VPE::fds(const FileTable &fds) {
@@ -159,11 +161,25 @@ void VPE::fds(const FileTable &fds) {
 }
 
 void VPE::obtain_fds() {
-    _fds->delegate(*this);
+    delegate_batched([this] {
+        _fds->delegate(*this);
+    });
+}
+
+void VPE::delegate_batched(const std::function<void()> &func) {
+    // the delegations are independent of each other, so that we don't stop on errors
+    Syscalls::Batch batch(false);
+    _batch = &batch;
+    func();
+    _batch = nullptr;
+    batch.run();
 }
 
 void VPE::delegate(const CapRngDesc &crd) {
-    Syscalls::get().exchange(sel(), crd, crd, false);
+    if(_batch)
+        _batch->exchange(sel(), crd, crd, false);
+    else
+        Syscalls::get().exchange(sel(), crd, crd, false);
     for(capsel_t sel = crd.start(); sel != crd.start() + crd.count(); ++sel) {
         if(!VPE::self().is_cap_free(sel))
             _caps->set(sel);
@@ -19,16 +19,23 @@
 #include <m3/pipe/DirectPipeReader.h>
 #include <m3/pipe/DirectPipeWriter.h>
 #include <m3/vfs/FileTable.h>
+#include <m3/Syscalls.h>
 
 namespace m3 {
 
 DirectPipe::DirectPipe(VPE &rd, VPE &wr, size_t size)
     : _rd(rd), _wr(wr), _recvep(rd.alloc_ep()), _size(size),
-      _mem(MemGate::create_global(size, MemGate::RW, VPE::self().alloc_caps(2))),
-      _sgate(SendGate::create_for(rd, _recvep, 0, CREDITS, nullptr, _mem.sel() + 1)),
+      _mem(MemGate::bind(VPE::self().alloc_caps(2), ObjCap::KEEP_SEL)),
+      _sgate(SendGate::bind(_mem.sel() + 1, nullptr, ObjCap::KEEP_SEL)),
       _rdfd(), _wrfd() {
     assert(Math::is_aligned(size, DTU_PKG_SIZE));
 
+    // create the memory and the gate with a single syscall
+    Syscalls::Batch batch;
+    batch.reqmem(_mem.sel(), size, MemGate::RW);
+    batch.creategate(rd.sel(), _sgate.sel(), 0, _recvep, CREDITS);
+    batch.run();
+
     DirectPipeReader::State *rstate = &rd == &VPE::self() ? new DirectPipeReader::State(caps(), _recvep) : nullptr;
     _rdfd = VPE::self().fds()->alloc(new DirectPipeReader(caps(), _recvep, rstate));
 
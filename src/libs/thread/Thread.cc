@@ -25,14 +25,32 @@
 namespace m3 {
 
 int Thread::_next_id = 1;
+word_t *Thread::_free_stacks = nullptr;
+
+word_t *Thread::alloc_stack() {
+    if(!_free_stacks) {
+        // stacks are never given back to the heap, because threads come and go with the load
+        word_t *slab = reinterpret_cast<word_t*>(m3::Heap::alloc(T_STACK_SZ * STACK_SLAB));
+        for(size_t i = 0; i < STACK_SLAB; ++i)
+            free_stack(slab + i * T_STACK_WORDS);
+    }
+
+    word_t *stack = _free_stacks;
+    _free_stacks = reinterpret_cast<word_t*>(stack[0]);
+    return stack;
+}
+
+void Thread::free_stack(word_t *stack) {
+    stack[0] = reinterpret_cast<word_t>(_free_stacks);
+    _free_stacks = stack;
+}
 
 Thread::Thread(thread_func func, void *arg)
-        : _id(_next_id++), _regs(), _stack(), _event(nullptr) {
+        : _id(_next_id++), _regs(), _stack(), _event(nullptr), _waiters(), _wait_count(0),
+          _pooled(false), _content(false) {
     // TODO
     // better leave one page before and behind each stack free to detect stack-under-/overflows
-    void* addr = m3::Heap::alloc(T_STACK_SZ);
-
-    _stack = reinterpret_cast<word_t*>(reinterpret_cast<uintptr_t>(addr));
+    _stack = alloc_stack();
     thread_init(func, arg, &_regs, _stack);
     ThreadManager::get().add(this);
 }
@@ -40,7 +58,7 @@ Thread::Thread(thread_func func, void *arg)
 Thread::~Thread() {
     ThreadManager::get().remove(this);
     if(_stack)
-        m3::Heap::free(_stack);
+        free_stack(_stack);
 }
 
 }
@@ -21,4 +21,106 @@ namespace m3 {
 
 ThreadManager ThreadManager::inst;
 
+void *ThreadManager::wait_for_any(void *const *events, size_t count) {
+    assert(count > 0 && count <= Thread::MAX_EVENTS);
+    for(size_t i = 0; i < count; ++i) {
+        // new waiters are prepended; notify restores the order
+        Thread::Waiter *w = _current->_waiters + i;
+        w->thread = _current;
+        w->event = events[i];
+        w->prev = nullptr;
+        w->next = _waiting.find(key(events[i]));
+        if(w->next)
+            w->next->prev = w;
+        _waiting.insert(key(events[i]), w);
+        LLOG(THREAD, "Thread " << _current->id() << " waits for " << events[i]);
+    }
+    _current->_wait_count = count;
+    if(++_blocked > _peak_blocked)
+        _peak_blocked = _blocked;
+
+    switch_next();
+    // we're running again
+    return _current->_event;
+}
+
+void ThreadManager::notify(void *event, void *msg, size_t size) {
+    assert(size <= Thread::MAX_MSG_SIZE);
+    Thread::Waiter *w = _waiting.remove(key(event));
+
+    // reverse the chain to wake up the threads in the order they started to wait
+    Thread::Waiter *first = nullptr;
+    while(w) {
+        Thread::Waiter *next = w->next;
+        w->next = first;
+        first = w;
+        w = next;
+    }
+
+    for(w = first; w; ) {
+        Thread::Waiter *next = w->next;
+        Thread *t = w->thread;
+        // a thread might wait multiple times for the same event
+        if(t->blocked()) {
+            unblock(t, w);
+            t->_event = event;
+            t->set_msg(msg, size);
+            LLOG(THREAD, "Waking up thread " << t->id() << " for event " << event);
+            _ready.append(t);
+        }
+        w = next;
+    }
+}
+
+size_t ThreadManager::shrink() {
+    size_t destroyed = 0;
+    for(auto it = _sleep.begin(); _pooled > 0 && it != _sleep.end(); ) {
+        Thread *t = &*it++;
+        if(t->_pooled) {
+            LLOG(THREAD, "Destroying idle thread " << t->id());
+            _pooled--;
+            delete t;
+            destroyed++;
+        }
+    }
+    return destroyed;
+}
+
+void ThreadManager::switch_next() {
+    if(!_ready.length() && !_sleep.length() && _pool_func && thread_count() < _pool_max) {
+        // the new thread is added to the sleeping ones
+        Thread *t = new Thread(_pool_func, _pool_arg);
+        t->_pooled = true;
+        _pooled++;
+        _spawned++;
+        LLOG(THREAD, "Created thread " << t->id() << " (" << thread_count() << " threads)");
+    }
+
+    assert(_ready.length() > 0 || _sleep.length() > 0);
+    if(_ready.length())
+        switch_to(_ready.remove_first());
+    else
+        switch_to(_sleep.remove_first());
+}
+
+void ThreadManager::unblock(Thread *t, Thread::Waiter *skip) {
+    for(size_t i = 0; i < t->_wait_count; ++i) {
+        Thread::Waiter *w = t->_waiters + i;
+        // the chain of the notified event has already been taken out of the table
+        if(skip && w->event == skip->event)
+            continue;
+
+        if(w->next)
+            w->next->prev = w->prev;
+        if(w->prev)
+            w->prev->next = w->next;
+        else if(w->next)
+            _waiting.insert(key(w->event), w->next);
+        else
+            _waiting.remove(key(w->event));
+    }
+    t->_wait_count = 0;
+    _blocked--;
+}
+
 }